@@ -0,0 +1,108 @@
+/* Per symbol index of trade-free time periods.
+ */
+
+#include "activity_index.hh"
+
+#include <algorithm>
+
+#include "chromium/logging.hh"
+
+__time32_t
+gomi::activity_index_t::GetQuietTill (
+	const char* symbol_name,
+	__time32_t timestamp
+	) const
+{
+	boost::shared_lock<boost::shared_mutex> lock (lock_);
+	auto it = symbols_.find (symbol_name);
+	if (symbols_.end() == it)
+		return timestamp;
+	const auto& periods = it->second;
+	auto jt = periods.upper_bound (timestamp);
+	if (periods.begin() == jt)
+		return timestamp;
+	--jt;
+	return std::max (timestamp, jt->second);
+}
+
+/* Merge with overlapping or adjacent time periods.
+ */
+void
+gomi::activity_index_t::SetQuiet (
+	const char* symbol_name,
+	const time_window_t& window
+	)
+{
+	if (window.first >= window.second)
+		return;
+	__time32_t from = window.first, till = window.second;
+	boost::unique_lock<boost::shared_mutex> lock (lock_);
+	auto& periods = symbols_[symbol_name];
+	auto it = periods.upper_bound (from);
+	if (periods.begin() != it) {
+		auto prev = it;
+		--prev;
+		if (prev->second >= from) {
+			from = prev->first;
+			till = std::max (till, prev->second);
+			it = prev;
+		}
+	}
+	while (periods.end() != it && it->first <= till) {
+		till = std::max (till, it->second);
+		it = periods.erase (it);
+	}
+	periods[from] = till;
+	DVLOG(4) << symbol_name << " quiet from " << from << " till " << till;
+}
+
+void
+gomi::activity_index_t::Forget (
+	const char* symbol_name,
+	const time_window_t& window
+	)
+{
+	boost::unique_lock<boost::shared_mutex> lock (lock_);
+	auto it = symbols_.find (symbol_name);
+	if (symbols_.end() == it)
+		return;
+	auto& periods = it->second;
+	for (auto jt = periods.begin(); jt != periods.end();) {
+		if (jt->first < window.second && window.first < jt->second)
+			jt = periods.erase (jt);
+		else
+			++jt;
+	}
+	if (periods.empty())
+		symbols_.erase (it);
+}
+
+void
+gomi::activity_index_t::Expire (
+	__time32_t timestamp
+	)
+{
+	boost::unique_lock<boost::shared_mutex> lock (lock_);
+	for (auto it = symbols_.begin(); it != symbols_.end();) {
+		auto& periods = it->second;
+		for (auto jt = periods.begin(); jt != periods.end();) {
+			if (jt->second < timestamp)
+				jt = periods.erase (jt);
+			else
+				++jt;
+		}
+		if (periods.empty())
+			it = symbols_.erase (it);
+		else
+			++it;
+	}
+}
+
+size_t
+gomi::activity_index_t::GetSymbolCount() const
+{
+	boost::shared_lock<boost::shared_mutex> lock (lock_);
+	return symbols_.size();
+}
+
+/* eof */
@@ -0,0 +1,54 @@
+/* Per symbol index of trade-free time periods.
+ *
+ * A read returning no trades for a bar proves the time period quiet, later
+ * scans of any bin set fill zero bars for quiet time periods and only read the
+ * remainder of partially quiet ones.  Long tail symbols that rarely trade then
+ * cost one read per new time period rather than one per bin close.
+ */
+
+#ifndef __ACTIVITY_INDEX_HH__
+#define __ACTIVITY_INDEX_HH__
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Boost threading. */
+#include <boost/thread.hpp>
+
+#include "period_table.hh"
+
+namespace gomi
+{
+	class activity_index_t : boost::noncopyable
+	{
+	public:
+/* end of the quiet time period containing /timestamp/, /timestamp/ when unknown */
+		__time32_t GetQuietTill (const char* symbol_name, __time32_t timestamp) const;
+/* record that /symbol_name/ did not trade within /window/ */
+		void SetQuiet (const char* symbol_name, const time_window_t& window);
+/* discard time periods overlapping /window/, trades have since arrived */
+		void Forget (const char* symbol_name, const time_window_t& window);
+/* discard time periods ending before /timestamp/ */
+		void Expire (__time32_t timestamp);
+
+		size_t GetSymbolCount() const;
+
+	private:
+/* disjoint, non-adjacent [from, till) keyed by from */
+		typedef std::map<__time32_t, __time32_t> periods_t;
+
+		std::unordered_map<std::string, periods_t> symbols_;
+		mutable boost::shared_mutex lock_;
+	};
+
+} /* namespace gomi */
+
+#endif /* __ACTIVITY_INDEX_HH__ */
+
+/* eof */
@@ -0,0 +1,128 @@
+/* Activity index unit test of recorded and expired quiet time periods.
+ *
+ * Returns zero on success, non-zero with each failure logged to stderr.
+ */
+
+#include "activity_index.hh"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "unittest.hh"
+
+static const __time32_t kFrom = 1331280000;	/* 2012/03/09 08:00 UTC */
+
+static
+gomi::time_window_t
+window (
+	int from,
+	int till
+	)
+{
+	return gomi::time_window_t (kFrom + from, kFrom + till);
+}
+
+/* Overlapping and adjacent quiet time periods merge, gaps between them and
+ * other symbols stay unknown.
+ */
+static
+void
+test_set_quiet()
+{
+	gomi::activity_index_t index;
+	EXPECT(kFrom == index.GetQuietTill ("A.N", kFrom));
+
+	index.SetQuiet ("A.N", window (0, 100));
+	EXPECT(kFrom + 100 == index.GetQuietTill ("A.N", kFrom));
+	EXPECT(kFrom + 100 == index.GetQuietTill ("A.N", kFrom + 50));
+/* quiet time periods are [from, till) */
+	EXPECT(kFrom + 100 == index.GetQuietTill ("A.N", kFrom + 100));
+	EXPECT(kFrom - 1 == index.GetQuietTill ("A.N", kFrom - 1));
+	EXPECT(kFrom == index.GetQuietTill ("B.N", kFrom));
+
+/* adjacent, overlapping and disjoint */
+	index.SetQuiet ("A.N", window (100, 200));
+	index.SetQuiet ("A.N", window (150, 300));
+	index.SetQuiet ("A.N", window (400, 500));
+	EXPECT(kFrom + 300 == index.GetQuietTill ("A.N", kFrom));
+	EXPECT(kFrom + 350 == index.GetQuietTill ("A.N", kFrom + 350));
+	EXPECT(kFrom + 500 == index.GetQuietTill ("A.N", kFrom + 400));
+
+/* bridging both */
+	index.SetQuiet ("A.N", window (250, 450));
+	EXPECT(kFrom + 500 == index.GetQuietTill ("A.N", kFrom));
+
+/* empty time periods are not recorded */
+	index.SetQuiet ("B.N", window (0, 0));
+	index.SetQuiet ("B.N", window (100, 0));
+	EXPECT(1 == index.GetSymbolCount());
+	EXPECT(kFrom == index.GetQuietTill ("B.N", kFrom));
+}
+
+/* Trades within a quiet time period discard the whole period, other periods
+ * and symbols are kept.
+ */
+static
+void
+test_forget()
+{
+	gomi::activity_index_t index;
+	index.SetQuiet ("A.N", window (0, 100));
+	index.SetQuiet ("A.N", window (200, 300));
+	index.SetQuiet ("B.N", window (0, 100));
+	index.Forget ("A.N", window (250, 251));
+	EXPECT(kFrom + 200 == index.GetQuietTill ("A.N", kFrom + 200));
+	EXPECT(kFrom + 100 == index.GetQuietTill ("A.N", kFrom));
+	EXPECT(kFrom + 100 == index.GetQuietTill ("B.N", kFrom));
+
+/* touching without overlap */
+	index.Forget ("A.N", window (100, 200));
+	EXPECT(kFrom + 100 == index.GetQuietTill ("A.N", kFrom));
+
+	index.Forget ("A.N", window (50, 51));
+	EXPECT(kFrom == index.GetQuietTill ("A.N", kFrom));
+	EXPECT(1 == index.GetSymbolCount());
+	index.Forget ("C.N", window (0, 100));
+	EXPECT(1 == index.GetSymbolCount());
+}
+
+/* Time periods ending before the oldest analytic day are dropped with their
+ * symbols, later periods survive.
+ */
+static
+void
+test_expire()
+{
+	gomi::activity_index_t index;
+	index.SetQuiet ("A.N", window (0, 100));
+	index.SetQuiet ("A.N", window (200, 300));
+	index.SetQuiet ("B.N", window (0, 100));
+	EXPECT(2 == index.GetSymbolCount());
+
+	index.Expire (kFrom + 100);
+	EXPECT(kFrom + 100 == index.GetQuietTill ("A.N", kFrom));
+	EXPECT(2 == index.GetSymbolCount());
+
+	index.Expire (kFrom + 101);
+	EXPECT(kFrom == index.GetQuietTill ("A.N", kFrom));
+	EXPECT(kFrom + 300 == index.GetQuietTill ("A.N", kFrom + 200));
+	EXPECT(kFrom == index.GetQuietTill ("B.N", kFrom));
+	EXPECT(1 == index.GetSymbolCount());
+
+	index.Expire (kFrom + 1000);
+	EXPECT(0 == index.GetSymbolCount());
+}
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	test_set_quiet();
+	test_forget();
+	test_expire();
+	return unittest::Result();
+}
+
+/* eof */
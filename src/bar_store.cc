@@ -0,0 +1,342 @@
+/* Memory mapped store of finished day bars.
+ */
+
+#include "bar_store.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "chromium/logging.hh"
+
+/* File identifier and layout version, increment on any change to the layout. */
+static const char kMagic[8] = { 'G', 'O', 'M', 'I', 'B', 'A', 'R', 'S' };
+static const uint32_t kVersion = 1;
+
+/* Per cell storage in a day block: open, close, moves, volume, present flag. */
+static const size_t kCellSize = sizeof (double) + sizeof (double) + sizeof (uint64_t) + sizeof (uint64_t) + sizeof (uint8_t);
+
+/* http://www.isthe.com/chongo/tech/comp/fnv/ */
+static const uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+static const uint64_t kFnvPrime = 1099511628211ULL;
+
+static
+uint64_t
+fnv1a (
+	uint64_t hash,
+	const std::string& s
+	)
+{
+/* include terminator so that [ "ab", "c" ] differs from [ "a", "bc" ] */
+	for (size_t i = 0; i <= s.size(); ++i) {
+		hash ^= (uint8_t)s.c_str()[i];
+		hash *= kFnvPrime;
+	}
+	return hash;
+}
+
+static
+size_t
+align (
+	size_t n,
+	size_t alignment
+	)
+{
+	return (n + alignment - 1) & ~(alignment - 1);
+}
+
+/* File header, followed by the day directory of /block_count/ day numbers,
+ * zero for an unused block.  Day blocks start at /header_size/.
+ */
+struct gomi::bar_store_t::header_t
+{
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	header_size;
+	uint64_t	fingerprint;
+	uint32_t	symbol_count;
+	uint32_t	bin_count;
+	uint32_t	block_count;
+	uint32_t	reserved;
+	uint64_t	block_size;
+	int32_t		dates[1];
+};
+
+gomi::bar_store_t::bar_store_t() :
+	header_ (nullptr),
+	file_size_ (0)
+{
+}
+
+gomi::bar_store_t::~bar_store_t()
+{
+	Close();
+}
+
+/* Returns true on success, false on failure with the store closed.
+ */
+bool
+gomi::bar_store_t::Open (
+	const std::string& path,
+	const std::vector<std::string>& symbols,
+	const std::vector<std::string>& bin_keys,
+	unsigned block_count
+	)
+{
+	Close();
+
+	if (symbols.empty() || bin_keys.empty() || 0 == block_count) {
+		LOG(ERROR) << "Empty bar store layout.";
+		return false;
+	}
+
+/* layout */
+	uint64_t fingerprint = kFnvOffsetBasis;
+	std::for_each (symbols.begin(), symbols.end(), [&fingerprint](const std::string& symbol) {
+		fingerprint = fnv1a (fingerprint, symbol);
+	});
+	fingerprint = fnv1a (fingerprint, "");
+	std::for_each (bin_keys.begin(), bin_keys.end(), [&fingerprint](const std::string& bin_key) {
+		fingerprint = fnv1a (fingerprint, bin_key);
+	});
+	const size_t cell_count = symbols.size() * bin_keys.size();
+	const size_t header_size = align (offsetof (header_t, dates) + block_count * sizeof (int32_t), 64);
+	const size_t block_size = align (cell_count * kCellSize, 64);
+	const uint64_t file_size = header_size + (uint64_t)block_count * block_size;
+
+	file_.reset (CreateFileA (path.c_str(),
+				  GENERIC_READ | GENERIC_WRITE,
+				  FILE_SHARE_READ,
+				  nullptr,
+				  OPEN_ALWAYS,
+				  FILE_ATTRIBUTE_NORMAL,
+				  nullptr));
+	if (!file_) {
+		LOG(ERROR) << "Failed to open bar store " << path << " error code=" << GetLastError();
+		return false;
+	}
+
+/* resize on any layout change */
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx (file_.get(), &size)) {
+		LOG(ERROR) << "Failed to size bar store " << path << " error code=" << GetLastError();
+		Close();
+		return false;
+	}
+	bool is_valid = ((uint64_t)size.QuadPart == file_size);
+	if (!is_valid) {
+		LARGE_INTEGER end;
+		end.QuadPart = file_size;
+		if (!SetFilePointerEx (file_.get(), end, nullptr, FILE_BEGIN) ||
+		    !SetEndOfFile (file_.get()))
+		{
+			LOG(ERROR) << "Failed to resize bar store " << path << " error code=" << GetLastError();
+			Close();
+			return false;
+		}
+	}
+
+	mapping_.reset (CreateFileMapping (file_.get(), nullptr, PAGE_READWRITE, (DWORD)(file_size >> 32), (DWORD)file_size, nullptr));
+	if (!mapping_) {
+		LOG(ERROR) << "Failed to map bar store " << path << " error code=" << GetLastError();
+		Close();
+		return false;
+	}
+	view_.reset (MapViewOfFile (mapping_.get(), FILE_MAP_ALL_ACCESS, 0, 0, 0));
+	if (!view_) {
+		LOG(ERROR) << "Failed to view bar store " << path << " error code=" << GetLastError();
+		Close();
+		return false;
+	}
+	header_ = static_cast<header_t*> (view_.get());
+	file_size_ = (size_t)file_size;
+
+	if (is_valid) {
+		is_valid = (0 == memcmp (header_->magic, kMagic, sizeof (kMagic)) &&
+			    kVersion == header_->version &&
+			    header_size == header_->header_size &&
+			    fingerprint == header_->fingerprint &&
+			    symbols.size() == header_->symbol_count &&
+			    bin_keys.size() == header_->bin_count &&
+			    block_count == header_->block_count &&
+			    block_size == header_->block_size);
+	}
+
+	if (!is_valid) {
+		LOG(WARNING) << "Bar store " << path << " layout changed, discarding stored bars.";
+		ZeroMemory (view_.get(), file_size_);
+		header_->version      = kVersion;
+		header_->header_size  = (uint32_t)header_size;
+		header_->fingerprint  = fingerprint;
+		header_->symbol_count = (uint32_t)symbols.size();
+		header_->bin_count    = (uint32_t)bin_keys.size();
+		header_->block_count  = block_count;
+		header_->block_size   = block_size;
+/* magic last, partially written header is invalid */
+		memcpy (header_->magic, kMagic, sizeof (kMagic));
+		Flush();
+	}
+
+	unsigned day_count = 0;
+	for (unsigned k = 0; k < header_->block_count; ++k)
+		if (0 != header_->dates[k])
+			++day_count;
+	LOG(INFO) << "Bar store: { "
+		  "\"path\": \"" << path << "\""
+		", \"version\": " << header_->version <<
+		", \"symbols\": " << header_->symbol_count <<
+		", \"bins\": " << header_->bin_count <<
+		", \"blocks\": " << header_->block_count <<
+		", \"days\": " << day_count <<
+		", \"size\": " << file_size_ <<
+		" }";
+	return true;
+}
+
+void
+gomi::bar_store_t::Close()
+{
+	header_ = nullptr;
+	file_size_ = 0;
+	view_.reset();
+	mapping_.reset();
+	file_.reset();
+}
+
+int
+gomi::bar_store_t::FindDay (
+	const boost::gregorian::date& date
+	) const
+{
+	DCHECK(IsOpen());
+	const int32_t day_number = (int32_t)date.day_number();
+	for (unsigned k = 0; k < header_->block_count; ++k)
+		if (day_number == header_->dates[k])
+			return (int)k;
+	return -1;
+}
+
+int
+gomi::bar_store_t::AppendDay (
+	const boost::gregorian::date& date
+	)
+{
+	DCHECK(IsOpen());
+	const int block = FindDay (date);
+	if (-1 != block)
+		return block;
+/* unused or oldest day */
+	unsigned k = 0;
+	for (unsigned l = 1; l < header_->block_count; ++l)
+		if (header_->dates[l] < header_->dates[k])
+			k = l;
+/* mark all cells absent before taking the block */
+	const size_t cell_count = (size_t)header_->symbol_count * header_->bin_count;
+	uint8_t* present = GetBlock (k) + cell_count * (kCellSize - sizeof (uint8_t));
+	ZeroMemory (present, cell_count);
+	header_->dates[k] = (int32_t)date.day_number();
+	return (int)k;
+}
+
+/* Returns false if the bar has not been stored.
+ */
+bool
+gomi::bar_store_t::Read (
+	int block,
+	unsigned symbol,
+	unsigned bin,
+	stored_bar_t* bar
+	) const
+{
+	DCHECK(IsOpen());
+	DCHECK(block >= 0 && (unsigned)block < header_->block_count);
+	const size_t cell_count = (size_t)header_->symbol_count * header_->bin_count;
+	const size_t i = CellIndex (symbol, bin);
+	const uint8_t* p = GetBlock (block);
+	const double* open_price = reinterpret_cast<const double*> (p);
+	const double* close_price = open_price + cell_count;
+	const uint64_t* number_moves = reinterpret_cast<const uint64_t*> (close_price + cell_count);
+	const uint64_t* accumulated_volume = number_moves + cell_count;
+	const uint8_t* present = reinterpret_cast<const uint8_t*> (accumulated_volume + cell_count);
+	if (0 == present[i])
+		return false;
+	bar->open_price = open_price[i];
+	bar->close_price = close_price[i];
+	bar->number_moves = number_moves[i];
+	bar->accumulated_volume = accumulated_volume[i];
+	return true;
+}
+
+void
+gomi::bar_store_t::Write (
+	int block,
+	unsigned symbol,
+	unsigned bin,
+	const stored_bar_t& bar
+	)
+{
+	DCHECK(IsOpen());
+	DCHECK(block >= 0 && (unsigned)block < header_->block_count);
+	const size_t cell_count = (size_t)header_->symbol_count * header_->bin_count;
+	const size_t i = CellIndex (symbol, bin);
+	uint8_t* p = GetBlock (block);
+	double* open_price = reinterpret_cast<double*> (p);
+	double* close_price = open_price + cell_count;
+	uint64_t* number_moves = reinterpret_cast<uint64_t*> (close_price + cell_count);
+	uint64_t* accumulated_volume = number_moves + cell_count;
+	uint8_t* present = reinterpret_cast<uint8_t*> (accumulated_volume + cell_count);
+	open_price[i] = bar.open_price;
+	close_price[i] = bar.close_price;
+	number_moves[i] = bar.number_moves;
+	accumulated_volume[i] = bar.accumulated_volume;
+	present[i] = 1;
+}
+
+void
+gomi::bar_store_t::Erase (
+	int block,
+	unsigned symbol,
+	unsigned bin
+	)
+{
+	DCHECK(IsOpen());
+	DCHECK(block >= 0 && (unsigned)block < header_->block_count);
+	const size_t cell_count = (size_t)header_->symbol_count * header_->bin_count;
+	uint8_t* present = GetBlock (block) + cell_count * (kCellSize - sizeof (uint8_t));
+	present[CellIndex (symbol, bin)] = 0;
+}
+
+bool
+gomi::bar_store_t::Flush()
+{
+	if (!IsOpen())
+		return false;
+	if (!FlushViewOfFile (view_.get(), 0) ||
+	    !FlushFileBuffers (file_.get()))
+	{
+		LOG(WARNING) << "Failed to flush bar store, error code=" << GetLastError();
+		return false;
+	}
+	return true;
+}
+
+size_t
+gomi::bar_store_t::CellIndex (
+	unsigned symbol,
+	unsigned bin
+	) const
+{
+	DCHECK_LT (symbol, header_->symbol_count);
+	DCHECK_LT (bin, header_->bin_count);
+	return (size_t)symbol * header_->bin_count + bin;
+}
+
+uint8_t*
+gomi::bar_store_t::GetBlock (
+	int block
+	) const
+{
+	return static_cast<uint8_t*> (view_.get()) + header_->header_size + (size_t)block * header_->block_size;
+}
+
+/* eof */
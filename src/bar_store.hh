@@ -0,0 +1,77 @@
+/* Memory mapped store of finished day bars.
+ *
+ * Columnar file of open, close, moves and volume per symbol, bin and business
+ * day, arranged as a ring of day blocks sized to the analytic period.  The
+ * store has no Velocity Analytics dependency and may be used stand-alone.
+ */
+
+#ifndef __BAR_STORE_HH__
+#define __BAR_STORE_HH__
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Boost Gregorian Calendar */
+#include <boost/date_time/gregorian/gregorian_types.hpp>
+
+#include "microsoft/unique_handle.hh"
+
+namespace gomi
+{
+/* one finished day bar */
+	struct stored_bar_t
+	{
+		double open_price, close_price;
+		uint64_t number_moves;
+		uint64_t accumulated_volume;
+	};
+
+	class bar_store_t : boost::noncopyable
+	{
+	public:
+		bar_store_t();
+		~bar_store_t();
+
+/* map /path/, creating or re-creating the file when the layout of /symbols/
+ * and /bin_keys/ does not match, /block_count/ business days are retained.
+ */
+		bool Open (const std::string& path, const std::vector<std::string>& symbols, const std::vector<std::string>& bin_keys, unsigned block_count);
+		void Close();
+		bool IsOpen() const { return nullptr != header_; }
+
+/* block index of a business day, -1 if not stored */
+		int FindDay (const boost::gregorian::date& date) const;
+/* block index for a business day, replacing the oldest day when not stored */
+		int AppendDay (const boost::gregorian::date& date);
+
+		bool Read (int block, unsigned symbol, unsigned bin, stored_bar_t* bar) const;
+		void Write (int block, unsigned symbol, unsigned bin, const stored_bar_t& bar);
+/* mark a stored bar absent, e.g. after late or corrected trades */
+		void Erase (int block, unsigned symbol, unsigned bin);
+
+/* commit dirty pages to disk */
+		bool Flush();
+
+	private:
+		struct header_t;
+
+		size_t CellIndex (unsigned symbol, unsigned bin) const;
+		uint8_t* GetBlock (int block) const;
+
+		ms::file_handle file_;
+		ms::handle mapping_;
+		ms::map_view view_;
+		header_t* header_;
+		size_t file_size_;
+	};
+
+} /* namespace gomi */
+
+#endif /* __BAR_STORE_HH__ */
+
+/* eof */
@@ -0,0 +1,198 @@
+/* Bar store unit test against a file in the working directory.
+ *
+ * Returns zero on success, non-zero with each failure logged to stderr.
+ */
+
+#include "bar_store.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "unittest.hh"
+
+static const char* kPath = "bar_store_unittest.bin";
+
+static
+std::vector<std::string>
+make_list (
+	const char* a,
+	const char* b,
+	const char* c
+	)
+{
+	std::vector<std::string> list;
+	list.push_back (a);
+	list.push_back (b);
+	if (nullptr != c)
+		list.push_back (c);
+	return list;
+}
+
+static
+gomi::stored_bar_t
+make_bar (
+	unsigned seed
+	)
+{
+	gomi::stored_bar_t bar;
+	bar.open_price = 10.0 + seed;
+	bar.close_price = 10.5 + seed;
+	bar.number_moves = 100 + seed;
+	bar.accumulated_volume = 1000 + seed;
+	return bar;
+}
+
+static
+bool
+is_bar (
+	const gomi::bar_store_t& store,
+	int block,
+	unsigned symbol,
+	unsigned bin,
+	unsigned seed
+	)
+{
+	gomi::stored_bar_t bar;
+	if (!store.Read (block, symbol, bin, &bar))
+		return false;
+	const gomi::stored_bar_t expected = make_bar (seed);
+	return expected.open_price == bar.open_price &&
+	       expected.close_price == bar.close_price &&
+	       expected.number_moves == bar.number_moves &&
+	       expected.accumulated_volume == bar.accumulated_volume;
+}
+
+/* Written bars survive close and reopen with the same layout, erased and
+ * unwritten cells read as absent.
+ */
+static
+void
+test_reopen()
+{
+	const auto symbols = make_list ("A.N", "B.N", "C.N");
+	const auto bin_keys = make_list ("0930-1000", "1000-1030", nullptr);
+	const boost::gregorian::date date (2012, 3, 9);
+	int block;
+	remove (kPath);
+	{
+		gomi::bar_store_t store;
+		EXPECT(store.Open (kPath, symbols, bin_keys, 3));
+		EXPECT(store.IsOpen());
+		EXPECT(-1 == store.FindDay (date));
+		block = store.AppendDay (date);
+		EXPECT(block >= 0 && block < 3);
+		EXPECT(block == store.AppendDay (date));
+		store.Write (block, 0, 0, make_bar (1));
+		store.Write (block, 2, 1, make_bar (2));
+		store.Write (block, 1, 0, make_bar (3));
+		store.Erase (block, 1, 0);
+		EXPECT(is_bar (store, block, 0, 0, 1));
+		EXPECT(!is_bar (store, block, 1, 0, 3));
+		EXPECT(store.Flush());
+		store.Close();
+		EXPECT(!store.IsOpen());
+	}
+	gomi::bar_store_t store;
+	EXPECT(store.Open (kPath, symbols, bin_keys, 3));
+	EXPECT(block == store.FindDay (date));
+	EXPECT(is_bar (store, block, 0, 0, 1));
+	EXPECT(is_bar (store, block, 2, 1, 2));
+	EXPECT(!is_bar (store, block, 1, 0, 3));
+	gomi::stored_bar_t bar;
+	EXPECT(!store.Read (block, 0, 1, &bar));
+	store.Close();
+	remove (kPath);
+}
+
+/* Any change of symbols, bins or retained days discards stored bars,
+ * including a change that keeps the file size.
+ */
+static
+void
+test_layout_change()
+{
+	const auto symbols = make_list ("A.N", "B.N", "C.N");
+	const auto bin_keys = make_list ("0930-1000", "1000-1030", nullptr);
+	const boost::gregorian::date date (2012, 3, 9);
+	struct {
+		std::vector<std::string> symbols, bin_keys;
+		unsigned block_count;
+	} layouts[] = {
+		{ make_list ("A.N", "B.N", "D.N"), bin_keys, 3 },
+		{ symbols, make_list ("1000-1030", "0930-1000", nullptr), 3 },
+		{ make_list ("A.N", "B.N", nullptr), bin_keys, 3 },
+		{ symbols, bin_keys, 4 }
+	};
+	for (size_t i = 0; i < sizeof (layouts) / sizeof (layouts[0]); ++i) {
+		remove (kPath);
+		{
+			gomi::bar_store_t store;
+			EXPECT(store.Open (kPath, symbols, bin_keys, 3));
+			const int block = store.AppendDay (date);
+			store.Write (block, 0, 0, make_bar (1));
+			store.Close();
+		}
+		gomi::bar_store_t store;
+		EXPECT(store.Open (kPath, layouts[i].symbols, layouts[i].bin_keys, layouts[i].block_count));
+		EXPECT(-1 == store.FindDay (date));
+		const int block = store.AppendDay (date);
+		EXPECT(!is_bar (store, block, 0, 0, 1));
+		store.Close();
+	}
+	remove (kPath);
+	gomi::bar_store_t store;
+	EXPECT(!store.Open (kPath, std::vector<std::string>(), bin_keys, 3));
+	EXPECT(!store.IsOpen());
+	remove (kPath);
+}
+
+/* A new day beyond the retained count replaces the oldest day and clears its
+ * cells, other days are untouched.
+ */
+static
+void
+test_eviction()
+{
+	const auto symbols = make_list ("A.N", "B.N", "C.N");
+	const auto bin_keys = make_list ("0930-1000", "1000-1030", nullptr);
+	const boost::gregorian::date dates[] = {
+		boost::gregorian::date (2012, 3, 6),
+		boost::gregorian::date (2012, 3, 7),
+		boost::gregorian::date (2012, 3, 8),
+		boost::gregorian::date (2012, 3, 9)
+	};
+	remove (kPath);
+	gomi::bar_store_t store;
+	EXPECT(store.Open (kPath, symbols, bin_keys, 3));
+	int blocks[4];
+	for (unsigned t = 0; t < 3; ++t) {
+		blocks[t] = store.AppendDay (dates[t]);
+		store.Write (blocks[t], 1, 1, make_bar (t));
+	}
+	EXPECT(blocks[0] != blocks[1] && blocks[1] != blocks[2] && blocks[0] != blocks[2]);
+	blocks[3] = store.AppendDay (dates[3]);
+	EXPECT(blocks[0] == blocks[3]);
+	EXPECT(-1 == store.FindDay (dates[0]));
+	EXPECT(blocks[3] == store.FindDay (dates[3]));
+	EXPECT(!is_bar (store, blocks[3], 1, 1, 0));
+	EXPECT(is_bar (store, blocks[1], 1, 1, 1));
+	EXPECT(is_bar (store, blocks[2], 1, 1, 2));
+	store.Close();
+	remove (kPath);
+}
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	test_reopen();
+	test_layout_change();
+	test_eviction();
+	return unittest::Result();
+}
+
+/* eof */
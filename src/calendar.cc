@@ -0,0 +1,143 @@
+/* Business day calendar.
+ */
+
+#include "calendar.hh"
+
+#include <algorithm>
+
+/* Boost Posix Time */
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+/* Velocity Analytics Plugin Framework */
+#include <vpf/vpf.h>
+#include <TBPrimitives.h>
+
+#include "chromium/file_util.hh"
+#include "chromium/logging.hh"
+#include "chromium/string_split.hh"
+
+/* http://en.wikipedia.org/wiki/Unix_epoch */
+static const boost::gregorian::date kUnixEpoch (1970, 1, 1);
+
+gomi::calendar_t::calendar_t() :
+	first_ (boost::gregorian::not_a_date_time),
+	last_ (boost::gregorian::not_a_date_time)
+{
+}
+
+/* Returns true on success, false on invalid range.
+ */
+bool
+gomi::calendar_t::Load (
+	const boost::gregorian::date& first,
+	const boost::gregorian::date& last
+	)
+{
+	using namespace boost::posix_time;
+	if (first.is_not_a_date() || last.is_not_a_date() || last < first) {
+		LOG(ERROR) << "Invalid calendar range.";
+		return false;
+	}
+	std::vector<boost::gregorian::date> business_days;
+	for (boost::gregorian::day_iterator it (first); *it <= last; ++it) {
+		BusinessDayInfo bd;
+		const __time32_t time32 = (ptime (*it) - ptime (kUnixEpoch)).total_seconds();
+		if (0 != TBPrimitives::BusinessDay (time32, &bd))
+			business_days.push_back (*it);
+	}
+	Index (first, last, business_days);
+	return true;
+}
+
+/* Returns true on success, false if the file cannot be read or parsed.
+ */
+bool
+gomi::calendar_t::LoadFile (
+	const std::string& path
+	)
+{
+	std::string contents;
+	if (!file_util::ReadFileToString (path, &contents)) {
+		LOG(ERROR) << "Cannot read calendar file: " << path;
+		return false;
+	}
+	std::vector<std::string> tokens;
+	chromium::SplitStringAlongWhitespace (contents, &tokens);
+	std::vector<boost::gregorian::date> business_days;
+	try {
+		std::for_each (tokens.begin(), tokens.end(), [&business_days](const std::string& token) {
+			business_days.push_back (boost::gregorian::from_simple_string (token));
+		});
+	} catch (std::exception& e) {
+		LOG(ERROR) << "Calendar file malformed: " << e.what();
+		return false;
+	}
+	if (business_days.empty()) {
+		LOG(ERROR) << "Empty calendar file: " << path;
+		return false;
+	}
+	std::sort (business_days.begin(), business_days.end());
+	business_days.erase (std::unique (business_days.begin(), business_days.end()), business_days.end());
+	Index (business_days.front(), business_days.back(), business_days);
+	return true;
+}
+
+void
+gomi::calendar_t::Index (
+	const boost::gregorian::date& first,
+	const boost::gregorian::date& last,
+	const std::vector<boost::gregorian::date>& business_days
+	)
+{
+	first_ = first;
+	last_ = last;
+	business_days_ = business_days;
+	ordinal_.assign ((last_ - first_).days() + 1, -1);
+	int k = -1;
+	auto it = business_days_.begin();
+	for (size_t i = 0; i < ordinal_.size(); ++i) {
+		const auto date = first_ + boost::gregorian::date_duration (i);
+		if (business_days_.end() != it && *it == date) {
+			++k;
+			++it;
+		}
+		ordinal_[i] = k;
+	}
+	LOG(INFO) << "Calendar: { "
+		  "\"first\": \"" << to_simple_string (first_) << "\""
+		", \"last\": \"" << to_simple_string (last_) << "\""
+		", \"business_days\": " << business_days_.size() <<
+		" }";
+}
+
+bool
+gomi::calendar_t::IsBusinessDay (
+	const boost::gregorian::date& date
+	) const
+{
+	if (date.is_not_a_date() || first_.is_not_a_date() || date < first_ || date > last_)
+		return false;
+	const int k = ordinal_[(date - first_).days()];
+	return k >= 0 && business_days_[k] == date;
+}
+
+bool
+gomi::calendar_t::GetBusinessDays (
+	const boost::gregorian::date& date,
+	unsigned count,
+	std::vector<boost::gregorian::date>* days
+	) const
+{
+	days->clear();
+	if (date.is_not_a_date() || first_.is_not_a_date() || date < first_ || date > last_)
+		return false;
+	const int k = ordinal_[(date - first_).days()];
+	if (k + 1 < (int)count)
+		return false;
+	days->reserve (count);
+	for (int i = k; i > k - (int)count; --i)
+		days->push_back (business_days_[i]);
+	return true;
+}
+
+/* eof */
@@ -0,0 +1,59 @@
+/* Business day calendar.
+ *
+ * Business days of a date range are resolved once into an ordinal index so
+ * that the previous N business days of any date are a table lookup.
+ *
+ * Extremely large caveat: TBSDK is limited to a single market.
+ */
+
+#ifndef __CALENDAR_HH__
+#define __CALENDAR_HH__
+#pragma once
+
+#include <string>
+#include <vector>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Boost Gregorian Calendar */
+#include <boost/date_time/gregorian/gregorian_types.hpp>
+
+namespace gomi
+{
+	class calendar_t : boost::noncopyable
+	{
+	public:
+		calendar_t();
+
+/* resolve business days of [first, last] with TBSDK, one call per calendar day */
+		bool Load (const boost::gregorian::date& first, const boost::gregorian::date& last);
+/* read business days from a file of ISO dates, e.g. 2012-01-13, for testing
+ * without an Analytics Engine.  The range is the first to last listed date.
+ */
+		bool LoadFile (const std::string& path);
+
+		bool IsBusinessDay (const boost::gregorian::date& date) const;
+/* most recent /count/ business days on or before /date/, newest first,
+ * returns false if the calendar does not extend back far enough.
+ */
+		bool GetBusinessDays (const boost::gregorian::date& date, unsigned count, std::vector<boost::gregorian::date>* days) const;
+
+		const boost::gregorian::date& GetFirstDate() const { return first_; }
+		const boost::gregorian::date& GetLastDate() const { return last_; }
+
+	private:
+		void Index (const boost::gregorian::date& first, const boost::gregorian::date& last, const std::vector<boost::gregorian::date>& business_days);
+
+		boost::gregorian::date first_, last_;
+/* ascending */
+		std::vector<boost::gregorian::date> business_days_;
+/* per calendar day from first_, index of latest business day on or before, -1 for none */
+		std::vector<int> ordinal_;
+	};
+
+} /* namespace gomi */
+
+#endif /* __CALENDAR_HH__ */
+
+/* eof */
@@ -0,0 +1,102 @@
+/* Business day calendar unit test against a file in the working directory.
+ *
+ * Returns zero on success, non-zero with each failure logged to stderr.
+ */
+
+#include "calendar.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "unittest.hh"
+
+static const char* kPath = "calendar_unittest.txt";
+
+static
+bool
+write_file (
+	const char* contents
+	)
+{
+	FILE* fp = fopen (kPath, "w");
+	if (nullptr == fp)
+		return false;
+	fputs (contents, fp);
+	fclose (fp);
+	return true;
+}
+
+/* Unsorted and duplicate dates, a weekend and a holiday gap, lookups on
+ * and between business days and at both ends of the range.
+ */
+static
+void
+test_lookup()
+{
+	using boost::gregorian::date;
+	EXPECT(write_file ("2012-03-08\n2012-03-05 2012-03-06\n2012-03-12\n2012-03-09\n2012-03-06\n2012-03-14\n"));
+	gomi::calendar_t calendar;
+	EXPECT(calendar.LoadFile (kPath));
+	EXPECT(date (2012, 3, 5) == calendar.GetFirstDate());
+	EXPECT(date (2012, 3, 14) == calendar.GetLastDate());
+
+	EXPECT(calendar.IsBusinessDay (date (2012, 3, 5)));
+	EXPECT(!calendar.IsBusinessDay (date (2012, 3, 7)));
+	EXPECT(!calendar.IsBusinessDay (date (2012, 3, 10)));
+	EXPECT(calendar.IsBusinessDay (date (2012, 3, 14)));
+	EXPECT(!calendar.IsBusinessDay (date (2012, 3, 4)));
+	EXPECT(!calendar.IsBusinessDay (date (2012, 3, 15)));
+	EXPECT(!calendar.IsBusinessDay (date (boost::gregorian::not_a_date_time)));
+
+	std::vector<date> days;
+	EXPECT(calendar.GetBusinessDays (date (2012, 3, 12), 3, &days));
+	EXPECT(3 == days.size() &&
+	       date (2012, 3, 12) == days[0] &&
+	       date (2012, 3, 9) == days[1] &&
+	       date (2012, 3, 8) == days[2]);
+/* a weekend day resolves to the preceding business day */
+	EXPECT(calendar.GetBusinessDays (date (2012, 3, 11), 2, &days));
+	EXPECT(2 == days.size() &&
+	       date (2012, 3, 9) == days[0] &&
+	       date (2012, 3, 8) == days[1]);
+	EXPECT(calendar.GetBusinessDays (date (2012, 3, 14), 6, &days));
+	EXPECT(6 == days.size() && date (2012, 3, 5) == days[5]);
+	EXPECT(calendar.GetBusinessDays (date (2012, 3, 7), 0, &days));
+	EXPECT(days.empty());
+
+/* not enough history or out of range */
+	EXPECT(!calendar.GetBusinessDays (date (2012, 3, 14), 7, &days));
+	EXPECT(days.empty());
+	EXPECT(!calendar.GetBusinessDays (date (2012, 3, 4), 1, &days));
+	EXPECT(!calendar.GetBusinessDays (date (2012, 3, 15), 1, &days));
+	remove (kPath);
+}
+
+static
+void
+test_invalid_file()
+{
+	gomi::calendar_t calendar;
+	remove (kPath);
+	EXPECT(!calendar.LoadFile (kPath));
+	EXPECT(write_file (""));
+	EXPECT(!calendar.LoadFile (kPath));
+	EXPECT(write_file ("2012-03-05\nyesterday\n"));
+	EXPECT(!calendar.LoadFile (kPath));
+	EXPECT(!calendar.IsBusinessDay (boost::gregorian::date (2012, 3, 5)));
+	remove (kPath);
+}
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	test_lookup();
+	test_invalid_file();
+	return unittest::Result();
+}
+
+/* eof */
@@ -0,0 +1,430 @@
+/* Batch collation of day bars into bin analytics.
+ *
+ * Every kernel must be bit-for-bit identical to the scalar reference: lanes
+ * are symbols, each lane performs the same IEEE operations in the same order
+ * as the reference, including the division by day index zero on the first
+ * effective business day.
+ */
+
+#include "collate.hh"
+
+#include <intrin.h>
+#include <nmmintrin.h>
+
+#include "chromium/logging.hh"
+
+/* AVX2 intrinsics require MSVC2012 or later */
+#if defined(_MSC_VER) && _MSC_VER >= 1700
+#	define HAVE_AVX2_INTRINSICS
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+#	include <immintrin.h>
+#endif
+
+/* Average volume is an integer division, not vectorized.
+ */
+static
+void
+finalize (
+	const gomi::collate_input_t& input,
+	size_t s,
+	gomi::collate_output_t* output
+	)
+{
+	const uint64_t accumulated_volume = output->accumulated_volume[s];
+	const unsigned trading_day_count = output->trading_day_count[s];
+	if (trading_day_count > 0 && accumulated_volume > 0) {
+		output->average_volume[s]         = accumulated_volume / input.analytic_day_count;
+		output->average_nonzero_volume[s] = accumulated_volume / trading_day_count;
+	} else {
+		output->average_volume[s] = output->average_nonzero_volume[s] = 0;
+	}
+}
+
+/* Collate one symbol.
+ */
+static
+void
+collate_symbol (
+	const gomi::collate_input_t& input,
+	size_t s,
+	gomi::collate_output_t* output
+	)
+{
+	const size_t n = input.symbol_count;
+	uint64_t accumulated_volume = 0;
+	double   accumulated_pc     = 0.0;
+	double   avg_nonzero_pc     = 0.0;
+	uint64_t total_moves = 0, maximum_moves = 0, minimum_moves = 0, smallest_moves = 0;
+	unsigned trading_day_count = 0, analytic_trading_day_count = 0;
+	bool is_null = true;
+	size_t w = 0;
+
+	for (unsigned t = 0; t < input.day_count; ++t)
+	{
+		const double open_price   = input.open_price[t * n + s],
+			     close_price  = input.close_price[t * n + s];
+		const uint64_t number_moves = input.number_moves[t * n + s];
+
+		if (open_price > 0.0)
+			accumulated_pc += ((100.0 * (close_price - open_price)) / open_price);
+
+/* test for zero-trade day */
+		if (number_moves > 0) {
+			++trading_day_count;
+			avg_nonzero_pc = accumulated_pc / trading_day_count;
+		}
+
+/* window ending today */
+		if (w < input.window_end.size() && t == input.window_end[w]) {
+			output->avg_pc[w * n + s]         = accumulated_pc / t;
+			output->avg_nonzero_pc[w * n + s] = avg_nonzero_pc;
+			++w;
+		}
+
+		if (t >= input.analytic_day_count)
+			continue;
+		analytic_trading_day_count = trading_day_count;
+		accumulated_volume += input.accumulated_volume[t * n + s];
+		total_moves        += number_moves;
+
+		if (is_null) {
+			is_null = false;
+/* may or may not be zero */
+			maximum_moves = minimum_moves = smallest_moves = number_moves;
+		} else {
+			if (number_moves > 0)
+			{
+/* edge case: smallest-moves should not be zero if a trade-day is available */
+				if (0 == maximum_moves)
+					maximum_moves = smallest_moves = number_moves;
+				else if (number_moves < smallest_moves)
+					smallest_moves = number_moves;
+				else if (number_moves > maximum_moves)
+					maximum_moves = number_moves;
+			}
+			if (number_moves < minimum_moves)
+				minimum_moves = number_moves;
+		}
+	}
+
+	output->total_moves[s]               = total_moves;
+	output->maximum_moves[s]             = maximum_moves;
+	output->minimum_moves[s]             = minimum_moves;
+	output->smallest_moves[s]            = smallest_moves;
+	output->accumulated_volume[s]        = accumulated_volume;
+	output->trading_day_count[s]         = analytic_trading_day_count;
+	finalize (input, s, output);
+}
+
+/* Two symbols per iteration, 64-bit integer compares require SSE4.2.
+ */
+static
+void
+collate_sse42 (
+	const gomi::collate_input_t& input,
+	gomi::collate_output_t* output
+	)
+{
+	const size_t n = input.symbol_count;
+	const __m128d zero_pd = _mm_setzero_pd(),
+		      one_pd  = _mm_set1_pd (1.0),
+		      hundred = _mm_set1_pd (100.0);
+	const __m128i zero_epi64 = _mm_setzero_si128();
+	size_t s = 0;
+
+	for (; s + 2 <= n; s += 2)
+	{
+		__m128d accumulated_pc = zero_pd, trading_day_count = zero_pd, analytic_trading_day_count = zero_pd;
+		__m128d avg_nonzero_pc = zero_pd;
+		__m128i accumulated_volume = zero_epi64, total_moves = zero_epi64;
+		__m128i maximum_moves = zero_epi64, minimum_moves = zero_epi64, smallest_moves = zero_epi64;
+		size_t w = 0;
+
+		for (unsigned t = 0; t < input.day_count; ++t)
+		{
+			const size_t i = t * n + s;
+			const __m128d open_price   = _mm_loadu_pd (&input.open_price[i]),
+				      close_price  = _mm_loadu_pd (&input.close_price[i]);
+			const __m128i number_moves = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (&input.number_moves[i]));
+
+/* open price > 0.0 */
+			const __m128d has_open = _mm_cmpgt_pd (open_price, zero_pd);
+			const __m128d pc = _mm_div_pd (_mm_mul_pd (hundred, _mm_sub_pd (close_price, open_price)), open_price);
+			accumulated_pc = _mm_blendv_pd (accumulated_pc, _mm_add_pd (accumulated_pc, pc), has_open);
+
+/* test for zero-trade day */
+			const __m128i is_trading = _mm_cmpgt_epi64 (number_moves, zero_epi64);
+			const __m128d is_trading_pd = _mm_castsi128_pd (is_trading);
+			trading_day_count = _mm_add_pd (trading_day_count, _mm_and_pd (is_trading_pd, one_pd));
+			const __m128d nonzero_pc = _mm_div_pd (accumulated_pc, trading_day_count);
+			avg_nonzero_pc = _mm_blendv_pd (avg_nonzero_pc, nonzero_pc, is_trading_pd);
+
+/* window ending today */
+			if (w < input.window_end.size() && t == input.window_end[w]) {
+				_mm_storeu_pd (&output->avg_pc[w * n + s], _mm_div_pd (accumulated_pc, _mm_set1_pd ((double)t)));
+				_mm_storeu_pd (&output->avg_nonzero_pc[w * n + s], avg_nonzero_pc);
+				++w;
+			}
+
+			if (t >= input.analytic_day_count)
+				continue;
+			const __m128i volume = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (&input.accumulated_volume[i]));
+			analytic_trading_day_count = trading_day_count;
+			accumulated_volume = _mm_add_epi64 (accumulated_volume, volume);
+			total_moves        = _mm_add_epi64 (total_moves, number_moves);
+
+			if (0 == t) {
+				maximum_moves = minimum_moves = smallest_moves = number_moves;
+			} else {
+				const __m128i is_first   = _mm_and_si128 (is_trading, _mm_cmpeq_epi64 (maximum_moves, zero_epi64));
+				const __m128i is_rest    = _mm_andnot_si128 (is_first, is_trading);
+				const __m128i is_smaller = _mm_and_si128 (is_rest, _mm_cmpgt_epi64 (smallest_moves, number_moves));
+				const __m128i is_larger  = _mm_and_si128 (_mm_andnot_si128 (is_smaller, is_rest), _mm_cmpgt_epi64 (number_moves, maximum_moves));
+				maximum_moves  = _mm_blendv_epi8 (maximum_moves, number_moves, _mm_or_si128 (is_first, is_larger));
+				smallest_moves = _mm_blendv_epi8 (smallest_moves, number_moves, _mm_or_si128 (is_first, is_smaller));
+				minimum_moves  = _mm_blendv_epi8 (minimum_moves, number_moves, _mm_cmpgt_epi64 (minimum_moves, number_moves));
+			}
+		}
+
+		_mm_storeu_si128 (reinterpret_cast<__m128i*> (&output->total_moves[s]), total_moves);
+		_mm_storeu_si128 (reinterpret_cast<__m128i*> (&output->maximum_moves[s]), maximum_moves);
+		_mm_storeu_si128 (reinterpret_cast<__m128i*> (&output->minimum_moves[s]), minimum_moves);
+		_mm_storeu_si128 (reinterpret_cast<__m128i*> (&output->smallest_moves[s]), smallest_moves);
+		_mm_storeu_si128 (reinterpret_cast<__m128i*> (&output->accumulated_volume[s]), accumulated_volume);
+		double trading_days[2];
+		_mm_storeu_pd (trading_days, analytic_trading_day_count);
+		for (size_t k = 0; k < 2; ++k) {
+			output->trading_day_count[s + k] = (unsigned)trading_days[k];
+			finalize (input, s + k, output);
+		}
+	}
+
+/* remainder */
+	for (; s < n; ++s)
+		collate_symbol (input, s, output);
+}
+
+#ifdef HAVE_AVX2_INTRINSICS
+/* Four symbols per iteration.
+ */
+static
+void
+collate_avx2 (
+	const gomi::collate_input_t& input,
+	gomi::collate_output_t* output
+	)
+{
+	const size_t n = input.symbol_count;
+	const __m256d zero_pd = _mm256_setzero_pd(),
+		      one_pd  = _mm256_set1_pd (1.0),
+		      hundred = _mm256_set1_pd (100.0);
+	const __m256i zero_epi64 = _mm256_setzero_si256();
+	size_t s = 0;
+
+	for (; s + 4 <= n; s += 4)
+	{
+		__m256d accumulated_pc = zero_pd, trading_day_count = zero_pd, analytic_trading_day_count = zero_pd;
+		__m256d avg_nonzero_pc = zero_pd;
+		__m256i accumulated_volume = zero_epi64, total_moves = zero_epi64;
+		__m256i maximum_moves = zero_epi64, minimum_moves = zero_epi64, smallest_moves = zero_epi64;
+		size_t w = 0;
+
+		for (unsigned t = 0; t < input.day_count; ++t)
+		{
+			const size_t i = t * n + s;
+			const __m256d open_price   = _mm256_loadu_pd (&input.open_price[i]),
+				      close_price  = _mm256_loadu_pd (&input.close_price[i]);
+			const __m256i number_moves = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (&input.number_moves[i]));
+
+/* open price > 0.0 */
+			const __m256d has_open = _mm256_cmp_pd (open_price, zero_pd, _CMP_GT_OQ);
+			const __m256d pc = _mm256_div_pd (_mm256_mul_pd (hundred, _mm256_sub_pd (close_price, open_price)), open_price);
+			accumulated_pc = _mm256_blendv_pd (accumulated_pc, _mm256_add_pd (accumulated_pc, pc), has_open);
+
+/* test for zero-trade day */
+			const __m256i is_trading = _mm256_cmpgt_epi64 (number_moves, zero_epi64);
+			const __m256d is_trading_pd = _mm256_castsi256_pd (is_trading);
+			trading_day_count = _mm256_add_pd (trading_day_count, _mm256_and_pd (is_trading_pd, one_pd));
+			const __m256d nonzero_pc = _mm256_div_pd (accumulated_pc, trading_day_count);
+			avg_nonzero_pc = _mm256_blendv_pd (avg_nonzero_pc, nonzero_pc, is_trading_pd);
+
+/* window ending today */
+			if (w < input.window_end.size() && t == input.window_end[w]) {
+				_mm256_storeu_pd (&output->avg_pc[w * n + s], _mm256_div_pd (accumulated_pc, _mm256_set1_pd ((double)t)));
+				_mm256_storeu_pd (&output->avg_nonzero_pc[w * n + s], avg_nonzero_pc);
+				++w;
+			}
+
+			if (t >= input.analytic_day_count)
+				continue;
+			const __m256i volume = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (&input.accumulated_volume[i]));
+			analytic_trading_day_count = trading_day_count;
+			accumulated_volume = _mm256_add_epi64 (accumulated_volume, volume);
+			total_moves        = _mm256_add_epi64 (total_moves, number_moves);
+
+			if (0 == t) {
+				maximum_moves = minimum_moves = smallest_moves = number_moves;
+			} else {
+				const __m256i is_first   = _mm256_and_si256 (is_trading, _mm256_cmpeq_epi64 (maximum_moves, zero_epi64));
+				const __m256i is_rest    = _mm256_andnot_si256 (is_first, is_trading);
+				const __m256i is_smaller = _mm256_and_si256 (is_rest, _mm256_cmpgt_epi64 (smallest_moves, number_moves));
+				const __m256i is_larger  = _mm256_and_si256 (_mm256_andnot_si256 (is_smaller, is_rest), _mm256_cmpgt_epi64 (number_moves, maximum_moves));
+				maximum_moves  = _mm256_blendv_epi8 (maximum_moves, number_moves, _mm256_or_si256 (is_first, is_larger));
+				smallest_moves = _mm256_blendv_epi8 (smallest_moves, number_moves, _mm256_or_si256 (is_first, is_smaller));
+				minimum_moves  = _mm256_blendv_epi8 (minimum_moves, number_moves, _mm256_cmpgt_epi64 (minimum_moves, number_moves));
+			}
+		}
+
+		_mm256_storeu_si256 (reinterpret_cast<__m256i*> (&output->total_moves[s]), total_moves);
+		_mm256_storeu_si256 (reinterpret_cast<__m256i*> (&output->maximum_moves[s]), maximum_moves);
+		_mm256_storeu_si256 (reinterpret_cast<__m256i*> (&output->minimum_moves[s]), minimum_moves);
+		_mm256_storeu_si256 (reinterpret_cast<__m256i*> (&output->smallest_moves[s]), smallest_moves);
+		_mm256_storeu_si256 (reinterpret_cast<__m256i*> (&output->accumulated_volume[s]), accumulated_volume);
+		double trading_days[4];
+		_mm256_storeu_pd (trading_days, analytic_trading_day_count);
+		for (size_t k = 0; k < 4; ++k) {
+			output->trading_day_count[s + k] = (unsigned)trading_days[k];
+			finalize (input, s + k, output);
+		}
+	}
+
+/* upper halves of YMM registers are dirty, avoid transition penalty in following SSE code */
+	_mm256_zeroupper();
+
+/* remainder */
+	for (; s < n; ++s)
+		collate_symbol (input, s, output);
+}
+#endif /* HAVE_AVX2_INTRINSICS */
+
+void
+gomi::CollateScalar (
+	const collate_input_t& input,
+	collate_output_t* output
+	)
+{
+	output->Resize (input.window_end.size(), input.symbol_count);
+	for (size_t s = 0; s < input.symbol_count; ++s)
+		collate_symbol (input, s, output);
+}
+
+/* Kernel selection, by CPUID and operating system support for saving YMM
+ * registers.
+ */
+namespace
+{
+	enum kernel_e {
+		KERNEL_UNKNOWN,
+		KERNEL_SCALAR,
+		KERNEL_SSE42,
+		KERNEL_AVX2
+	};
+
+	kernel_e
+	select_kernel()
+	{
+		int info[4];
+		__cpuid (info, 0);
+		const int max_leaf = info[0];
+		if (max_leaf < 1)
+			return KERNEL_SCALAR;
+		__cpuid (info, 1);
+		const bool has_sse42   = (0 != (info[2] & (1 << 20)));
+#ifdef HAVE_AVX2_INTRINSICS
+		const bool has_osxsave = (0 != (info[2] & (1 << 27)));
+		const bool has_avx     = (0 != (info[2] & (1 << 28)));
+		if (max_leaf >= 7 && has_osxsave && has_avx &&
+		    0x6 == (_xgetbv (0) & 0x6))	/* XMM and YMM state */
+		{
+			__cpuidex (info, 7, 0);
+			if (0 != (info[1] & (1 << 5)))
+				return KERNEL_AVX2;
+		}
+#endif
+		return has_sse42 ? KERNEL_SSE42 : KERNEL_SCALAR;
+	}
+
+/* benign race, every thread resolves the same value */
+	volatile kernel_e kernel = KERNEL_UNKNOWN;
+
+	kernel_e
+	get_kernel()
+	{
+		if (KERNEL_UNKNOWN == kernel) {
+			kernel = select_kernel();
+			LOG(INFO) << "Collation kernel: " << gomi::GetCollateKernelName();
+		}
+		return kernel;
+	}
+}
+
+void
+gomi::Collate (
+	const collate_input_t& input,
+	collate_output_t* output
+	)
+{
+	output->Resize (input.window_end.size(), input.symbol_count);
+	switch (get_kernel()) {
+#ifdef HAVE_AVX2_INTRINSICS
+	case KERNEL_AVX2:
+		collate_avx2 (input, output);
+		break;
+#endif
+	case KERNEL_SSE42:
+		collate_sse42 (input, output);
+		break;
+	default:
+		for (size_t s = 0; s < input.symbol_count; ++s)
+			collate_symbol (input, s, output);
+		break;
+	}
+}
+
+bool
+gomi::Collate (
+	collate_kernel_t kernel,
+	const collate_input_t& input,
+	collate_output_t* output
+	)
+{
+	const kernel_e supported = get_kernel();
+	output->Resize (input.window_end.size(), input.symbol_count);
+	switch (kernel) {
+	case COLLATE_KERNEL_AVX2:
+#ifdef HAVE_AVX2_INTRINSICS
+		if (supported < KERNEL_AVX2)
+			return false;
+		collate_avx2 (input, output);
+		return true;
+#else
+		return false;
+#endif
+	case COLLATE_KERNEL_SSE42:
+		if (supported < KERNEL_SSE42)
+			return false;
+		collate_sse42 (input, output);
+		return true;
+	case COLLATE_KERNEL_SCALAR:
+		for (size_t s = 0; s < input.symbol_count; ++s)
+			collate_symbol (input, s, output);
+		return true;
+	default:
+		return false;
+	}
+}
+
+const char*
+gomi::GetCollateKernelName()
+{
+	switch (kernel) {
+	case KERNEL_AVX2:	return "AVX2";
+	case KERNEL_SSE42:	return "SSE4.2";
+	case KERNEL_SCALAR:	return "scalar";
+	default:		return "unknown";
+	}
+}
+
+/* eof */
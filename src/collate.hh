@@ -0,0 +1,96 @@
+/* Batch collation of day bars into bin analytics.
+ *
+ * All symbols of one bin are collated together from a structure-of-arrays
+ * layout, day major, so that each day is a contiguous vector across symbols
+ * and one SIMD register holds the same statistic of adjacent symbols.
+ *
+ * Percentage change windows share one pass over the longest history: the
+ * running sums are prefix sums from the first effective business day, each
+ * window is the prefix at its last day, so every further window costs one
+ * store rather than another pass.
+ */
+
+#ifndef __COLLATE_HH__
+#define __COLLATE_HH__
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gomi
+{
+	struct collate_input_t
+	{
+		void Resize (unsigned day_count_, size_t symbol_count_) {
+			day_count = analytic_day_count = day_count_;
+			symbol_count = symbol_count_;
+			const size_t n = (size_t)day_count * symbol_count;
+			open_price.resize (n);
+			close_price.resize (n);
+			number_moves.resize (n);
+			accumulated_volume.resize (n);
+		}
+
+		unsigned day_count;
+/* leading days of volume and moves statistics, at most day_count */
+		unsigned analytic_day_count;
+		size_t symbol_count;
+/* ascending distinct last day of each percentage change window, each window
+ * averages days [0, window_end].
+ */
+		std::vector<unsigned> window_end;
+/* indexed [day * symbol_count + symbol], day zero is the first effective business day */
+		std::vector<double> open_price, close_price;
+		std::vector<uint64_t> number_moves, accumulated_volume;
+	};
+
+/* all published statistics per symbol */
+	struct collate_output_t
+	{
+		void Resize (size_t window_count, size_t symbol_count) {
+			avg_pc.resize (window_count * symbol_count);
+			avg_nonzero_pc.resize (window_count * symbol_count);
+			average_volume.resize (symbol_count);
+			average_nonzero_volume.resize (symbol_count);
+			total_moves.resize (symbol_count);
+			maximum_moves.resize (symbol_count);
+			minimum_moves.resize (symbol_count);
+			smallest_moves.resize (symbol_count);
+			accumulated_volume.resize (symbol_count);
+			trading_day_count.resize (symbol_count);
+		}
+
+/* indexed [window * symbol_count + symbol] in window_end order */
+		std::vector<double> avg_pc, avg_nonzero_pc;
+		std::vector<uint64_t> average_volume, average_nonzero_volume;
+		std::vector<uint64_t> total_moves, maximum_moves, minimum_moves, smallest_moves;
+/* intermediate values for logging */
+		std::vector<uint64_t> accumulated_volume;
+		std::vector<unsigned> trading_day_count;
+	};
+
+/* collation kernels in ascending width */
+	enum collate_kernel_t {
+		COLLATE_KERNEL_SCALAR,
+		COLLATE_KERNEL_SSE42,
+		COLLATE_KERNEL_AVX2
+	};
+
+/* collate with the widest kernel supported by the processor: AVX2, SSE4.2 or scalar */
+	void Collate (const collate_input_t& input, collate_output_t* output);
+
+/* collate with /kernel/, returns false when not supported by the processor or compiler */
+	bool Collate (collate_kernel_t kernel, const collate_input_t& input, collate_output_t* output);
+
+/* reference implementation, one symbol at a time */
+	void CollateScalar (const collate_input_t& input, collate_output_t* output);
+
+/* name of kernel selected by Collate() */
+	const char* GetCollateKernelName();
+
+} /* namespace gomi */
+
+#endif /* __COLLATE_HH__ */
+
+/* eof */
@@ -0,0 +1,167 @@
+/* Collation unit test, every vector kernel must match the scalar reference
+ * bit-for-bit.
+ *
+ * Returns zero on success, non-zero with each failure logged to stderr.
+ */
+
+#include "collate.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "unittest.hh"
+
+/* day bar patterns per symbol */
+enum pattern_e {
+	PATTERN_ZERO,		/* no trades on any day */
+	PATTERN_ZERO_OPEN,	/* zero open price on day zero */
+	PATTERN_SPARSE,		/* every third day without trades */
+	PATTERN_FALLING,	/* moves and prices falling with age */
+	PATTERN_VARIED,		/* pseudo-random prices, moves and volume */
+	PATTERN_COUNT
+};
+
+static
+void
+fill (
+	pattern_e pattern,
+	size_t s,
+	gomi::collate_input_t* input
+	)
+{
+	const size_t n = input->symbol_count;
+	unsigned seed = (unsigned)(s * 2654435761U + 1);
+	for (unsigned t = 0; t < input->day_count; ++t) {
+		const size_t i = t * n + s;
+		seed = seed * 1103515245U + 12345U;
+		const unsigned r = (seed >> 8) & 0xffff;
+		switch (pattern) {
+		case PATTERN_ZERO:
+			input->open_price[i] = input->close_price[i] = 0.0;
+			input->number_moves[i] = input->accumulated_volume[i] = 0;
+			break;
+		case PATTERN_ZERO_OPEN:
+			input->open_price[i]         = (0 == t) ? 0.0 : 10.0 + t;
+			input->close_price[i]        = 10.5 + t;
+			input->number_moves[i]       = 1 + t;
+			input->accumulated_volume[i] = 100 * (1 + t);
+			break;
+		case PATTERN_SPARSE:
+			if (0 == t % 3) {
+				input->open_price[i] = input->close_price[i] = 0.0;
+				input->number_moves[i] = input->accumulated_volume[i] = 0;
+			} else {
+				input->open_price[i]         = 20.0;
+				input->close_price[i]        = 20.0 + 0.01 * t;
+				input->number_moves[i]       = t;
+				input->accumulated_volume[i] = 1000 + t;
+			}
+			break;
+		case PATTERN_FALLING:
+			input->open_price[i]         = 50.0 - t;
+			input->close_price[i]        = 49.0 - t;
+			input->number_moves[i]       = 100 - t;
+			input->accumulated_volume[i] = 10000 - 10 * t;
+			break;
+		case PATTERN_VARIED:
+		default:
+			input->open_price[i]         = 1.0 + r / 1000.0;
+			input->close_price[i]        = 1.0 + ((r * 7919) & 0xffff) / 1000.0;
+			input->number_moves[i]       = (0 == r % 4) ? 0 : r % 500;
+			input->accumulated_volume[i] = (0 == r % 4) ? 0 : (uint64_t)r * 1000003;
+			break;
+		}
+	}
+}
+
+static
+bool
+is_identical (
+	const std::vector<double>& lhs,
+	const std::vector<double>& rhs
+	)
+{
+	return lhs.size() == rhs.size() && 0 == memcmp (lhs.data(), rhs.data(), lhs.size() * sizeof (double));
+}
+
+static
+void
+compare (
+	gomi::collate_kernel_t kernel,
+	const gomi::collate_input_t& input
+	)
+{
+	gomi::collate_output_t reference, output;
+	gomi::CollateScalar (input, &reference);
+	if (!gomi::Collate (kernel, input, &output))
+		return;
+	EXPECT(is_identical (output.avg_pc, reference.avg_pc));
+	EXPECT(is_identical (output.avg_nonzero_pc, reference.avg_nonzero_pc));
+	EXPECT(output.average_volume == reference.average_volume);
+	EXPECT(output.average_nonzero_volume == reference.average_nonzero_volume);
+	EXPECT(output.total_moves == reference.total_moves);
+	EXPECT(output.maximum_moves == reference.maximum_moves);
+	EXPECT(output.minimum_moves == reference.minimum_moves);
+	EXPECT(output.smallest_moves == reference.smallest_moves);
+	EXPECT(output.accumulated_volume == reference.accumulated_volume);
+	EXPECT(output.trading_day_count == reference.trading_day_count);
+}
+
+/* Symbol counts span partial and whole vectors of both kernels, every symbol
+ * one pattern or all symbols the same pattern.
+ */
+static
+void
+test_kernel (
+	gomi::collate_kernel_t kernel
+	)
+{
+	const size_t symbol_counts[] = { 1, 2, 3, 4, 5, 7, 8, 9, 1001 };
+	const unsigned day_counts[] = { 1, 2, 20 };
+	for (size_t i = 0; i < sizeof (symbol_counts) / sizeof (symbol_counts[0]); ++i) {
+		for (size_t j = 0; j < sizeof (day_counts) / sizeof (day_counts[0]); ++j) {
+			const unsigned day_count = day_counts[j];
+			for (int uniform = -1; uniform < PATTERN_COUNT; ++uniform) {
+				gomi::collate_input_t input;
+				input.Resize (day_count, symbol_counts[i]);
+				const unsigned window_ends[] = { 0, 4, 9, 19 };
+				for (size_t w = 0; w < sizeof (window_ends) / sizeof (window_ends[0]); ++w)
+					if (window_ends[w] < day_count)
+						input.window_end.push_back (window_ends[w]);
+				for (size_t s = 0; s < input.symbol_count; ++s)
+					fill ((pattern_e)(uniform < 0 ? s % PATTERN_COUNT : uniform), s, &input);
+				compare (kernel, input);
+/* volume and moves over the leading days only */
+				if (day_count > 1) {
+					input.analytic_day_count = day_count / 2;
+					compare (kernel, input);
+				}
+			}
+		}
+	}
+}
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	const gomi::collate_kernel_t kernels[] = { gomi::COLLATE_KERNEL_SSE42, gomi::COLLATE_KERNEL_AVX2 };
+	const char* names[] = { "SSE4.2", "AVX2" };
+	for (size_t k = 0; k < sizeof (kernels) / sizeof (kernels[0]); ++k) {
+		gomi::collate_input_t input;
+		input.Resize (1, 1);
+		gomi::collate_output_t output;
+		if (!gomi::Collate (kernels[k], input, &output)) {
+			fprintf (stderr, "%s kernel not supported, skipped.\n", names[k]);
+			continue;
+		}
+		test_kernel (kernels[k]);
+	}
+	return unittest::Result();
+}
+
+/* eof */
@@ -3,16 +3,50 @@
 
 #include "config.hh"
 
+#include <algorithm>
+
 #include "chromium/logging.hh"
+#include "chromium/string_split.hh"
 
 gomi::config_t::config_t() :
 /* default values */
 	is_snmp_enabled (false),
-	is_agentx_subagent (true)
+	is_agentx_subagent (true),
+	windows ("10,15,20"),
+	is_look_ahead_enabled (false)
 {
 /* C++11 initializer lists not supported in MSVC2010 */
 }
 
+gomi::fidset_t::fidset_t() :
+	RdmAverageVolumeId (0),
+	RdmAverageNonZeroVolumeId (0),
+	RdmTotalMovesId (0),
+	RdmMaximumMovesId (0),
+	RdmMinimumMovesId (0),
+	RdmSmallestMovesId (0)
+{
+}
+
+bool
+gomi::config_t::GetWindows (
+	std::vector<unsigned>* window_list
+	) const
+{
+	std::vector<std::string> tokens;
+	chromium::SplitString (windows, ',', &tokens);
+	window_list->clear();
+	for (auto it = tokens.begin(); it != tokens.end(); ++it) {
+		const long value = std::atol (it->c_str());
+		if (value <= 0)
+			return false;
+		window_list->push_back ((unsigned)value);
+	}
+	std::sort (window_list->begin(), window_list->end());
+	return !window_list->empty() &&
+		window_list->end() == std::adjacent_find (window_list->begin(), window_list->end());
+}
+
 /* Minimal error handling parsing of an Xml node pulled from the
  * Analytics Engine.
  *
@@ -66,6 +100,18 @@ gomi::config_t::validate()
 			LOG(ERROR) << "Undefined user name for <session name=\"" << it->session_name << "\">.";
 			return false;
 		}
+		if (!it->queue_capacity.empty() && std::atol (it->queue_capacity.c_str()) <= 0) {
+			LOG(ERROR) << "Invalid queue capacity \"" << it->queue_capacity << "\" for <session name=\"" << it->session_name << "\">.";
+			return false;
+		}
+		if (std::atol (it->publish_rate.c_str()) < 0 || std::atol (it->publish_burst.c_str()) < 0) {
+			LOG(ERROR) << "Invalid publish rate \"" << it->publish_rate << "\" or burst \"" << it->publish_burst << "\" for <session name=\"" << it->session_name << "\">.";
+			return false;
+		}
+		if (std::atol (it->publish_byte_rate.c_str()) < 0 || std::atol (it->publish_byte_burst.c_str()) < 0) {
+			LOG(ERROR) << "Invalid publish byte rate \"" << it->publish_byte_rate << "\" or burst \"" << it->publish_byte_burst << "\" for <session name=\"" << it->session_name << "\">.";
+			return false;
+		}
 	}
 	if (monitor_name.empty()) {
 		LOG(ERROR) << "Undefined monitor name.";
@@ -113,18 +159,68 @@ gomi::config_t::validate()
 		LOG(ERROR) << "Undefined default analytic time period.";
 		return false;
 	}
+	std::vector<unsigned> window_list;
+	if (!GetWindows (&window_list)) {
+		LOG(ERROR) << "Invalid percentage change windows \"" << windows << "\".";
+		return false;
+	}
+	if (!worker_count.empty()) {
+		value = std::atol (worker_count.c_str());
+		if (value <= 0) {
+			LOG(ERROR) << "Invalid worker count \"" << worker_count << "\".";
+			return false;
+		}
+	}
+	if (!intraday_index.empty()) {
+		value = std::atol (intraday_index.c_str());
+		if (value < 0) {
+			LOG(ERROR) << "Invalid intraday index symbol count \"" << intraday_index << "\".";
+			return false;
+		}
+	}
+	if (!stream_interval.empty()) {
+		value = std::atol (stream_interval.c_str());
+		if (value < 0) {
+			LOG(ERROR) << "Invalid stream interval \"" << stream_interval << "\".";
+			return false;
+		}
+	}
+	if (!batch_size.empty()) {
+		value = std::atol (batch_size.c_str());
+		if (value <= 0) {
+			LOG(ERROR) << "Invalid batch size \"" << batch_size << "\".";
+			return false;
+		}
+	}
+	if (!scan_strategy.empty() && scan_strategy != "symbol" && scan_strategy != "batch" && scan_strategy != "range" && scan_strategy != "adaptive") {
+		LOG(ERROR) << "Invalid scan strategy \"" << scan_strategy << "\".";
+		return false;
+	}
+/* streamed trades of today are only merged by single symbol scans */
+	if (!scan_strategy.empty() && scan_strategy != "symbol" && !stream_interval.empty() && std::atol (stream_interval.c_str()) > 0) {
+		LOG(ERROR) << "Scan strategy \"" << scan_strategy << "\" cannot be used with stream interval \"" << stream_interval << "\", use \"symbol\".";
+		return false;
+	}
+	if (!tick_source.empty() && tick_source != "flexrecord" && tick_source != "cursor" && tick_source != "synthetic") {
+		LOG(ERROR) << "Invalid tick source \"" << tick_source << "\".";
+		return false;
+	}
+/* every window requires both an n-day and n-trading-day FID */
+	auto has_window_fids = [&window_list](const fidset_t& fidset) -> bool {
+		for (auto it = window_list.begin(); it != window_list.end(); ++it) {
+			if (0 == fidset.RdmDayPercentChangeIds.count (*it) ||
+			    0 == fidset.RdmTradingDayPercentChangeIds.count (*it))
+				return false;
+		}
+		return true;
+	};
 	if (!archive_fids.RdmAverageVolumeId ||
 	    !archive_fids.RdmAverageNonZeroVolumeId ||
 	    !archive_fids.RdmTotalMovesId ||
 	    !archive_fids.RdmMaximumMovesId ||
 	    !archive_fids.RdmMinimumMovesId ||
 	    !archive_fids.RdmSmallestMovesId ||
-	    !archive_fids.Rdm10DayPercentChangeId ||
-	    !archive_fids.Rdm15DayPercentChangeId ||
-	    !archive_fids.Rdm20DayPercentChangeId ||
-	    !archive_fids.Rdm10TradingDayPercentChangeId ||
-	    !archive_fids.Rdm15TradingDayPercentChangeId ||
-	    !archive_fids.Rdm20TradingDayPercentChangeId )
+	    !has_window_fids (archive_fids))
 	{
 		LOG(ERROR) << "Undefined archive FID set.";
 		return false;
@@ -142,12 +238,7 @@ gomi::config_t::validate()
 		    !it->second.RdmMaximumMovesId ||
 		    !it->second.RdmMinimumMovesId ||
 		    !it->second.RdmSmallestMovesId ||
-		    !it->second.Rdm10DayPercentChangeId ||
-		    !it->second.Rdm15DayPercentChangeId ||
-		    !it->second.Rdm20DayPercentChangeId ||
-		    !it->second.Rdm10TradingDayPercentChangeId ||
-		    !it->second.Rdm15TradingDayPercentChangeId ||
-		    !it->second.Rdm20TradingDayPercentChangeId)
+		    !has_window_fids (it->second))
 		{
 			LOG(ERROR) << "Undefined realtime FID set.";
 			return false;
@@ -391,6 +482,16 @@ gomi::config_t::parseSessionNode (
 		LOG(ERROR) << "Undefined \"name\" attribute, value cannot be empty.";
 		return false;
 	}
+/* queueCapacity="messages" */
+	session.queue_capacity = xml.transcode (elem->getAttribute (L"queueCapacity"));
+/* publishRate="messages/second" */
+	session.publish_rate = xml.transcode (elem->getAttribute (L"publishRate"));
+/* publishBurst="messages" */
+	session.publish_burst = xml.transcode (elem->getAttribute (L"publishBurst"));
+/* publishByteRate="bytes/second" */
+	session.publish_byte_rate = xml.transcode (elem->getAttribute (L"publishByteRate"));
+/* publishByteBurst="bytes" */
+	session.publish_byte_burst = xml.transcode (elem->getAttribute (L"publishByteBurst"));
 
 /* <publisher> */
 	nodeList = elem->getElementsByTagName (L"publisher");
@@ -602,9 +703,53 @@ gomi::config_t::parseGomiNode (
 	attr = xml.transcode (elem->getAttribute (L"dayCount"));
 	if (!attr.empty())
 		day_count = attr;
+/* windows="days,days,..." */
+	attr = xml.transcode (elem->getAttribute (L"windows"));
+	if (!attr.empty())
+		windows = attr;
+/* barStore="file" */
+	attr = xml.transcode (elem->getAttribute (L"barStore"));
+	if (!attr.empty())
+		bar_store = attr;
+/* workerCount="threads" */
+	attr = xml.transcode (elem->getAttribute (L"workerCount"));
+	if (!attr.empty())
+		worker_count = attr;
+/* tickSource="flexrecord|cursor|synthetic" */
+	attr = xml.transcode (elem->getAttribute (L"tickSource"));
+	if (!attr.empty())
+		tick_source = attr;
+/* tradeView="view name" */
+	attr = xml.transcode (elem->getAttribute (L"tradeView"));
+	if (!attr.empty())
+		trade_view = attr;
+/* calendar="file" */
+	attr = xml.transcode (elem->getAttribute (L"calendar"));
+	if (!attr.empty())
+		calendar = attr;
+/* intradayIndex="symbols" */
+	attr = xml.transcode (elem->getAttribute (L"intradayIndex"));
+	if (!attr.empty())
+		intraday_index = attr;
+/* streamInterval="seconds" */
+	attr = xml.transcode (elem->getAttribute (L"streamInterval"));
+	if (!attr.empty())
+		stream_interval = attr;
+/* batchSize="symbols" */
+	attr = xml.transcode (elem->getAttribute (L"batchSize"));
+	if (!attr.empty())
+		batch_size = attr;
+/* scanStrategy="symbol|batch|range|adaptive" */
+	attr = xml.transcode (elem->getAttribute (L"scanStrategy"));
+	if (!attr.empty())
+		scan_strategy = attr;
+/* lookAhead="bool" */
+	attr = xml.transcode (elem->getAttribute (L"lookAhead"));
+	if (!attr.empty())
+		is_look_ahead_enabled = (0 == attr.compare ("true"));
 
 /* reset all lists */
-	ZeroMemory (&archive_fids, sizeof (archive_fids));
+	archive_fids = fidset_t();
 	realtime_fids.clear();
 	bins.clear();
 /* <fields> */
@@ -719,13 +864,17 @@ gomi::config_t::parseFidNode (
 	else if ("NM_HIGH" == name)	fid = &fidset.RdmMaximumMovesId;
 	else if ("NM_LOW" == name)	fid = &fidset.RdmMinimumMovesId;
 	else if ("NM_SMALL" == name)	fid = &fidset.RdmSmallestMovesId;
-	else if ("PCTCHG_10D" == name)	fid = &fidset.Rdm10DayPercentChangeId;
-	else if ("PCTCHG_15D" == name)	fid = &fidset.Rdm15DayPercentChangeId;
-	else if ("PCTCHG_20D" == name)	fid = &fidset.Rdm20DayPercentChangeId;
-	else if ("PCTCHG_10T" == name)	fid = &fidset.Rdm10TradingDayPercentChangeId;
-	else if ("PCTCHG_15T" == name)	fid = &fidset.Rdm15TradingDayPercentChangeId;
-	else if ("PCTCHG_20T" == name)	fid = &fidset.Rdm20TradingDayPercentChangeId;
-	else {
+	else if (0 == name.compare (0, 7, "PCTCHG_") && name.size() > 8) {
+/* PCTCHG_<n>D or PCTCHG_<n>T for window n */
+		const std::string days = name.substr (7, name.size() - 8);
+		const char suffix = name[name.size() - 1];
+		const long window = std::atol (days.c_str());
+		if (window > 0 && days.npos == days.find_first_not_of ("0123456789")) {
+			if ('D' == suffix)		fid = &fidset.RdmDayPercentChangeIds[(unsigned)window];
+			else if ('T' == suffix)		fid = &fidset.RdmTradingDayPercentChangeIds[(unsigned)window];
+		}
+	}
+	if (nullptr == fid) {
 		LOG(ERROR) << "Unknown \"name\" attribute value \"" << name << "\".";
 		return false;
 	}
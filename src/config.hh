@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -57,10 +58,28 @@ namespace gomi
  * Range: "" (None) or "<IPv4 address>/hostname" or "<IPv4 address>/net"
  */
 		std::string position;
+
+/* Maximum messages pending in the outbound queue of the session, messages
+ * published whilst full are dropped and the streams re-imaged.
+ * Range: "" (Default 65536) or any positive integer.
+ */
+		std::string queue_capacity;
+
+/* Publish pacing of the session, message and byte rates per second each
+ * with a burst passing unpaced, e.g. at bin close.
+ * Range: "" or "0" (Unpaced) or any positive integer, bursts default to the
+ * rate of one second.
+ */
+		std::string publish_rate;
+		std::string publish_burst;
+		std::string publish_byte_rate;
+		std::string publish_byte_burst;
 	};
 
 	struct fidset_t
 	{
+		fidset_t();
+
 /* VMA_20D: Volume moving average. */
 		int	RdmAverageVolumeId;
 /* VMA_20TD: Volume moving average for non-zero trading days, i.e. no halts. */
@@ -73,18 +92,10 @@ namespace gomi
 		int	RdmMinimumMovesId;
 /* SMCNT_20D: Smallest days trade count */
 		int	RdmSmallestMovesId;
-/* PCTCHG_10D: 10-day percentage change in price */
-		int	Rdm10DayPercentChangeId;
-/* PCTCHG_15D: 15-day percentage change in price */
-		int	Rdm15DayPercentChangeId;
-/* PCTCHG_20D: 20-day percentage change in price */
-		int	Rdm20DayPercentChangeId;
-/* PCTCHG_10TD: 10-trading-day percentage change in price */
-		int	Rdm10TradingDayPercentChangeId;
-/* PCTCHG_15TD: 15-trading-day percentage change in price */
-		int	Rdm15TradingDayPercentChangeId;
-/* PCTCHG_20TD: 20-trading-day percentage change in price */
-		int	Rdm20TradingDayPercentChangeId;
+/* PCTCHG_<n>D: n-day percentage change in price, keyed by window n */
+		std::map<unsigned, int>	RdmDayPercentChangeIds;
+/* PCTCHG_<n>T: n-trading-day percentage change in price, keyed by window n */
+		std::map<unsigned, int>	RdmTradingDayPercentChangeIds;
 	};
 
 	struct config_t
@@ -117,6 +128,9 @@ namespace gomi
 
 		bool validate();
 
+/* ascending percentage change windows, returns false on invalid content */
+		bool GetWindows (std::vector<unsigned>* windows) const;
+
 //  SNMP implant.
 		bool is_snmp_enabled;
 
@@ -176,6 +190,39 @@ namespace gomi
 //  Default analytic time period
 		std::string day_count;
 
+//  Comma separated percentage change windows in business days, e.g. "5,10,15,20,60,90", history extends to the longest.
+		std::string windows;
+
+//  File path for memory mapped store of finished day bars, empty to disable.
+		std::string bar_store;
+
+//  Count of calculation threads, each with a private FlexRecord work area.
+		std::string worker_count;
+
+//  Trade source: "flexrecord" (default), "cursor" for the FlexRecord Cursor API, or "synthetic" for testing without data.
+		std::string tick_source;
+
+//  FlexRecord view holding the trade fields, empty for the full Trade view.
+		std::string trade_view;
+
+//  File path for business day calendar replacing TBSDK, for testing.
+		std::string calendar;
+
+//  Count of symbols retained in the minute index for Tcl queries, empty or zero to disable.
+		std::string intraday_index;
+
+//  Seconds between polls of today's trades into the minute index, empty or zero to disable streaming.
+		std::string stream_interval;
+
+//  Count of symbols read together per refresh scan, empty or one to read each symbol alone.
+		std::string batch_size;
+
+//  Refresh scan strategy: "symbol", "batch", "range" for one read per symbol over the analytic period, or "adaptive" to choose per batch by measured cost, default per batch size, only "symbol" with a stream interval.
+		std::string scan_strategy;
+
+//  Calculate the history of the next bins between bin closes.
+		bool is_look_ahead_enabled;
+
 //  FIDs for archival and realtime records.
 		fidset_t archive_fids;
 		std::map<std::string, fidset_t> realtime_fids;
@@ -205,6 +252,11 @@ namespace gomi
 			", \"instance_id\": \"" << session.instance_id << "\""
 			", \"user_name\": \"" << session.user_name << "\""
 			", \"position\": \"" << session.position << "\""
+			", \"queue_capacity\": \"" << session.queue_capacity << "\""
+			", \"publish_rate\": \"" << session.publish_rate << "\""
+			", \"publish_burst\": \"" << session.publish_burst << "\""
+			", \"publish_byte_rate\": \"" << session.publish_byte_rate << "\""
+			", \"publish_byte_burst\": \"" << session.publish_byte_burst << "\""
 			" }";
 		return o;
 	}
@@ -217,14 +269,20 @@ namespace gomi
 			", \"NUM_MOVES\": " << fidset.RdmTotalMovesId <<
 			", \"NM_HIGH\": " << fidset.RdmMaximumMovesId <<
 			", \"NM_LOW\": " << fidset.RdmMinimumMovesId <<
-			", \"NM_SMALL\": " << fidset.RdmSmallestMovesId <<
-			", \"PCTCHG_10D\": " << fidset.Rdm10DayPercentChangeId <<
-			", \"PCTCHG_15D\": " << fidset.Rdm15DayPercentChangeId <<
-			", \"PCTCHG_20D\": " << fidset.Rdm20DayPercentChangeId <<
-			", \"PCTCHG_10T\": " << fidset.Rdm10TradingDayPercentChangeId <<
-			", \"PCTCHG_15T\": " << fidset.Rdm15TradingDayPercentChangeId <<
-			", \"PCTCHG_20T\": " << fidset.Rdm20TradingDayPercentChangeId <<
-			" }";
+			", \"NM_SMALL\": " << fidset.RdmSmallestMovesId;
+		for (auto it = fidset.RdmDayPercentChangeIds.begin();
+			it != fidset.RdmDayPercentChangeIds.end();
+			++it)
+		{
+			o << ", \"PCTCHG_" << it->first << "D\": " << it->second;
+		}
+		for (auto it = fidset.RdmTradingDayPercentChangeIds.begin();
+			it != fidset.RdmTradingDayPercentChangeIds.end();
+			++it)
+		{
+			o << ", \"PCTCHG_" << it->first << "T\": " << it->second;
+		}
+		o << " }";
 		return o;
 	}
 
@@ -257,6 +315,17 @@ namespace gomi
 			", \"tz\": \"" << config.tz << "\""
 			", \"tzdb\": \"" << config.tzdb << "\""
 			", \"day_count\": \"" << config.day_count << "\""
+			", \"windows\": \"" << config.windows << "\""
+			", \"bar_store\": \"" << config.bar_store << "\""
+			", \"worker_count\": \"" << config.worker_count << "\""
+			", \"tick_source\": \"" << config.tick_source << "\""
+			", \"trade_view\": \"" << config.trade_view << "\""
+			", \"calendar\": \"" << config.calendar << "\""
+			", \"intraday_index\": \"" << config.intraday_index << "\""
+			", \"stream_interval\": \"" << config.stream_interval << "\""
+			", \"batch_size\": \"" << config.batch_size << "\""
+			", \"scan_strategy\": \"" << config.scan_strategy << "\""
+			", \"is_look_ahead_enabled\": " << (0 == config.is_look_ahead_enabled ? "false" : "true") << ""
 			", \"archive_fids\": " << config.archive_fids <<
 			", \"realtime_fids\": { ";
 		for (auto it = config.realtime_fids.begin();
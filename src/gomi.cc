@@ -14,7 +14,17 @@
 #include "chromium/file_util.hh"
 #include "chromium/logging.hh"
 #include "chromium/string_split.hh"
+#include "bar_store.hh"
+#include "activity_index.hh"
+#include "calendar.hh"
+#include "intraday_index.hh"
+#include "period_table.hh"
+#include "scan_planner.hh"
+#include "tick_source.hh"
+#include "tick_stream.hh"
+#include "worker_pool.hh"
 #include "gomi_bin.hh"
+#include "gomi_scan.hh"
 #include "snmp_agent.hh"
 #include "error.hh"
 #include "rfa_logging.hh"
@@ -48,6 +58,24 @@ static const char* kDefaultTickVolumeField = "TickVolume";
 /* Special last 10-minute bin name */
 static const char* kLast10MinuteBinName = "10MIN";
 
+/* Calendar days resolved per TBSDK calendar load. */
+static const int kCalendarDays = 400;
+
+/* Symbols per worker per look-ahead slice, pending queries wait at most one slice. */
+static const size_t kLookAheadSlice = 4;
+
+/* Milliseconds between look-ahead checks of pending queries. */
+static const unsigned kLookAheadYield = 50;
+
+/* Mean seconds between trades of the synthetic tick source. */
+static const unsigned kSyntheticTickInterval = 5;
+
+/* Symbols per batch of adaptive scans without configured batch size. */
+static const size_t kDefaultBatchSize = 64;
+
+/* Estimated bytes of message header, attributes and field list framing. */
+static const size_t kMsgOverhead = 48;
+
 /* http://en.wikipedia.org/wiki/Unix_epoch */
 static const boost::gregorian::date kUnixEpoch (1970, 1, 1);
 
@@ -70,6 +98,88 @@ to_unix_epoch (
 	return (t - boost::posix_time::ptime (kUnixEpoch)).total_seconds();
 }
 
+/* Estimated RWF encoding of a field entry: 2-byte id, 1-byte length and the
+ * value, i.e. hint and minimal mantissa bytes, 3-byte time or 4-byte date.
+ */
+static inline
+size_t
+field_size (
+	const gomi::field_value_t& value
+	)
+{
+	switch (value.type) {
+	case gomi::field_value_t::REAL:
+		{
+			size_t n = 1;
+			while (n < 8 && (value.value >= ((int64_t)1 << (8 * n - 1)) || value.value < -((int64_t)1 << (8 * n - 1))))
+				++n;
+			return 3 + 1 + n;
+		}
+	case gomi::field_value_t::TIME:
+		return 3 + 3;
+	case gomi::field_value_t::DATE:
+		return 3 + 4;
+	default:
+		return 3;
+	}
+}
+
+/* Append a field value to the publish set of a stream.
+ */
+static inline
+void
+add_field (
+	std::vector<gomi::field_value_t>* values,
+	int fid,
+	int type,
+	int64_t value,
+	uint8_t hint
+	)
+{
+	gomi::field_value_t field_value;
+	field_value.fid = fid;
+	field_value.type = type;
+	field_value.value = value;
+	field_value.hint = hint;
+	values->push_back (field_value);
+}
+
+static inline
+void
+add_real (
+	std::vector<gomi::field_value_t>* values,
+	int fid,
+	int64_t mantissa,
+	uint8_t hint
+	)
+{
+	add_field (values, fid, gomi::field_value_t::REAL, mantissa, hint);
+}
+
+/* rfa(hh:mm:ss) from tm, packed as hhmmss */
+static inline
+void
+add_time (
+	std::vector<gomi::field_value_t>* values,
+	int fid,
+	const struct tm& tm
+	)
+{
+	add_field (values, fid, gomi::field_value_t::TIME, tm.tm_hour * 10000 + tm.tm_min * 100 + tm.tm_sec, 0);
+}
+
+/* rfa(yyyy-mm-dd) from tm(yyyy-1900, 0-11, 1-31), packed as yyyymmdd */
+static inline
+void
+add_date (
+	std::vector<gomi::field_value_t>* values,
+	int fid,
+	const struct tm& tm
+	)
+{
+	add_field (values, fid, gomi::field_value_t::DATE, (1900 + tm.tm_year) * 10000 + (1 + tm.tm_mon) * 100 + tm.tm_mday, 0);
+}
+
 /* parse from /bin/ decls formatted as <name>=<start>-<end>, e.g. "OPEN=09:00-09:33"
  */
 static
@@ -131,11 +241,30 @@ ReadSymbolMap (
 	return true;
 }
 
+/* Bar store layout key of a bin decl, any change discards the stored bars.
+ */
+static
+std::string
+to_bar_store_key (
+	const gomi::bin_decl_t& bin_decl
+	)
+{
+	std::ostringstream ss;
+	ss << bin_decl.bin_name << ' '
+	   << boost::posix_time::to_simple_string (bin_decl.bin_start) << '-'
+	   << boost::posix_time::to_simple_string (bin_decl.bin_end);
+	return ss.str();
+}
+
 gomi::gomi_t::gomi_t()
 	:
 	is_shutdown_ (false),
 	manager_ (nullptr),
+	history_day_count_ (0),
 	last_refresh_ (boost::posix_time::not_a_date_time),
+	period_table_ (new period_table_t()),
+	scan_planner_ (new scan_planner_t()),
+	activity_index_ (new activity_index_t()),
 	last_activity_ (boost::posix_time::microsec_clock::universal_time()),
 	min_tcl_time_ (boost::posix_time::pos_infin),
 	max_tcl_time_ (boost::posix_time::neg_infin),
@@ -146,6 +275,8 @@ gomi::gomi_t::gomi_t()
 {
 	ZeroMemory (cumulative_stats_, sizeof (cumulative_stats_));
 	ZeroMemory (snap_stats_, sizeof (snap_stats_));
+	look_ahead_generation_ = 0;
+	is_look_ahead_running_ = false;
 
 /* Unique instance number, never decremented. */
 	instance_ = InterlockedExchangeAdd (&instance_count_, 1L);
@@ -173,6 +304,24 @@ gomi::gomi_t::IsSpecialBin (const gomi::bin_decl_t& bin)
 	return (it != config_.realtime_fids.end());
 }
 
+/* Tick source as configured, each source is used by only one thread.
+ *
+ * Returns nullptr on failure.
+ */
+std::shared_ptr<gomi::tick_source_t>
+gomi::gomi_t::CreateTickSource()
+{
+	if ("synthetic" == config_.tick_source)
+		return std::make_shared<synthetic_tick_source_t> (kSyntheticTickInterval);
+/* fields of the bin analytics */
+	if ("cursor" == config_.tick_source)
+		return std::make_shared<flexrecord_cursor_tick_source_t> (trade_fields_);
+	auto source = std::make_shared<flexrecord_tick_source_t> (manager_, config_.trade_view, trade_fields_);
+	if (!source->Init())
+		return nullptr;
+	return source;
+}
+
 /* Plugin entry point from the Velocity Analytics Engine.
  */
 
@@ -220,14 +369,7 @@ gomi::gomi_t::Init()
 
 	try {
 /* FlexRecord cursor */
-		manager_ = FlexRecDefinitionManager::GetInstance (nullptr);
-		work_area_.reset (manager_->AcquireWorkArea(), [this](FlexRecWorkAreaElement* work_area){ manager_->ReleaseWorkArea (work_area); });
-		view_element_.reset (manager_->AcquireView(), [this](FlexRecViewElement* view_element){ manager_->ReleaseView (view_element); });
-
-		if (!manager_->GetView ("Trade", view_element_->view)) {
-			LOG(ERROR) << "FlexRecDefinitionManager::GetView failed";
-			return false;
-		}
+		manager_ = FlexRecDefinitionManager::GetInstance (nullptr);
 	} catch (std::exception& e) {
 		LOG(ERROR) << "FlexRecord::Exception: { "
 			"\"What\": \"" << e.what() << "\""
@@ -253,8 +395,14 @@ gomi::gomi_t::Init()
 	}
 
 	try {
+/* percentage change windows share one history of day bars */
+		const unsigned day_count = std::stoi (config_.day_count);
+		if (!config_.GetWindows (&windows_)) {
+			LOG(ERROR) << "Cannot parse percentage change windows.";
+			return false;
+		}
+		history_day_count_ = std::max (day_count, windows_.back());
 /* /bin/ declarations */
-		const auto day_count = std::stoi (config_.day_count);
 		for (auto it = config_.bins.begin(); it != config_.bins.end(); ++it)
 		{
 			bin_decl_t bin;
@@ -262,6 +410,7 @@ gomi::gomi_t::Init()
 				LOG(ERROR) << "Cannot parse bin delcs.";
 				return false;
 			}
+			SetBinParameters (&bin);
 			bins_.insert (bin);
 		}
 	} catch (std::exception& e) {
@@ -399,6 +548,94 @@ gomi::gomi_t::Init()
 		return false;
 	}
 
+	try {
+/* trade fields as read by the archive bins, the defaults of Tcl query bins without symbols */
+		std::vector<bin_t*> bins;
+		for (auto it = query_vector_.begin(); it != query_vector_.end(); ++it)
+			std::for_each (it->second.first.begin(), it->second.first.end(), [&bins](const std::shared_ptr<bin_t>& bin) {
+				bins.push_back (bin.get());
+			});
+		if (bins.empty()) {
+			trade_fields_.last_price = kDefaultLastPriceField;
+			trade_fields_.tick_volume = kDefaultTickVolumeField;
+		} else if (!GetTradeFields (bins, &trade_fields_)) {
+			LOG(ERROR) << "Cannot resolve one set of trade fields for all bins.";
+			return false;
+		}
+
+/* one tick source per worker, work areas cannot be shared between threads */
+		const unsigned worker_count = config_.worker_count.empty() ? 1 : std::stoul (config_.worker_count);
+		std::vector<std::shared_ptr<tick_source_t>> sources;
+		for (unsigned i = 0; i < worker_count; ++i) {
+			auto source = CreateTickSource();
+			if (!(bool)source)
+				return false;
+			sources.push_back (source);
+		}
+		pool_.reset (new worker_pool_t (sources));
+		if (!(bool)pool_)
+			return false;
+	} catch (std::exception& e) {
+		LOG(ERROR) << "FlexRecord::Exception: { "
+			"\"What\": \"" << e.what() << "\""
+			" }";
+		return false;
+	}
+
+	try {
+/* Restore finished day bars from previous sessions. */
+		if (!WarmStart())
+			return false;
+	} catch (std::exception& e) {
+		LOG(ERROR) << "BarStore::Exception: { "
+			"\"What\": \"" << e.what() << "\" }";
+		return false;
+	}
+
+	try {
+/* Minute index of ad-hoc Tcl queries and of streamed trades of today. */
+		const size_t index_limit = config_.intraday_index.empty() ? 0 : std::stoul (config_.intraday_index);
+		const unsigned stream_interval = config_.stream_interval.empty() ? 0 : std::stoul (config_.stream_interval);
+		if (index_limit > 0 || stream_interval > 0) {
+			intraday_index_.reset (new intraday_index_t (index_limit + (stream_interval > 0 ? stream_vector_.size() : 0)));
+			if (!(bool)intraday_index_)
+				return false;
+		}
+		if (stream_interval > 0) {
+			auto source = CreateTickSource();
+			if (!(bool)source)
+				return false;
+			std::vector<std::string> symbols;
+			std::for_each (stream_vector_.begin(), stream_vector_.end(), [&symbols](const std::shared_ptr<realtime_stream_t>& stream) {
+				symbols.push_back (stream->symbol_name);
+			});
+			tick_stream_.reset (new tick_stream_t (source, intraday_index_.get(), symbols, TZ_, stream_interval));
+			if (!(bool)tick_stream_)
+				return false;
+			stream_thread_.reset (new boost::thread ([this](){ tick_stream_->Run(); }));
+			if (!(bool)stream_thread_)
+				return false;
+		}
+	} catch (std::exception& e) {
+		LOG(ERROR) << "TickStream::Exception: { "
+			"\"What\": \"" << e.what() << "\" }";
+		return false;
+	}
+
+	try {
+/* Idle time calculation of the history of the next bins. */
+		if (config_.is_look_ahead_enabled) {
+			look_ahead_thread_.reset (new boost::thread ([this](){ LookAheadRun(); }));
+			if (!(bool)look_ahead_thread_)
+				return false;
+			ScheduleLookAhead();
+		}
+	} catch (std::exception& e) {
+		LOG(ERROR) << "LookAhead::Exception: { "
+			"\"What\": \"" << e.what() << "\" }";
+		return false;
+	}
+
 	try {
 /* No main loop inside this thread, must spawn new thread for message pump. */
 		event_pump_.reset (new event_pump_t (event_queue_));
@@ -487,6 +724,27 @@ gomi::gomi_t::Clear()
 /* Close SNMP agent. */
 	snmp_agent_.reset();
 
+/* Stop trade ingestion. */
+	if (stream_thread_) {
+		stream_thread_->interrupt();
+		stream_thread_->join();
+	}
+	stream_thread_.reset();
+	tick_stream_.reset();
+
+/* Stop look-ahead after the running slice, before the workers it uses. */
+	if (look_ahead_thread_) {
+		CancelLookAhead();
+		look_ahead_thread_->interrupt();
+		look_ahead_thread_->join();
+	}
+	look_ahead_thread_.reset();
+	look_ahead_cache_.clear();
+
+/* Stop calculation threads and release work areas. */
+	pool_.reset();
+	intraday_index_.reset();
+
 /* Signal message pump thread to exit. */
 	if ((bool)event_queue_)
 		event_queue_->deactivate();
@@ -498,6 +756,10 @@ gomi::gomi_t::Clear()
 	event_thread_.reset();
 	event_pump_.reset();
 	query_vector_.clear();
+	if ((bool)bar_store_)
+		bar_store_->Flush();
+	bar_store_.reset();
+	calendar_.reset();
 	assert (provider_.use_count() <= 1);
 	provider_.reset();
 	assert (log_.use_count() <= 1);
@@ -691,13 +953,22 @@ gomi::gomi_t::TimeRefresh()
 	}
 
 /* constant iterator in C++11 */
-	unsigned bin_refresh_count = 0;
+	std::vector<bin_decl_t> refresh_bins;
 	for (auto it = bins_.find (bin_decl);
 		it != bins_.end() && it->bin_end == bin_decl.bin_end;
 		++it)
 	{
-		BinRefresh (*it);
-		++bin_refresh_count;
+		refresh_bins.push_back (*it);
+	}
+
+/* single pass over all bins closing at this time */
+	const unsigned bin_refresh_count = (unsigned)refresh_bins.size();
+	if (bin_refresh_count > 0) {
+		CancelLookAhead();
+		BinCalculate (refresh_bins);
+		std::for_each (refresh_bins.begin(), refresh_bins.end(), [this](const bin_decl_t& bin_decl) {
+			BinRefresh (bin_decl);
+		});
 	}
 
 	if (0 == bin_refresh_count) {
@@ -717,6 +988,7 @@ gomi::gomi_t::TimeRefresh()
 	last_refresh_ = bin_decl.bin_end;
 
 	SummaryRefresh (last_refresh_);
+	ScheduleLookAhead();
 
 /* Timing */
 	const ptime t1 (microsec_clock::universal_time());
@@ -725,6 +997,10 @@ gomi::gomi_t::TimeRefresh()
 	if (td < min_refresh_time_) min_refresh_time_ = td;
 	if (td > max_refresh_time_) max_refresh_time_ = td;
 	total_refresh_time_ += td;
+
+/* commit the day's bars to disk once publishing is done */
+	if ((bool)bar_store_ && bins_.rbegin()->bin_end == last_refresh_)
+		bar_store_->Flush();
 	return true;
 }
 
@@ -739,6 +1015,9 @@ gomi::gomi_t::DayRefresh()
 	last_activity_ = t0;
 
 	LOG(INFO) << "DayRefresh";
+	CancelLookAhead();
+/* republish full images rather than updates */
+	provider_->ResetImages();
 
 /* Calculate affected bins */
 	const auto now_utc = second_clock::universal_time();
@@ -750,7 +1029,13 @@ gomi::gomi_t::DayRefresh()
 		for (auto jt = it->second.first.begin(); jt != it->second.first.end(); ++jt)
 			(*jt)->Clear();
 
-	for (auto it = bins_.begin(); it != bins_.end() && it->bin_end <= now_td; ++it) {
+	std::vector<bin_decl_t> refresh_bins;
+	for (auto it = bins_.begin(); it != bins_.end() && it->bin_end <= now_td; ++it)
+		refresh_bins.push_back (*it);
+
+/* single pass over every closed bin */
+	BinCalculate (refresh_bins);
+	for (auto it = refresh_bins.begin(); it != refresh_bins.end(); ++it) {
 		BinRefresh (*it);
 
 /* save this iteration time to prevent replay */
@@ -758,6 +1043,7 @@ gomi::gomi_t::DayRefresh()
 	}
 
 	SummaryRefresh (last_refresh_);
+	ScheduleLookAhead();
 
 /* Timing */
 	const ptime t1 (microsec_clock::universal_time());
@@ -780,23 +1066,31 @@ gomi::gomi_t::Recalculate()
 	last_activity_ = t0;
 
 	LOG(INFO) << "Recalculate";
+	CancelLookAhead();
+	look_ahead_cache_.clear();
+	provider_->ResetImages();
 
 /* Calculate affected bins */
 	const auto now_utc = second_clock::universal_time();
 	const local_date_time now_tz (now_utc, TZ_);
 	const auto now_td = now_tz.local_time().time_of_day();
 
-/* constant iterator in C++11 */
+/* constant iterator in C++11, discard cached day bars to re-read full history */
 	for (auto it = query_vector_.begin(); it != query_vector_.end(); ++it)
-		for (auto jt = it->second.first.begin(); jt != it->second.first.end(); ++jt)
+		for (auto jt = it->second.first.begin(); jt != it->second.first.end(); ++jt) {
 			(*jt)->Clear();
+			(*jt)->Reset();
+		}
 
-	std::for_each (bins_.begin(), bins_.end(), [this](const bin_decl_t& bin_decl) {
+	const std::vector<bin_decl_t> refresh_bins (bins_.begin(), bins_.end());
+	BinCalculate (refresh_bins);
+	std::for_each (refresh_bins.begin(), refresh_bins.end(), [this](const bin_decl_t& bin_decl) {
 		BinRefresh (bin_decl);
 	});
 
 /* clear iteration time */
 	last_refresh_ = boost::posix_time::not_a_date_time;
+	ScheduleLookAhead();
 
 /* Timing */
 	const ptime t1 (microsec_clock::universal_time());
@@ -808,31 +1102,633 @@ gomi::gomi_t::Recalculate()
 	return true;
 }
 
+/* Discard cached day bars of /symbols/ on /date/ overlapping the local time
+ * period [start, end) after late or corrected trades.  Bins closed today are
+ * recalculated for those symbols only and their streams republished, other
+ * bins read the discarded days again at their next close.  Stored bars of the
+ * symbols on /date/ are erased for every bin so that a restart cannot restore
+ * them.
+ */
 bool
-gomi::gomi_t::BinRefresh (
-	const gomi::bin_decl_t& ref_bin
+gomi::gomi_t::Invalidate (
+	const std::vector<std::string>& symbols,
+	const boost::gregorian::date& date,
+	const boost::posix_time::time_duration& start,
+	const boost::posix_time::time_duration& end
 	)
 {
+	using namespace boost::posix_time;
+	using namespace boost::local_time;
+	const ptime t0 (microsec_clock::universal_time());
+	last_activity_ = t0;
+
+	LOG(INFO) << "Invalidate (date: \"" << to_simple_string (date) << "\""
+		", start: \"" << to_simple_string (start) << "\""
+		", end: \"" << to_simple_string (end) << "\""
+		", symbols: " << symbols.size() << ")";
+
+/* affected time period in UTC */
+	const local_date_time start_ldt (date, start, TZ_, local_date_time::NOT_DATE_TIME_ON_ERROR);
+	const local_date_time end_ldt (date, end, TZ_, local_date_time::NOT_DATE_TIME_ON_ERROR);
+	if (start_ldt.is_not_a_date_time() || end_ldt.is_not_a_date_time()) {
+		LOG(ERROR) << "Invalid time period on " << to_simple_string (date) << ".";
+		return false;
+	}
+	const time_window_t window (to_unix_epoch<__time32_t> (start_ldt.utc_time()), to_unix_epoch<__time32_t> (end_ldt.utc_time()));
+
+	CancelLookAhead();
+/* copies of invalidated day bars, re-calculated by the next look-ahead */
+	look_ahead_cache_.clear();
+
+/* quiet periods and indexed days no longer hold */
+	const std::set<std::string> symbol_set (symbols.begin(), symbols.end());
+	std::for_each (symbol_set.begin(), symbol_set.end(), [&](const std::string& symbol) {
+		activity_index_->Forget (symbol.c_str(), window);
+		if ((bool)intraday_index_)
+			intraday_index_->Invalidate (symbol.c_str(), window);
+	});
+
+/* symbol offsets, identical in every bin */
+	std::vector<size_t> indices;
+	if (!query_vector_.empty()) {
+		const auto& v = query_vector_.begin()->second.first;
+		for (size_t j = 0; j < v.size(); ++j) {
+			if (0 != symbol_set.count (v[j]->GetSymbolName()))
+				indices.push_back (j);
+		}
+	}
+
+/* mark affected day bars dirty */
+	const local_date_time now_tz (second_clock::universal_time(), TZ_);
+	const auto now_td = now_tz.local_time().time_of_day();
+	std::vector<bin_decl_t> refresh_bins;
+	unsigned bar_count = 0;
+	for (auto it = query_vector_.begin(); it != query_vector_.end(); ++it) {
+		unsigned count = 0;
+		std::for_each (indices.begin(), indices.end(), [&](size_t j) {
+			count += it->second.first[j]->Invalidate (window.first, window.second);
+		});
+		if (count > 0 && it->first.bin_end <= now_td)
+			refresh_bins.push_back (it->first);
+		bar_count += count;
+	}
+	LOG(INFO) << "Invalidated " << bar_count << " day bars of " << indices.size() << " symbols, "
+		<< refresh_bins.size() << " bins to recalculate.";
+
+/* stored bars of bins not recalculated now would otherwise be restored on warm start */
+	if ((bool)bar_store_ && !indices.empty()) {
+		const int block = bar_store_->FindDay (date);
+		if (-1 != block) {
+			for (unsigned i = 0; i < bins_.size(); ++i) {
+				std::for_each (indices.begin(), indices.end(), [&](size_t j) {
+					bar_store_->Erase (block, (unsigned)j, i);
+				});
+			}
+		}
+	}
+
+	if (!refresh_bins.empty()) {
 /* fixed /bin/ parameters */
-	bin_decl_t bin_decl (ref_bin);
-	bin_decl.bin_tz = TZ_;
-	bin_decl.bin_day_count = std::stoi (config_.day_count);
+		std::vector<bin_decl_t> bin_decls (refresh_bins);
+		std::for_each (bin_decls.begin(), bin_decls.end(), [&](bin_decl_t& bin_decl) {
+			SetBinParameters (&bin_decl);
+		});
+		std::vector<std::vector<std::shared_ptr<bin_t>>*> v;
+		std::for_each (bin_decls.begin(), bin_decls.end(), [&](const bin_decl_t& bin_decl) {
+			v.push_back (&query_vector_[bin_decl].first);
+		});
+
+/* re-read only the dirty day bars of affected symbols */
+		const auto today_in_tz = now_tz.local_time().date();
+		const scan_t scan (*GetCalendar (today_in_tz), period_table_.get(), activity_index_.get(), today_in_tz, bin_decls);
+		pool_->ParallelFor (indices.size(), [&](size_t n, tick_source_t* source) {
+			std::vector<bin_t*> bins (v.size());
+			for (size_t i = 0; i < v.size(); ++i)
+				bins[i] = (*v[i])[indices[n]].get();
+			scan.Calculate (bins, source, (bool)tick_stream_ ? intraday_index_.get() : nullptr);
+		});
+		for (size_t i = 0; i < v.size(); ++i) {
+			std::vector<bin_t*> bins;
+			std::for_each (indices.begin(), indices.end(), [&](size_t j) {
+				bins.push_back ((*v[i])[j].get());
+			});
+			CollateBins (bins);
+		}
+		if ((bool)bar_store_)
+			PersistBars (scan, bin_decls, v);
 
-	LOG(INFO) << "BinRefresh (bin: " << bin_decl << ")";
+		std::for_each (refresh_bins.begin(), refresh_bins.end(), [&](const bin_decl_t& bin_decl) {
+			BinRefresh (bin_decl, &symbol_set);
+		});
+		if (!last_refresh_.is_not_a_date_time())
+			SummaryRefresh (last_refresh_, &symbol_set);
+	}
+	ScheduleLookAhead();
+
+/* Timing */
+	const ptime t1 (microsec_clock::universal_time());
+	const time_duration td = t1 - t0;
+	LOG(INFO) << "Invalidate complete " << td.total_milliseconds() << "ms";
+	return true;
+}
+
+/* Calculate a set of bins for every symbol with a single pass per symbol
+ * and business day over the union of all bin time periods, with a single
+ * pass per symbol over the analytic period, or with a single pass per batch
+ * of symbols and business day.  Adaptive scans group symbols of similar
+ * activity and pick the cheapest pass per batch.
+ */
+bool
+gomi::gomi_t::BinCalculate (
+	const std::vector<gomi::bin_decl_t>& ref_bins
+	)
+{
+	if (ref_bins.empty())
+		return true;
+
+/* fixed /bin/ parameters */
+	std::vector<bin_decl_t> bin_decls (ref_bins);
+	std::for_each (bin_decls.begin(), bin_decls.end(), [&](bin_decl_t& bin_decl) {
+		SetBinParameters (&bin_decl);
+		LOG(INFO) << "BinCalculate (bin: " << bin_decl << ")";
+	});
 
 /* refreshes last /x/ business days, i.e. executing on a holiday will only refresh the cache contents */
-	auto& v = query_vector_[bin_decl];
+	std::vector<std::vector<std::shared_ptr<bin_t>>*> v;
+	std::for_each (bin_decls.begin(), bin_decls.end(), [&](const bin_decl_t& bin_decl) {
+		v.push_back (&query_vector_[bin_decl].first);
+		DCHECK_EQ (v.front()->size(), v.back()->size());
+	});
 
 	DVLOG(3) << "processing query.";
 	using namespace boost::local_time;
-	const auto now_in_tz = local_sec_clock::local_time (bin_decl.bin_tz);
+	const auto now_in_tz = local_sec_clock::local_time (TZ_);
+	const auto today_in_tz = now_in_tz.local_time().date();
+	const scan_t scan (*GetCalendar (today_in_tz), period_table_.get(), activity_index_.get(), today_in_tz, bin_decls);
+/* adopt bar caches calculated ahead of this close */
+	if (look_ahead_cache_date_ == today_in_tz) {
+		for (size_t i = 0; i < bin_decls.size(); ++i) {
+			auto it = look_ahead_cache_.find (bin_decls[i]);
+			if (look_ahead_cache_.end() == it || it->second.size() != v[i]->size())
+				continue;
+			for (size_t j = 0; j < v[i]->size(); ++j)
+				(*v[i])[j]->SwapCache (*it->second[j]);
+			look_ahead_cache_.erase (it);
+		}
+	}
+/* split symbols across workers, bins of one symbol are never shared */
+	const size_t symbol_count = v.front()->size();
+	auto get_bins = [&v](size_t j) -> std::vector<bin_t*> {
+		std::vector<bin_t*> bins (v.size());
+		for (size_t i = 0; i < v.size(); ++i)
+			bins[i] = (*v[i])[j].get();
+		return bins;
+	};
+/* today's streamed trades are taken from the intraday index by single symbol scans */
+	size_t batch_size = config_.batch_size.empty() ? 1 : std::stoul (config_.batch_size);
+	std::string strategy (config_.scan_strategy);
+	if (strategy.empty())
+		strategy = (batch_size > 1) ? "batch" : "symbol";
+	if ((bool)tick_stream_ && "symbol" != strategy) {
+		LOG(INFO) << "Scan strategy \"" << strategy << "\" replaced by \"symbol\" to merge streamed trades.";
+		strategy = "symbol";
+	}
+	if ("symbol" == strategy || "range" == strategy)
+		batch_size = 1;
+	else if ("adaptive" == strategy && config_.batch_size.empty())
+		batch_size = kDefaultBatchSize;
+
+/* order symbols by expected trades so that liquid and thin names fall in separate batches */
+	std::vector<size_t> order (symbol_count);
+	std::vector<std::pair<uint64_t, uint64_t>> cost (symbol_count);
+	for (size_t j = 0; j < symbol_count; ++j) {
+		order[j] = j;
+		if ("adaptive" == strategy)
+			scan.EstimateCost (get_bins (j), &cost[j].first, &cost[j].second);
+	}
+	if ("adaptive" == strategy) {
+		std::stable_sort (order.begin(), order.end(), [&cost](size_t lhs, size_t rhs) {
+			return cost[lhs].second < cost[rhs].second;
+		});
+	}
+	const size_t batch_count = (symbol_count + batch_size - 1) / batch_size;
+	std::vector<scan_strategy_t> plan (batch_count, ("symbol" == strategy) ? SCAN_PER_SYMBOL : (("range" == strategy) ? SCAN_RANGE : SCAN_BATCH));
+	if ("adaptive" == strategy) {
+		for (size_t k = 0; k < batch_count; ++k) {
+			uint64_t symbols = 0, days = 0, reads = 0, ticks = 0;
+			for (size_t n = k * batch_size; n < std::min (symbol_count, (k + 1) * batch_size); ++n) {
+				++symbols;
+				days = std::max (days, cost[order[n]].first);
+				reads += cost[order[n]].first;
+				ticks += cost[order[n]].second;
+			}
+			plan[k] = scan_planner_->Choose (symbols, days, reads, ticks);
+		}
+	}
+
+	pool_->ParallelFor (batch_count, [&](size_t k, tick_source_t* source) {
+		using namespace boost::posix_time;
+		const ptime t0 (microsec_clock::universal_time());
+		scan_stats_t stats = { 0, 0, 0 };
+		if (SCAN_BATCH == plan[k]) {
+/* one read per batch of symbols and business day */
+			std::vector<std::vector<bin_t*>> batch;
+			for (size_t n = k * batch_size; n < std::min (symbol_count, (k + 1) * batch_size); ++n)
+				batch.push_back (get_bins (order[n]));
+			scan.CalculateBatch (batch, source, &stats);
+		} else if (SCAN_RANGE == plan[k]) {
+/* one read per symbol from the earliest open to the latest close */
+			for (size_t n = k * batch_size; n < std::min (symbol_count, (k + 1) * batch_size); ++n)
+				scan.CalculateRange (get_bins (order[n]), source, &stats);
+		} else {
+			for (size_t n = k * batch_size; n < std::min (symbol_count, (k + 1) * batch_size); ++n)
+				scan.Calculate (get_bins (order[n]), source, (bool)tick_stream_ ? intraday_index_.get() : nullptr, &stats);
+		}
+		const ptime t1 (microsec_clock::universal_time());
+		scan_planner_->Record (plan[k], stats.reads, stats.rows, stats.ticks, (t1 - t0).total_microseconds() / 1e6);
+	});
+/* collate all symbols of a bin at once */
+	pool_->ParallelFor (v.size(), [&](size_t i, tick_source_t* source) {
+		std::vector<bin_t*> bins;
+		bins.reserve (v[i]->size());
+		std::for_each (v[i]->begin(), v[i]->end(), [&bins](const std::shared_ptr<bin_t>& bin) {
+			bins.push_back (bin.get());
+		});
+		CollateBins (bins);
+	});
+	DVLOG(3) << "query complete.";
+
+/* save finished day bars for the next warm start */
+	if ((bool)bar_store_)
+		PersistBars (scan, bin_decls, v);
+	return true;
+}
+
+/* Queue history calculation of the bins of the next close, replacing any
+ * pending look-ahead.
+ */
+void
+gomi::gomi_t::ScheduleLookAhead()
+{
+	if (!(bool)look_ahead_thread_)
+		return;
+
+	using namespace boost::local_time;
+	boost::posix_time::ptime next_close;
+	if (!GetNextBinClose (TZ_, &next_close))
+		return;
+	const local_date_time next_close_tz (next_close, TZ_);
+	bin_decl_t bin_decl;
+	bin_decl.bin_end = next_close_tz.local_time().time_of_day();
+	std::vector<bin_decl_t> bins;
+	for (auto it = bins_.find (bin_decl); it != bins_.end() && it->bin_end == bin_decl.bin_end; ++it)
+		bins.push_back (*it);
+	if (bins.empty())
+		return;
+
+	boost::lock_guard<boost::mutex> lock (look_ahead_lock_);
+	look_ahead_bins_.swap (bins);
+	look_ahead_date_ = next_close_tz.local_time().date();
+	++look_ahead_generation_;
+	look_ahead_cond_.notify_all();
+}
+
+/* Cancel pending and running look-ahead, returns once no look-ahead bins are
+ * being calculated.
+ */
+void
+gomi::gomi_t::CancelLookAhead()
+{
+	if (!(bool)look_ahead_thread_)
+		return;
+	boost::unique_lock<boost::mutex> lock (look_ahead_lock_);
+	look_ahead_bins_.clear();
+	++look_ahead_generation_;
+	while (is_look_ahead_running_)
+		look_ahead_cond_.wait (lock);
+}
+
+bool
+gomi::gomi_t::IsLookAheadCancelled (
+	uint64_t generation
+	)
+{
+	boost::lock_guard<boost::mutex> lock (look_ahead_lock_);
+	return generation != look_ahead_generation_;
+}
+
+/* Look-ahead thread entry, returns on thread interruption.
+ */
+void
+gomi::gomi_t::LookAheadRun()
+{
+	LOG(INFO) << "Look-ahead started.";
+	try {
+		while (true) {
+			std::vector<bin_decl_t> bins;
+			boost::gregorian::date date;
+			uint64_t generation;
+			{
+				boost::unique_lock<boost::mutex> lock (look_ahead_lock_);
+				while (look_ahead_bins_.empty())
+					look_ahead_cond_.wait (lock);
+				bins.swap (look_ahead_bins_);
+				date = look_ahead_date_;
+				generation = look_ahead_generation_;
+				is_look_ahead_running_ = true;
+			}
+			try {
+				LookAhead (bins, date, generation);
+			} catch (boost::thread_interrupted&) {
+				throw;
+			} catch (std::exception& e) {
+				LOG(ERROR) << "LookAhead::Exception: { "
+					"\"What\": \"" << e.what() << "\" }";
+/* worker pool rethrows any task exception */
+			} catch (...) {
+				LOG(ERROR) << "LookAhead::Exception: { "
+					"\"What\": \"unknown\" }";
+			}
+			{
+				boost::lock_guard<boost::mutex> lock (look_ahead_lock_);
+				is_look_ahead_running_ = false;
+			}
+			look_ahead_cond_.notify_all();
+		}
+	} catch (boost::thread_interrupted&) {
+		LOG(INFO) << "Look-ahead stopped.";
+	}
+}
+
+/* Calculate and cache every day bar of /bins/ and the open time period of the
+ * first effective business day up to a watermark, so that the bin close only
+ * reads the trades since the watermark.  Bars are calculated on copies of the
+ * bar caches of the published bins, which BinCalculate() adopts at the close
+ * on /date/, the published bins and their analytic results are only read.
+ * Runs in small slices on the worker pool, yielding to waiting queries
+ * between slices.
+ *
+ * Returns false if cancelled.
+ */
+bool
+gomi::gomi_t::LookAhead (
+	const std::vector<bin_decl_t>& ref_bins,
+	const boost::gregorian::date& date,
+	uint64_t generation
+	)
+{
+	using namespace boost::posix_time;
+	const ptime t0 (microsec_clock::universal_time());
+
+/* fixed /bin/ parameters */
+	std::vector<bin_decl_t> bin_decls (ref_bins);
+	std::for_each (bin_decls.begin(), bin_decls.end(), [&](bin_decl_t& bin_decl) {
+		SetBinParameters (&bin_decl);
+	});
+
+/* private copies of the bar caches, the look-ahead never inserts into query_vector_ */
+	look_ahead_cache_.clear();
+	look_ahead_cache_date_ = date;
+	std::vector<std::vector<std::shared_ptr<bin_t>>*> v;
+	for (auto it = bin_decls.begin(); it != bin_decls.end(); ++it) {
+		const auto jt = query_vector_.find (*it);
+		if (query_vector_.end() == jt)
+			return false;
+		auto kt = look_ahead_cache_.emplace (std::make_pair (jt->first, std::vector<std::shared_ptr<bin_t>>())).first;
+		auto& cache = kt->second;
+		cache.reserve (jt->second.first.size());
+		std::for_each (jt->second.first.begin(), jt->second.first.end(), [&](const std::shared_ptr<bin_t>& bin) {
+			auto copy = std::make_shared<bin_t> (kt->first, bin->GetSymbolName(), bin->GetLastPriceField().c_str(), bin->GetTickVolumeField().c_str());
+			assert ((bool)copy);
+			copy->CopyCache (*bin);
+			cache.push_back (copy);
+		});
+		v.push_back (&cache);
+	}
+
+	const scan_t scan (*GetCalendar (date), period_table_.get(), activity_index_.get(), date, bin_decls);
+	const size_t symbol_count = v.front()->size();
+	const size_t slice = kLookAheadSlice * pool_->GetWorkerCount();
+	for (size_t j = 0; j < symbol_count; j += slice) {
+/* Tcl queries and refreshes take precedence */
+		while (pool_->HasWaiting()) {
+			if (IsLookAheadCancelled (generation))
+				return false;
+			boost::this_thread::sleep (milliseconds (kLookAheadYield));
+		}
+		if (IsLookAheadCancelled (generation))
+			return false;
+/* workers reference the task until complete */
+		boost::this_thread::disable_interruption di;
+		pool_->ParallelFor (std::min (slice, symbol_count - j), [&](size_t k, tick_source_t* source) {
+			if (IsLookAheadCancelled (generation))
+				return;
+			std::vector<bin_t*> bins (v.size());
+			for (size_t i = 0; i < v.size(); ++i)
+				bins[i] = (*v[i])[j + k].get();
+			scan.CalculateHistory (bins, source);
+		});
+	}
+
+	const ptime t1 (microsec_clock::universal_time());
+	LOG(INFO) << "Look-ahead of " << bin_decls.size() << " bins for " << to_simple_string (date)
+		<< " complete " << (t1 - t0).total_milliseconds() << "ms";
+	return true;
+}
+
+/* Business day calendar covering the analytic period ending /date/, or the
+ * longer /query_day_count/ business days of a query, loaded once and
+ * re-loaded on date roll or a longer query.  Never null, an unusable calendar
+ * yields empty scans.
+ */
+std::shared_ptr<const gomi::calendar_t>
+gomi::gomi_t::GetCalendar (
+	const boost::gregorian::date& date,
+	unsigned query_day_count
+	)
+{
+	boost::lock_guard<boost::mutex> lock (calendar_lock_);
+	const int day_count = (int)std::max (history_day_count_, query_day_count);
+/* ample margin for weekends and holidays */
+	const boost::gregorian::date_duration history (std::max (kCalendarDays / 2, 2 * day_count + 30));
+
+/* time periods of days before the analytic period are never read again */
+	period_table_->Expire (date - history);
+	activity_index_->Expire (to_unix_epoch<__time32_t> (boost::posix_time::ptime (date - history)));
+	if ((bool)intraday_index_)
+		intraday_index_->Expire (date - history);
+
+	if ((bool)calendar_) {
+/* file calendars are fixed */
+		if (!config_.calendar.empty())
+			return calendar_;
+		if (!calendar_->GetFirstDate().is_not_a_date() &&
+		    date <= calendar_->GetLastDate() &&
+		    date - history >= calendar_->GetFirstDate())
+		{
+			return calendar_;
+		}
+	}
+
+	auto calendar = std::make_shared<calendar_t>();
+	if (!config_.calendar.empty()) {
+		calendar->LoadFile (config_.calendar);
+	} else {
+		const boost::gregorian::date_duration span (std::max (kCalendarDays, 2 * (int)history.days()));
+		calendar->Load (date - span, date + boost::gregorian::date_duration (7));
+	}
+	calendar_ = calendar;
+	return calendar_;
+}
+
+/* Fixed /bin/ parameters of every configured bin: day bars cover the longest
+ * window, volume and moves analytics only the configured analytic period.
+ */
+void
+gomi::gomi_t::SetBinParameters (
+	bin_decl_t* bin_decl
+	) const
+{
+	bin_decl->bin_tz = TZ_;
+	bin_decl->bin_day_count = history_day_count_;
+	bin_decl->bin_analytic_day_count = std::stoi (config_.day_count);
+	bin_decl->bin_windows = windows_;
+}
+
+/* Map the bar store and populate the day bar cache of every bin with the
+ * stored finished bars, a following refresh then only reads bars not stored,
+ * i.e. the current business day.
+ *
+ * Returns false on error, a missing or unusable store is not an error.
+ */
+bool
+gomi::gomi_t::WarmStart()
+{
+	if (config_.bar_store.empty())
+		return true;
+
+/* layout: symbols in publish order, bins in close time order */
+	std::vector<std::string> symbols, bin_keys;
+	std::for_each (stream_vector_.begin(), stream_vector_.end(), [&symbols](const std::shared_ptr<realtime_stream_t>& stream) {
+		symbols.push_back (stream->symbol_name);
+	});
+	std::for_each (bins_.begin(), bins_.end(), [&bin_keys](const bin_decl_t& bin_decl) {
+		bin_keys.push_back (to_bar_store_key (bin_decl));
+	});
+	if (symbols.empty() || bin_keys.empty())
+		return true;
+
+	bar_store_.reset (new bar_store_t());
+	if (!(bool)bar_store_)
+		return false;
+	if (!bar_store_->Open (config_.bar_store, symbols, bin_keys, history_day_count_)) {
+		LOG(WARNING) << "Bar store unavailable, continuing with full history scans.";
+		bar_store_.reset();
+		return true;
+	}
+
+/* business days of the analytic period as per BinCalculate */
+	std::vector<bin_decl_t> bin_decls (bins_.begin(), bins_.end());
+	std::for_each (bin_decls.begin(), bin_decls.end(), [&](bin_decl_t& bin_decl) {
+		SetBinParameters (&bin_decl);
+	});
+	using namespace boost::local_time;
+	const auto now_in_tz = local_sec_clock::local_time (TZ_);
 	const auto today_in_tz = now_in_tz.local_time().date();
-	auto work_area = work_area_.get();
-	auto view_element = view_element_.get();	
-	std::for_each (v.first.begin(), v.first.end(), [today_in_tz, work_area, view_element](std::shared_ptr<bin_t>& it) {
-		it->Calculate (today_in_tz, work_area, view_element);
+	const scan_t scan (*GetCalendar (today_in_tz), period_table_.get(), activity_index_.get(), today_in_tz, bin_decls);
+	const auto& days = scan.GetDays();
+	if (days.empty())
+		return true;
+
+	std::vector<int> blocks;
+	std::for_each (days.begin(), days.end(), [&](const scan_day_t& day) {
+		blocks.push_back (bar_store_->FindDay (day.date));
 	});
-	DVLOG(3) << "query complete, publishing analytic results.";
+
+	unsigned bar_count = 0;
+	for (unsigned i = 0; i < bin_decls.size(); ++i) {
+		auto& v = query_vector_[bin_decls[i]].first;
+		for (unsigned j = 0; j < v.size(); ++j) {
+			auto& bin = v[j];
+			bin->Reset (days[0].date);
+			for (unsigned t = 0; t < days.size() && t < bin->GetBarCount(); ++t) {
+				stored_bar_t stored_bar;
+				if (-1 == blocks[t] || !bar_store_->Read (blocks[t], j, i, &stored_bar))
+					continue;
+				auto& bar = bin->GetBar (t);
+				bar.SetTimePeriod (days[t].windows[i].first, days[t].windows[i].second);
+				bar.Restore (stored_bar.open_price, stored_bar.close_price, stored_bar.number_moves, stored_bar.accumulated_volume);
+				++bar_count;
+			}
+		}
+	}
+	LOG(INFO) << "Restored " << bar_count << " day bars from bar store.";
+	return true;
+}
+
+/* Write finished day bars of a calculated set of bins to the bar store,
+ * business days are taken from the calculating scan.  Pages are left dirty
+ * for the system to write back, an explicit flush only follows the last bin
+ * close of the day and shutdown so that no bin close waits on the disk.
+ *
+ * Returns false on error.
+ */
+bool
+gomi::gomi_t::PersistBars (
+	const scan_t& scan,
+	const std::vector<gomi::bin_decl_t>& ref_bins,
+	const std::vector<std::vector<std::shared_ptr<bin_t>>*>& v
+	)
+{
+	const auto& days = scan.GetDays();
+	if (days.empty())
+		return true;
+
+/* blocks taken on first finished bar of a day */
+	std::vector<int> blocks (days.size(), -1);
+	unsigned bar_count = 0;
+	for (unsigned i = 0; i < ref_bins.size(); ++i) {
+		const auto it = bins_.find (ref_bins[i]);
+		if (bins_.end() == it)
+			continue;
+		const unsigned bin_index = (unsigned)std::distance (bins_.begin(), it);
+		for (unsigned j = 0; j < v[i]->size(); ++j) {
+			auto& bin = (*v[i])[j];
+/* calculated on a different business day */
+			if (bin->GetCacheDate() != days[0].date)
+				continue;
+			for (unsigned t = 0; t < days.size() && t < bin->GetBarCount(); ++t) {
+				auto& bar = bin->GetBar (t);
+				if (!bar.IsFinal())
+					continue;
+				if (-1 == blocks[t])
+					blocks[t] = bar_store_->AppendDay (days[t].date);
+				stored_bar_t stored_bar;
+				stored_bar.open_price = bar.GetOpenPrice();
+				stored_bar.close_price = bar.GetClosePrice();
+				stored_bar.number_moves = bar.GetNumberMoves();
+				stored_bar.accumulated_volume = bar.GetAccumulatedVolume();
+				bar_store_->Write (blocks[t], j, bin_index, stored_bar);
+				++bar_count;
+			}
+		}
+	}
+	DVLOG(3) << "persisted " << bar_count << " day bars.";
+	return true;
+}
+
+/* Publish analytic results of a calculated bin, only of the symbols in
+ * /symbol_set/ when provided.
+ */
+bool
+gomi::gomi_t::BinRefresh (
+	const gomi::bin_decl_t& bin_decl,
+	const std::set<std::string>* symbol_set
+	)
+{
+	LOG(INFO) << "BinRefresh (bin: " << bin_decl << ")";
+
+	auto& v = query_vector_[bin_decl];
 
 /**  (i) Refresh realtime RIC **/
 
@@ -889,113 +1785,63 @@ gomi::gomi_t::BinRefresh (
 	status.setStatusCode (rfa::common::RespStatus::NoneEnum);
 	response.setRespStatus (status);
 
+/* Update carrying only fields changed since the last image or update. */
+	rfa::message::RespMsg update (false);	/* reference */
+	update.setMsgModelType (rfa::rdm::MMT_MARKET_PRICE);
+	update.setRespType (rfa::message::RespMsg::UpdateEnum);
+	update.setRespTypeNum (rfa::rdm::INSTRUMENT_UPDATE_UNSPECIFIED);
+	update.setAttribInfo (attribInfo);
+
 	std::for_each (v.second.begin(), v.second.end(), [&](std::shared_ptr<archive_stream_t>& stream)
 	{
+		if (nullptr != symbol_set && 0 == symbol_set->count (stream->bin->GetSymbolName()))
+			return;
 		VLOG(1) << "Publishing to stream " << stream->rfa_name;
 		attribInfo.setName (stream->rfa_name);
 
-/* Clear required for SingleWriteIterator state machine. */
-		auto& it = single_write_it_;
-		DCHECK (it.isInitialized());
-		it.clear();
-		it.start (fields_);
-
-/* For each field set the Id via a FieldEntry bound to the iterator followed by setting the data.
- * The iterator API provides setters for common types excluding 32-bit floats, with fallback to 
- * a generic DataBuffer API for other types or support of pre-calculated values.
- */
-		rfa::data::FieldEntry field (false);
+		auto& values = field_values_;
+		values.clear();
 /* TIMACT */
-		field.setFieldID (kRdmTimeOfUpdateId);
-		it.bind (field);
-		it.setTime (_tm.tm_hour, _tm.tm_min, _tm.tm_sec, 0 /* ms */);
-
+		add_time (&values, kRdmTimeOfUpdateId, _tm);
 /* PRICE field is a rfa::Real64 value specified as <mantissa>  10?.
  * Rfa deprecates setting via <double> data types so we create a mantissa from
  * source value and consider that we publish to 6 decimal places.
  */
-/* PCTCHG_10D */
-		field.setFieldID (config_.archive_fids.Rdm10DayPercentChangeId);
-		it.bind (field);
-		it.setReal (portware::mantissa (stream->bin->GetTenDayPercentageChange()), rfa::data::ExponentNeg6);
-/* PCTCHG_15D */
-		field.setFieldID (config_.archive_fids.Rdm15DayPercentChangeId);
-		it.bind (field);
-		it.setReal (portware::mantissa (stream->bin->GetFifteenDayPercentageChange()), rfa::data::ExponentNeg6);
-/* PCTCHG_20D */
-		field.setFieldID (config_.archive_fids.Rdm20DayPercentChangeId);
-		it.bind (field);
-		it.setReal (portware::mantissa (stream->bin->GetTwentyDayPercentageChange()), rfa::data::ExponentNeg6);
-/* PCTCHG_10T */
-		field.setFieldID (config_.archive_fids.Rdm10TradingDayPercentChangeId);
-		it.bind (field);
-		it.setReal (portware::mantissa (stream->bin->GetTenTradingDayPercentageChange()), rfa::data::ExponentNeg6);
-/* PCTCHG_15T */
-		field.setFieldID (config_.archive_fids.Rdm15TradingDayPercentChangeId);
-		it.bind (field);
-		it.setReal (portware::mantissa (stream->bin->GetFifteenTradingDayPercentageChange()), rfa::data::ExponentNeg6);
-/* PCTCHG_20T */
-		field.setFieldID (config_.archive_fids.Rdm20TradingDayPercentChangeId);
-		it.bind (field);
-		it.setReal (portware::mantissa (stream->bin->GetTwentyTradingDayPercentageChange()), rfa::data::ExponentNeg6);
+/* PCTCHG_<n>D */
+		for (size_t i = 0; i < windows_.size(); ++i)
+			add_real (&values, config_.archive_fids.RdmDayPercentChangeIds.find (windows_[i])->second, portware::mantissa (stream->bin->GetDayPercentageChange (i)), rfa::data::ExponentNeg6);
+/* PCTCHG_<n>T */
+		for (size_t i = 0; i < windows_.size(); ++i)
+			add_real (&values, config_.archive_fids.RdmTradingDayPercentChangeIds.find (windows_[i])->second, portware::mantissa (stream->bin->GetTradingDayPercentageChange (i)), rfa::data::ExponentNeg6);
 /* VMA_20D */
-		field.setFieldID (config_.archive_fids.RdmAverageVolumeId);
-		it.bind (field);
-		it.setReal (stream->bin->GetAverageVolume(), rfa::data::Exponent0);
+		add_real (&values, config_.archive_fids.RdmAverageVolumeId, stream->bin->GetAverageVolume(), rfa::data::Exponent0);
 /* VMA_20TD */
-		field.setFieldID (config_.archive_fids.RdmAverageNonZeroVolumeId);
-		it.bind (field);
-		it.setReal (stream->bin->GetAverageNonZeroVolume(), rfa::data::Exponent0);
+		add_real (&values, config_.archive_fids.RdmAverageNonZeroVolumeId, stream->bin->GetAverageNonZeroVolume(), rfa::data::Exponent0);
 /* TRDCNT_20D */
-		field.setFieldID (config_.archive_fids.RdmTotalMovesId);
-		it.bind (field);
-		it.setReal (stream->bin->GetTotalMoves(), rfa::data::Exponent0);
+		add_real (&values, config_.archive_fids.RdmTotalMovesId, stream->bin->GetTotalMoves(), rfa::data::Exponent0);
 /* HICNT_20D */
-		field.setFieldID (config_.archive_fids.RdmMaximumMovesId);
-		it.bind (field);
-		it.setReal (stream->bin->GetMaximumMoves(), rfa::data::Exponent0);
+		add_real (&values, config_.archive_fids.RdmMaximumMovesId, stream->bin->GetMaximumMoves(), rfa::data::Exponent0);
 /* LOCNT_20D */
-		field.setFieldID (config_.archive_fids.RdmMinimumMovesId);
-		it.bind (field);
-		it.setReal (stream->bin->GetMinimumMoves(), rfa::data::Exponent0);
+		add_real (&values, config_.archive_fids.RdmMinimumMovesId, stream->bin->GetMinimumMoves(), rfa::data::Exponent0);
 /* SMCNT_20D */
-		field.setFieldID (config_.archive_fids.RdmSmallestMovesId);
-		it.bind (field);
-		it.setReal (stream->bin->GetSmallestMoves(), rfa::data::Exponent0);
+		add_real (&values, config_.archive_fids.RdmSmallestMovesId, stream->bin->GetSmallestMoves(), rfa::data::Exponent0);
 /* ACTIV_DATE */
-		field.setFieldID (kRdmActiveDateId);
-		it.bind (field);
-		const uint16_t year  = /* rfa(yyyy) */ 1900 + _tm.tm_year /* tm(yyyy-1900 */;
-		const uint8_t  month = /* rfa(1-12) */    1 + _tm.tm_mon  /* tm(0-11) */;
-		const uint8_t  day   = /* rfa(1-31) */        _tm.tm_mday /* tm(1-31) */;
-		it.setDate (year, month, day);
-
-		it.complete();
-		response.setPayload (fields_);
-
-#ifdef DEBUG
-/* 4.2.8 Message Validation.  RFA provides an interface to verify that
- * constructed messages of these types conform to the Reuters Domain
- * Models as specified in RFA API 7 RDM Usage Guide.
- */
-		RFA_String warningText;
-		const uint8_t validation_status = response.validateMsg (&warningText);
-		if (rfa::message::MsgValidationWarning == validation_status) {
-			LOG(ERROR) << "respMsg::validateMsg: { \"warningText\": \"" << warningText << "\" }";
-		} else {
-			assert (rfa::message::MsgValidationOk == validation_status);
-		}
-#endif
-		provider_->Send (stream.get(), &response);
+		add_date (&values, kRdmActiveDateId, _tm);
+
+		Publish (stream.get(), &response, &update);
 	});
 	return true;
 }
 
 /* Refresh summary bin analytics, i.e. the realtime set of bins including
- * a special last 10-minute bin derived from the current time-of-day.
+ * a special last 10-minute bin derived from the current time-of-day.  Only
+ * the symbols in /symbol_set/ are published when provided.
  */
 bool
-gomi::gomi_t::SummaryRefresh (const boost::posix_time::time_duration& time_of_day)
+gomi::gomi_t::SummaryRefresh (
+	const boost::posix_time::time_duration& time_of_day,
+	const std::set<std::string>* symbol_set
+	)
 {
 	using namespace boost::posix_time;
 	using namespace boost::local_time;
@@ -1119,74 +1965,46 @@ gomi::gomi_t::SummaryRefresh (const boost::posix_time::time_duration& time_of_da
 	status.setStatusCode (rfa::common::RespStatus::NoneEnum);
 	response.setRespStatus (status);
 
+/* Update carrying only fields changed since the last image or update. */
+	rfa::message::RespMsg update (false);	/* reference */
+	update.setMsgModelType (rfa::rdm::MMT_MARKET_PRICE);
+	update.setRespType (rfa::message::RespMsg::UpdateEnum);
+	update.setRespTypeNum (rfa::rdm::INSTRUMENT_UPDATE_UNSPECIFIED);
+	update.setAttribInfo (attribInfo);
+
+	const std::vector<unsigned>& windows = windows_;
 	std::for_each (stream_vector_.begin(), stream_vector_.end(), [&](std::shared_ptr<realtime_stream_t>& stream)
 	{
+		if (nullptr != symbol_set && 0 == symbol_set->count (stream->symbol_name))
+			return;
 		VLOG(1) << "publish: " << stream->rfa_name;
 		attribInfo.setName (stream->rfa_name);
 
-/* Clear required for SingleWriteIterator state machine. */
-		auto& it = single_write_it_;
-		DCHECK (it.isInitialized());
-		it.clear();
-		it.start (fields_);
-
-		rfa::data::FieldEntry field (false);
+		auto& values = field_values_;
+		values.clear();
 /* TIMACT */
-		field.setFieldID (kRdmTimeOfUpdateId);
-		it.bind (field);
-		it.setTime (_tm.tm_hour, _tm.tm_min, _tm.tm_sec, 0 /* ms */);
+		add_time (&values, kRdmTimeOfUpdateId, _tm);
 
-		auto add_fidset = [&it](const fidset_t& fids, std::shared_ptr<bin_t>& bin)
+		auto add_fidset = [&values, &windows](const fidset_t& fids, std::shared_ptr<bin_t>& bin)
 		{
-			rfa::data::FieldEntry field (false);
-/* PCTCHG_10D */
-			field.setFieldID (fids.Rdm10DayPercentChangeId);
-			it.bind (field);
-			it.setReal (portware::mantissa (bin->GetTenDayPercentageChange()), rfa::data::ExponentNeg6);
-/* PCTCHG_15D */
-			field.setFieldID (fids.Rdm15DayPercentChangeId);
-			it.bind (field);
-			it.setReal (portware::mantissa (bin->GetFifteenDayPercentageChange()), rfa::data::ExponentNeg6);
-/* PCTCHG_20D */
-			field.setFieldID (fids.Rdm20DayPercentChangeId);
-			it.bind (field);
-			it.setReal (portware::mantissa (bin->GetTwentyDayPercentageChange()), rfa::data::ExponentNeg6);
-/* PCTCHG_10T */
-			field.setFieldID (fids.Rdm10TradingDayPercentChangeId);
-			it.bind (field);
-			it.setReal (portware::mantissa (bin->GetTenTradingDayPercentageChange()), rfa::data::ExponentNeg6);
-/* PCTCHG_15T */
-			field.setFieldID (fids.Rdm15TradingDayPercentChangeId);
-			it.bind (field);
-			it.setReal (portware::mantissa (bin->GetFifteenTradingDayPercentageChange()), rfa::data::ExponentNeg6);
-/* PCTCHG_20T */
-			field.setFieldID (fids.Rdm20TradingDayPercentChangeId);
-			it.bind (field);
-			it.setReal (portware::mantissa (bin->GetTwentyTradingDayPercentageChange()), rfa::data::ExponentNeg6);
+/* PCTCHG_<n>D */
+			for (size_t i = 0; i < windows.size(); ++i)
+				add_real (&values, fids.RdmDayPercentChangeIds.find (windows[i])->second, portware::mantissa (bin->GetDayPercentageChange (i)), rfa::data::ExponentNeg6);
+/* PCTCHG_<n>T */
+			for (size_t i = 0; i < windows.size(); ++i)
+				add_real (&values, fids.RdmTradingDayPercentChangeIds.find (windows[i])->second, portware::mantissa (bin->GetTradingDayPercentageChange (i)), rfa::data::ExponentNeg6);
 /* VMA_20D */
-			field.setFieldID (fids.RdmAverageVolumeId);
-			it.bind (field);
-			it.setReal (bin->GetAverageVolume(), rfa::data::Exponent0);
+			add_real (&values, fids.RdmAverageVolumeId, bin->GetAverageVolume(), rfa::data::Exponent0);
 /* VMA_20TD */
-			field.setFieldID (fids.RdmAverageNonZeroVolumeId);
-			it.bind (field);
-			it.setReal (bin->GetAverageNonZeroVolume(), rfa::data::Exponent0);
+			add_real (&values, fids.RdmAverageNonZeroVolumeId, bin->GetAverageNonZeroVolume(), rfa::data::Exponent0);
 /* TRDCNT_20D */
-			field.setFieldID (fids.RdmTotalMovesId);
-			it.bind (field);
-			it.setReal (bin->GetTotalMoves(), rfa::data::Exponent0);
+			add_real (&values, fids.RdmTotalMovesId, bin->GetTotalMoves(), rfa::data::Exponent0);
 /* HICNT_20D */
-			field.setFieldID (fids.RdmMaximumMovesId);
-			it.bind (field);
-			it.setReal (bin->GetMaximumMoves(), rfa::data::Exponent0);
+			add_real (&values, fids.RdmMaximumMovesId, bin->GetMaximumMoves(), rfa::data::Exponent0);
 /* LOCNT_20D */
-			field.setFieldID (fids.RdmMinimumMovesId);
-			it.bind (field);
-			it.setReal (bin->GetMinimumMoves(), rfa::data::Exponent0);
+			add_real (&values, fids.RdmMinimumMovesId, bin->GetMinimumMoves(), rfa::data::Exponent0);
 /* SMCNT_20D */
-			field.setFieldID (fids.RdmSmallestMovesId);
-			it.bind (field);
-			it.setReal (bin->GetSmallestMoves(), rfa::data::Exponent0);
+			add_real (&values, fids.RdmSmallestMovesId, bin->GetSmallestMoves(), rfa::data::Exponent0);
 		};
 
 /* every special named bin analytic */
@@ -1200,32 +2018,99 @@ gomi::gomi_t::SummaryRefresh (const boost::posix_time::time_duration& time_of_da
 			add_fidset (stream->last_10min.first, stream->last_10min.second[last_10min_bin]->bin);
 
 /* ACTIV_DATE */
-		field.setFieldID (kRdmActiveDateId);
-		it.bind (field);
-		const uint16_t year  = /* rfa(yyyy) */ 1900 + _tm.tm_year /* tm(yyyy-1900 */;
-		const uint8_t  month = /* rfa(1-12) */    1 + _tm.tm_mon  /* tm(0-11) */;
-		const uint8_t  day   = /* rfa(1-31) */        _tm.tm_mday /* tm(1-31) */;
-		it.setDate (year, month, day);
-
-		it.complete();
-		response.setPayload (fields_);
-
-#ifdef DEBUG
-/* 4.2.8 Message Validation.  RFA provides an interface to verify that
- * constructed messages of these types conform to the Reuters Domain
- * Models as specified in RFA API 7 RDM Usage Guide.
+		add_date (&values, kRdmActiveDateId, _tm);
+
+		Publish (stream.get(), &response, &update);
+	});
+	return true;
+}
+
+/* Publish the field values of /stream/: a full refresh image to sessions
+ * without one, i.e. new streams or after login recovery, and to sessions
+ * holding an image an update of only the fields that changed.
  */
-		RFA_String warningText;
-		const uint8_t validation_status = response.validateMsg (&warningText);
-		if (rfa::message::MsgValidationWarning == validation_status) {
-			LOG(ERROR) << "respMsg::validateMsg: { \"warningText\": \"" << warningText << "\" }";
+bool
+gomi::gomi_t::Publish (
+	item_stream_t*const stream,
+	rfa::message::RespMsg*const refresh,
+	rfa::message::RespMsg*const update
+	)
+{
+	const unsigned image_count = provider_->GetImageCount (*stream);
+
+/* sessions holding an image first, those receiving a refresh are current */
+	size_t size;
+	if (image_count > 0) {
+		if (EncodeFields (&stream->last_value, &size) > 0) {
+			update->setPayload (fields_);
+			provider_->SendUpdate (stream, update, kMsgOverhead + stream->rfa_name.length() + size);
 		} else {
-			assert (rfa::message::MsgValidationOk == validation_status);
+			DVLOG(3) << "No change on stream " << stream->rfa_name;
 		}
-#endif
-		provider_->Send (stream.get(), &response);
+	}
+	if (image_count < stream->has_image.size()) {
+		EncodeFields (nullptr, &size);
+		refresh->setPayload (fields_);
+		provider_->SendImage (stream, refresh, kMsgOverhead + stream->rfa_name.length() + size);
+	}
+
+	std::for_each (field_values_.begin(), field_values_.end(), [stream](const field_value_t& value) {
+		stream->last_value[value.fid] = value.value;
 	});
 	return true;
 }
 
+/* Encode the current field values into the publish field list, only those
+ * differing from /last_value/ when provided.  Returns count of fields encoded
+ * and their estimated wire size in /size/.
+ */
+unsigned
+gomi::gomi_t::EncodeFields (
+	const std::map<int, int64_t>* last_value,
+	size_t* size
+	)
+{
+/* Clear required for SingleWriteIterator state machine. */
+	auto& it = single_write_it_;
+	DCHECK (it.isInitialized());
+	it.clear();
+	it.start (fields_);
+
+/* For each field set the Id via a FieldEntry bound to the iterator followed by setting the data.
+ * The iterator API provides setters for common types excluding 32-bit floats, with fallback to 
+ * a generic DataBuffer API for other types or support of pre-calculated values.
+ */
+	rfa::data::FieldEntry field (false);
+	unsigned field_count = 0;
+	*size = 0;
+	std::for_each (field_values_.begin(), field_values_.end(), [&](const field_value_t& value)
+	{
+		if (nullptr != last_value) {
+			auto jt = last_value->find (value.fid);
+			if (last_value->end() != jt && jt->second == value.value)
+				return;
+		}
+		++field_count;
+		*size += field_size (value);
+		field.setFieldID (value.fid);
+		it.bind (field);
+		switch (value.type) {
+		case field_value_t::REAL:
+			it.setReal (value.value, value.hint);
+			break;
+		case field_value_t::TIME:
+			it.setTime ((uint8_t)(value.value / 10000), (uint8_t)(value.value / 100 % 100), (uint8_t)(value.value % 100), 0 /* ms */);
+			break;
+		case field_value_t::DATE:
+			it.setDate ((uint16_t)(value.value / 10000), (uint8_t)(value.value / 100 % 100), (uint8_t)(value.value % 100));
+			break;
+		default:
+			NOTREACHED();
+			break;
+		}
+	});
+	it.complete();
+	return field_count;
+}
+
 /* eof */
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <set>
 #include <unordered_map>
 #include <tuple>
 
@@ -73,6 +74,28 @@ namespace gomi
 	class rfa_t;
 	class provider_t;
 	class snmp_agent_t;
+	class scan_t;
+	class bar_store_t;
+	class worker_pool_t;
+	class calendar_t;
+	class period_table_t;
+	class scan_planner_t;
+	class activity_index_t;
+	class intraday_index_t;
+	class tick_source_t;
+	class tick_stream_t;
+
+/* Published field value, Real64 mantissa with exponent hint, or Time and Date
+ * packed as decimal hhmmss and yyyymmdd for comparison with the last image.
+ */
+	struct field_value_t
+	{
+		enum { REAL, TIME, DATE };
+		int fid;
+		int type;
+		int64_t value;
+		uint8_t hint;
+	};
 
 /* Archive streams match a specific bin analytic query. */
 	class archive_stream_t : public item_stream_t
@@ -93,6 +116,7 @@ namespace gomi
 		realtime_stream_t (const std::string& symbol_name_) :
 			symbol_name (symbol_name_)
 		{
+			priority = PUBLISH_PRIORITY_REALTIME;
 		}
 
 /* source feed name, not the name of the derived feed symbol */
@@ -205,8 +229,10 @@ namespace gomi
 		int TclRepublishQuery (const vpf::CommandInfo& cmdInfo, vpf::TCLCommandData& cmdData);
 		int TclRepublishLastBinQuery (const vpf::CommandInfo& cmdInfo, vpf::TCLCommandData& cmdData);
 		int TclRecalculateQuery (const vpf::CommandInfo& cmdInfo, vpf::TCLCommandData& cmdData);
+		int TclInvalidateQuery (const vpf::CommandInfo& cmdInfo, vpf::TCLCommandData& cmdData);
 
 		bool IsSpecialBin (const bin_decl_t& bin);
+		std::shared_ptr<tick_source_t> CreateTickSource();
 
 		bool GetDueTime (const boost::local_time::time_zone_ptr& tz, boost::posix_time::ptime* t);
 		bool GetNextBinClose (const boost::local_time::time_zone_ptr& tz, boost::posix_time::ptime* t);
@@ -216,8 +242,22 @@ namespace gomi
 		bool TimeRefresh() throw (rfa::common::InvalidUsageException);
 		bool DayRefresh() throw (rfa::common::InvalidUsageException);
 		bool Recalculate() throw (rfa::common::InvalidUsageException);
-		bool BinRefresh (const bin_decl_t& bin) throw (rfa::common::InvalidUsageException);
-		bool SummaryRefresh (const boost::posix_time::time_duration& time_of_day) throw (rfa::common::InvalidUsageException);
+		bool Invalidate (const std::vector<std::string>& symbols, const boost::gregorian::date& date, const boost::posix_time::time_duration& start, const boost::posix_time::time_duration& end) throw (rfa::common::InvalidUsageException);
+		bool BinCalculate (const std::vector<bin_decl_t>& bins);
+		void ScheduleLookAhead();
+		void CancelLookAhead();
+		bool IsLookAheadCancelled (uint64_t generation);
+		void LookAheadRun();
+		bool LookAhead (const std::vector<bin_decl_t>& bins, const boost::gregorian::date& date, uint64_t generation);
+		bool WarmStart();
+		void SetBinParameters (bin_decl_t* bin_decl) const;
+/* calendar covering /query_day_count/ business days, at least the configured history */
+		std::shared_ptr<const calendar_t> GetCalendar (const boost::gregorian::date& date, unsigned query_day_count = 0);
+		bool PersistBars (const scan_t& scan, const std::vector<bin_decl_t>& bins, const std::vector<std::vector<std::shared_ptr<bin_t>>*>& v);
+		bool BinRefresh (const bin_decl_t& bin, const std::set<std::string>* symbol_set = nullptr) throw (rfa::common::InvalidUsageException);
+		bool SummaryRefresh (const boost::posix_time::time_duration& time_of_day, const std::set<std::string>* symbol_set = nullptr) throw (rfa::common::InvalidUsageException);
+		bool Publish (item_stream_t*const stream, rfa::message::RespMsg*const refresh, rfa::message::RespMsg*const update) throw (rfa::common::InvalidUsageException);
+		unsigned EncodeFields (const std::map<int, int64_t>* last_value, size_t* size);
 
 /* Unique instance number per process. */
 		LONG instance_;
@@ -234,8 +274,12 @@ namespace gomi
 
 /* FLexRecord cursor */
 		FlexRecDefinitionManager* manager_;
-		std::shared_ptr<FlexRecWorkAreaElement> work_area_;
-		std::shared_ptr<FlexRecViewElement> view_element_;
+
+/* Trade fields of every bin, read by every tick source. */
+		trade_fields_t trade_fields_;
+
+/* Calculation threads, each with a private tick source. */
+		std::unique_ptr<worker_pool_t> pool_;
 
 /* SNMP implant. */
 		std::unique_ptr<snmp_agent_t> snmp_agent_;
@@ -276,6 +320,12 @@ namespace gomi
 /* Parsed bin decls sorted by close time, not by open-close. */
 		std::set<bin_decl_t, bin_decl_close_compare_t> bins_;
 
+/* Percentage change windows, and business days of history covering the
+ * analytic period and the longest window.
+ */
+		std::vector<unsigned> windows_;
+		unsigned history_day_count_;
+
 /* last refresh time-of-day, default to not_a_date_time */
 		boost::posix_time::time_duration last_refresh_;
 
@@ -287,6 +337,47 @@ namespace gomi
 
 /* analytic state */
 
+/* Business day calendar shared by all scans, replaced on date roll. */
+		std::shared_ptr<const calendar_t> calendar_;
+		boost::mutex calendar_lock_;
+
+/* UTC time periods per bin decl and business day shared by all scans. */
+		std::unique_ptr<period_table_t> period_table_;
+
+/* Measured cost of refresh scan strategies. */
+		std::unique_ptr<scan_planner_t> scan_planner_;
+
+/* Time periods without trades per symbol, never read again. */
+		std::unique_ptr<activity_index_t> activity_index_;
+
+/* Minute sub-bars of symbols of recent Tcl queries and of today's streamed trades. */
+		std::unique_ptr<intraday_index_t> intraday_index_;
+
+/* Trade ingestion and thread. */
+		std::unique_ptr<tick_stream_t> tick_stream_;
+		std::unique_ptr<boost::thread> stream_thread_;
+
+/* History of the next bins calculated between closes, pending bins and
+ * date, bumping the generation cancels a running look-ahead.
+ */
+		std::unique_ptr<boost::thread> look_ahead_thread_;
+		boost::mutex look_ahead_lock_;
+		boost::condition_variable look_ahead_cond_;
+		std::vector<bin_decl_t> look_ahead_bins_;
+		boost::gregorian::date look_ahead_date_;
+		uint64_t look_ahead_generation_;
+		bool is_look_ahead_running_;
+
+/* Bar caches of the look-ahead bins calculated on private copies for the
+ * date of their close, adopted by the close so that published analytic
+ * state is never written between closes.
+ */
+		std::map<bin_decl_t, std::vector<std::shared_ptr<bin_t>>, bin_decl_openclose_compare_t> look_ahead_cache_;
+		boost::gregorian::date look_ahead_cache_date_;
+
+/* Finished day bars persisted across restarts. */
+		std::unique_ptr<bar_store_t> bar_store_;
+
 /* Event pump and thread. */
 		std::unique_ptr<event_pump_t> event_pump_;
 		std::unique_ptr<boost::thread> event_thread_;
@@ -297,6 +388,9 @@ namespace gomi
 /* Iterator for populating publish fields */
 		rfa::data::SingleWriteIterator single_write_it_;
 
+/* Field values of the stream being published. */
+		std::vector<field_value_t> field_values_;
+
 /* Thread timer. */
 		std::unique_ptr<time_pump_t<boost::chrono::system_clock>> timer_;
 		std::unique_ptr<boost::thread> timer_thread_;
@@ -5,6 +5,7 @@
 
 #include "gomiMIB.hh"
 
+#include <algorithm>
 #include <list>
 
 /* Boost threading. */
@@ -48,6 +49,7 @@ static_assert (__netsnmp_LOG_DEBUG   == LOG_DEBUG,   "LOG_DEBUG mismatch");
 #include "gomi.hh"
 #include "provider.hh"
 #include "session.hh"
+#include "scan_planner.hh"
 
 namespace gomi {
 
@@ -405,7 +407,7 @@ initialize_table_gomiPluginPerformanceTable(void)
 					  ASN_UNSIGNED,  /* index: gomiPluginPerformanceInstance */
 					  0);
 	table_info->min_column = COLUMN_GOMITCLQUERYRECEIVED;
-	table_info->max_column = COLUMN_GOMILASTMSGSSENT;
+	table_info->max_column = COLUMN_GOMIRANGESCANCALLOVERHEAD;
     
 	iinfo = SNMP_MALLOC_TYPEDEF( netsnmp_iterator_info );
 	if (nullptr == iinfo)
@@ -673,6 +675,42 @@ gomiPluginPerformanceTable_handler (
 				}
 				break;
 
+			case COLUMN_GOMISYMBOLSCANDECISIONS:
+			case COLUMN_GOMIBATCHSCANDECISIONS:
+			case COLUMN_GOMIRANGESCANDECISIONS:
+				{
+					const gomi::scan_strategy_t strategy = (COLUMN_GOMISYMBOLSCANDECISIONS == table_info->colnum) ? gomi::SCAN_PER_SYMBOL :
+						((COLUMN_GOMIBATCHSCANDECISIONS == table_info->colnum) ? gomi::SCAN_BATCH : gomi::SCAN_RANGE);
+					const unsigned decisions = gomi->scan_planner_->GetDecisionCount (strategy);
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&decisions, sizeof (decisions));
+				}
+				break;
+
+			case COLUMN_GOMISYMBOLSCANROWRATE:
+			case COLUMN_GOMIBATCHSCANROWRATE:
+			case COLUMN_GOMIRANGESCANROWRATE:
+				{
+					const gomi::scan_strategy_t strategy = (COLUMN_GOMISYMBOLSCANROWRATE == table_info->colnum) ? gomi::SCAN_PER_SYMBOL :
+						((COLUMN_GOMIBATCHSCANROWRATE == table_info->colnum) ? gomi::SCAN_BATCH : gomi::SCAN_RANGE);
+					const unsigned row_rate = (unsigned)std::min (gomi->scan_planner_->GetRowRate (strategy), 4294967295.0);
+					snmp_set_var_typed_value (var, ASN_GAUGE, /* ASN_GAUGE32 */
+						(const u_char*)&row_rate, sizeof (row_rate));
+				}
+				break;
+
+			case COLUMN_GOMISYMBOLSCANCALLOVERHEAD:
+			case COLUMN_GOMIBATCHSCANCALLOVERHEAD:
+			case COLUMN_GOMIRANGESCANCALLOVERHEAD:
+				{
+					const gomi::scan_strategy_t strategy = (COLUMN_GOMISYMBOLSCANCALLOVERHEAD == table_info->colnum) ? gomi::SCAN_PER_SYMBOL :
+						((COLUMN_GOMIBATCHSCANCALLOVERHEAD == table_info->colnum) ? gomi::SCAN_BATCH : gomi::SCAN_RANGE);
+					const unsigned call_overhead = (unsigned)std::min (1e6 * gomi->scan_planner_->GetCallOverhead (strategy), 4294967295.0);
+					snmp_set_var_typed_value (var, ASN_GAUGE, /* ASN_GAUGE32 */
+						(const u_char*)&call_overhead, sizeof (call_overhead));
+				}
+				break;
+
 			default:
 				snmp_log (__netsnmp_LOG_ERR, "gomiPluginPerformanceTable_handler: unknown column.\n");
 				netsnmp_set_request_error (reqinfo, request, SNMP_NOSUCHOBJECT);
@@ -1022,7 +1060,7 @@ initialize_table_gomiSessionPerformanceTable(void)
 					  ASN_UNSIGNED,  /* index: gomiSessionPerformanceUniqueInstance */
 					  0);
 	table_info->min_column = COLUMN_GOMISESSIONLASTACTIVITY;
-	table_info->max_column = COLUMN_GOMIMMTLOGINDATASTATE;
+	table_info->max_column = COLUMN_GOMISESSIONMSGSCONFLATED;
     
 	iinfo = SNMP_MALLOC_TYPEDEF( netsnmp_iterator_info );
 	if (nullptr == iinfo)
@@ -1407,6 +1445,71 @@ gomiSessionPerformanceTable_handler (
 				}
 				break;
 
+			case COLUMN_GOMISESSIONMSGSENQUEUED:
+				{
+					const unsigned msgs_enqueued = session->cumulative_stats_[SESSION_PC_MSGS_ENQUEUED];
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&msgs_enqueued, sizeof (msgs_enqueued));
+				}
+				break;
+
+			case COLUMN_GOMISESSIONMSGSDROPPED:
+				{
+					const unsigned msgs_dropped = session->cumulative_stats_[SESSION_PC_MSGS_DROPPED];
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&msgs_dropped, sizeof (msgs_dropped));
+				}
+				break;
+
+			case COLUMN_GOMISESSIONQUEUEDEPTH:
+				{
+					const unsigned queue_depth = (unsigned)session->GetQueueDepth();
+					snmp_set_var_typed_value (var, ASN_GAUGE, /* ASN_GAUGE32 */
+						(const u_char*)&queue_depth, sizeof (queue_depth));
+				}
+				break;
+
+			case COLUMN_GOMISESSIONLASTQUEUELATENCY:
+				{
+					const unsigned last_queue_latency = session->GetLastQueueLatency();
+					snmp_set_var_typed_value (var, ASN_GAUGE, /* ASN_GAUGE32 */
+						(const u_char*)&last_queue_latency, sizeof (last_queue_latency));
+				}
+				break;
+
+			case COLUMN_GOMISESSIONMAXQUEUELATENCY:
+				{
+					const unsigned max_queue_latency = session->GetMaxQueueLatency();
+					snmp_set_var_typed_value (var, ASN_GAUGE, /* ASN_GAUGE32 */
+						(const u_char*)&max_queue_latency, sizeof (max_queue_latency));
+				}
+				break;
+
+			case COLUMN_GOMISESSIONMSGSPACED:
+				{
+					const unsigned msgs_paced = session->cumulative_stats_[SESSION_PC_MSGS_PACED];
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&msgs_paced, sizeof (msgs_paced));
+				}
+				break;
+
+/* milliseconds, accumulated in microseconds */
+			case COLUMN_GOMISESSIONPACEDTIME:
+				{
+					const unsigned paced_time = (unsigned)(session->GetPacedTime() / 1000);
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&paced_time, sizeof (paced_time));
+				}
+				break;
+
+			case COLUMN_GOMISESSIONMSGSCONFLATED:
+				{
+					const unsigned msgs_conflated = session->cumulative_stats_[SESSION_PC_MSGS_CONFLATED];
+					snmp_set_var_typed_value (var, ASN_COUNTER, /* ASN_COUNTER32 */
+						(const u_char*)&msgs_conflated, sizeof (msgs_conflated));
+				}
+				break;
+
 			default:
 				snmp_log (__netsnmp_LOG_ERR, "gomiSessionPerformanceTable_handler: unknown column.\n");
 				netsnmp_set_request_error (reqinfo, request, SNMP_NOSUCHOBJECT);
@@ -37,6 +37,15 @@ bool init_gomiMIB(void);
        #define COLUMN_GOMITIMERSVCTIMEMAX		11
        #define COLUMN_GOMIMSGSSENT		12
        #define COLUMN_GOMILASTMSGSSENT		13
+       #define COLUMN_GOMISYMBOLSCANDECISIONS		14
+       #define COLUMN_GOMIBATCHSCANDECISIONS		15
+       #define COLUMN_GOMISYMBOLSCANROWRATE		16
+       #define COLUMN_GOMIBATCHSCANROWRATE		17
+       #define COLUMN_GOMISYMBOLSCANCALLOVERHEAD		18
+       #define COLUMN_GOMIBATCHSCANCALLOVERHEAD		19
+       #define COLUMN_GOMIRANGESCANDECISIONS		20
+       #define COLUMN_GOMIRANGESCANROWRATE		21
+       #define COLUMN_GOMIRANGESCANCALLOVERHEAD		22
 
 /* column number definitions for table gomiSessionTable */
        #define COLUMN_GOMISESSIONPLUGINID		1
@@ -79,6 +88,14 @@ bool init_gomiMIB(void);
        #define COLUMN_GOMITOKENSGENERATED		24
        #define COLUMN_GOMIMMTLOGINSTREAMSTATE		25
        #define COLUMN_GOMIMMTLOGINDATASTATE		26
+       #define COLUMN_GOMISESSIONMSGSENQUEUED		27
+       #define COLUMN_GOMISESSIONMSGSDROPPED		28
+       #define COLUMN_GOMISESSIONQUEUEDEPTH		29
+       #define COLUMN_GOMISESSIONLASTQUEUELATENCY		30
+       #define COLUMN_GOMISESSIONMAXQUEUELATENCY		31
+       #define COLUMN_GOMISESSIONMSGSPACED		32
+       #define COLUMN_GOMISESSIONPACEDTIME		33
+       #define COLUMN_GOMISESSIONMSGSCONFLATED		34
 
 } /* namespace gomi */
 
@@ -10,82 +10,103 @@
 /* Boost noncopyable base class. */
 #include <boost/utility.hpp>
 
-/* Boost Posix Time */
-#include <boost/date_time/posix_time/posix_time.hpp>
-
-/* Boost Accumulators */
-#include <boost/accumulators/accumulators.hpp>
-#include <boost/accumulators/statistics/count.hpp>
-#include <boost/accumulators/statistics/sum.hpp>
-
 /* Velocity Analytics Plugin Framework */
 #include <vpf/vpf.h>
 #include <TBPrimitives.h>
-
-#include "accumulators/first.hh"
-#include "accumulators/last.hh"
 
 namespace gomi
 {
-/* definition of a gummy bar */
+	class scan_t;
+
+/* definition of a gummy bar, flat for contiguous storage per bin */
 	class bar_t
 	{
 	public:
 		bar_t() :
-			tp_ (boost::posix_time::not_a_date_time, boost::posix_time::hours (0)),
-			is_null_ (true)
+			from_ (0),
+			till_ (0)
 		{
+			Clear();
 		}
 
-		bar_t (const boost::posix_time::time_period& tp) :
-			tp_ (tp),
-			is_null_ (true)
+		bar_t (__time32_t from, __time32_t till) :
+			from_ (from),
+			till_ (till)
 		{
+			Clear();
 		}
 
-		bool Calculate (const char* symbol_name);
-		bool Calculate (const TBSymbolHandle& handle, FlexRecWorkAreaElement* work_area, FlexRecViewElement* view_element);
+/* time period [from, till) in Unix epoch */
+		void SetTimePeriod (__time32_t from, __time32_t till) { from_ = from; till_ = till; }
+		bool Overlaps (__time32_t from, __time32_t till) const { return from_ < till && from < till_; }
+		double GetOpenPrice() { return open_price_; }
+		double GetClosePrice() { return close_price_; }
+		uint64_t GetNumberMoves() { return number_moves_; }
+		uint64_t GetAccumulatedVolume() { return accumulated_volume_; }
+
+/* add a trade to the partial bar result */
+		void Accumulate (double last_price, uint64_t tick_volume) {
+			if (0 == number_moves_)
+				open_price_ = last_price;
+			close_price_ = last_price;
+			++number_moves_;
+			accumulated_volume_ += tick_volume;
+		}
 
-		void SetTimePeriod (const boost::posix_time::time_period tp) { tp_ = tp; }
-		double GetOpenPrice() { return boost::accumulators::first (last_price_); }
-		double GetClosePrice() { return boost::accumulators::last (last_price_); }
-		uint64_t GetNumberMoves() { return boost::accumulators::count (last_price_); }
-		uint64_t GetAccumulatedVolume() { return boost::accumulators::sum (tick_volume_); }
+/* append the partial bar result of a following time period */
+		void Merge (const bar_t& bar) {
+			if (0 == bar.number_moves_)
+				return;
+			if (0 == number_moves_)
+				open_price_ = bar.open_price_;
+			close_price_ = bar.close_price_;
+			number_moves_ += bar.number_moves_;
+			accumulated_volume_ += bar.accumulated_volume_;
+		}
 
-		static int processFlexRecord (FRTreeCallbackInfo* info);
+/* replace with a finished bar from persistent storage */
+		void Restore (double open_price, double close_price, uint64_t number_moves, uint64_t accumulated_volume) {
+			open_price_ = open_price;
+			close_price_ = close_price;
+			number_moves_ = (uint32_t)number_moves;
+			accumulated_volume_ = accumulated_volume;
+			is_null_ = false;
+			is_final_ = true;
+		}
 
 		void Clear()
 		{
-			static const boost::accumulators::accumulator_set<double,
-				boost::accumulators::features<boost::accumulators::tag::first,
-							      boost::accumulators::tag::last,
-							      boost::accumulators::tag::count>> null_last_price_;
-			static const boost::accumulators::accumulator_set<uint64_t,
-				boost::accumulators::features<boost::accumulators::tag::sum>> null_tick_volume_;
-			last_price_ = null_last_price_;
-			tick_volume_ = null_tick_volume_;
+			open_price_ = close_price_ = 0.0;
+			number_moves_ = accumulated_volume_ = 0;
 			is_null_ = true;
+			is_final_ = false;
 		}
 
 		operator bool() const { return !is_null_; }
+/* calculated after close of time period and settle delay, may be reused */
+		bool IsFinal() const { return is_final_; }
 
 	private:
 		friend struct bar_compare_t;
+		friend class scan_t;
 
-		boost::posix_time::time_period tp_;
-		boost::accumulators::accumulator_set<double,
-			boost::accumulators::features<boost::accumulators::tag::first,
-						      boost::accumulators::tag::last,
-						      boost::accumulators::tag::count>> last_price_;
-		boost::accumulators::accumulator_set<uint64_t,
-			boost::accumulators::features<boost::accumulators::tag::sum>> tick_volume_;
+/* first and last trade price, zero when no trades */
+		double open_price_, close_price_;
+		uint64_t accumulated_volume_;
+		__time32_t from_, till_;
+		uint32_t number_moves_;
 		bool is_null_;
+		bool is_final_;
 	};
 
+	static_assert (sizeof (bar_t) <= 40, "bar_t expected to pack into 40 bytes");
+
 	struct bar_compare_t
 	{
 		bool operator() (const bar_t& lhs, const bar_t& rhs) const {
-			return lhs.tp_ < rhs.tp_;
+			if (lhs.from_ < rhs.from_)
+				return true;
+			return (lhs.from_ == rhs.from_) && (lhs.till_ < rhs.till_);
 		}
 	};
 
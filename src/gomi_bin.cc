@@ -4,205 +4,132 @@
 #include "gomi_bin.hh"
 #include "gomi_bar.hh"
 
-#include "chromium/logging.hh"
-#include "business_day_iterator.hh"
+#include <algorithm>
+#include <sstream>
 
-/* FlexRecord Trade identifier. */
-static const uint32_t kTradeId = 40001;
-
-/* http://en.wikipedia.org/wiki/Unix_epoch */
-static const boost::gregorian::date kUnixEpoch (1970, 1, 1);
-
-/* Convert Posix time to Unix Epoch time.
- */
-static
-__time32_t
-to_unix_epoch (
-	const boost::posix_time::ptime t
-	)
-{
-	return (t - boost::posix_time::ptime (kUnixEpoch)).total_seconds();
-}
-
-/* Is today<date> a business day, per TBSDK.  Assumes local calendar as per TBSDK.
- */
-static
-bool
-is_business_day (
-	const boost::gregorian::date d
-	)
-{
-	BusinessDayInfo bd;
-	CHECK (!d.is_not_a_date());
-	const __time32_t time32 = to_unix_epoch (boost::posix_time::ptime (d));
-	return (0 != TBPrimitives::BusinessDay (time32, &bd));
-}
-
-/* Calculate the start and end of each time of a bin for a given date.
- */
-static
-boost::posix_time::time_period
-to_time_period (
-	const gomi::bin_decl_t& bin_decl,
-	const boost::gregorian::date& date
-	)
-{
-	using namespace boost;
-	using namespace local_time;
-	using namespace posix_time;
-
-/* start: apply provided time-of-day */
-	const local_date_time start_ldt (date, bin_decl.bin_start, bin_decl.bin_tz, local_date_time::NOT_DATE_TIME_ON_ERROR);
-	CHECK (!start_ldt.is_not_a_date_time());
-
-/* end */
-	const local_date_time end_ldt (date, bin_decl.bin_end, bin_decl.bin_tz, local_date_time::NOT_DATE_TIME_ON_ERROR);
-	CHECK (!end_ldt.is_not_a_date_time());
-
-	time_period tp (start_ldt.utc_time(), end_ldt.utc_time());
-	return tp;
-}
+#include "chromium/logging.hh"
+#include "collate.hh"
 
-/*  IN: bin populated with symbol names.
- * OUT: bin populated with analytic values from start to end.
+/*  IN: bins of one bin decl with bars populated with day_count days of
+ *      trades, caller must reset analytic values with Clear().
+ * OUT: bins populated with analytic values from start to end.
  *
- * caller must reset analytic values, is_null values if clean query is required,
- * existing values can be used to extended a previous query.
+ * Every window is read from the one pass over the longest history, windows
+ * longer than the history are truncated to it.
  */
-
-/* Flex Record Cursor API reference implementation.
- *
- * slow.
- */
-
-bool
-gomi::bin_t::Calculate (
-	const boost::gregorian::date& date,
-	FlexRecWorkAreaElement* work_area,
-	FlexRecViewElement* view_element
+void
+gomi::CollateBins (
+	const std::vector<bin_t*>& bins
 	)
 {
-	DLOG(INFO) << "Calculate (date: " << to_simple_string (date) << ")";
-
-/* reset state */
-	Clear();
-
-/* no-op */
-	if (0 == bin_decl_.bin_day_count) {
-		DVLOG(4) << "empty query";
-		return true;
+	if (bins.empty())
+		return;
+	const auto& bin_decl = bins.front()->bin_decl_;
+	const unsigned day_count = bin_decl.bin_day_count;
+	if (0 == day_count)
+		return;
+
+	const size_t n = bins.size();
+	collate_input_t input;
+	input.Resize (day_count, n);
+	if (bin_decl.bin_analytic_day_count > 0)
+		input.analytic_day_count = std::min (bin_decl.bin_analytic_day_count, day_count);
+
+/* distinct last day of each window */
+	std::vector<unsigned> window_end (bin_decl.bin_windows.size());
+	for (size_t w = 0; w < window_end.size(); ++w) {
+		DCHECK_GT (bin_decl.bin_windows[w], 0U);
+		window_end[w] = std::min (bin_decl.bin_windows[w], day_count) - 1;
 	}
-
-/* do not assume today is a business day */
-	using namespace boost::local_time;
-	const auto& now_in_tz = local_sec_clock::local_time (bin_decl_.bin_tz);
-	const auto& today_in_tz = now_in_tz.local_time().date();
-	auto start_date (today_in_tz);
-	while (!is_business_day (start_date))
-		start_date -= boost::gregorian::date_duration (1);
-	vhayu::business_day_iterator bd_itr (start_date);
-/* save close of first business-day of analytic period */
-	const local_date_time close_ldt (start_date, bin_decl_.bin_end, bin_decl_.bin_tz, local_date_time::NOT_DATE_TIME_ON_ERROR);
-	CHECK (!close_ldt.is_not_a_date_time());
-	close_time_ = close_ldt.utc_time();
-
-	for (unsigned t = 0; t < bin_decl_.bin_day_count; ++t, --bd_itr)
-	{
-		const auto tp = to_time_period (bin_decl_, *bd_itr);
-
-		bars_[t].Clear();
-		bars_[t].SetTimePeriod (tp);
-#if 0
-		bars_[t].Calculate (symbol_name_.c_str());
-#else
-		bars_[t].Calculate (handle_, work_area, view_element);
-#endif
-		LOG(INFO) << "bar: { "
-			  "symbol: \"" << symbol_name_ << "\""
-			", day: " << t <<
-			", time_period: \"" << to_simple_string (tp) << "\""
-			", open: " << bars_[t].GetOpenPrice() <<
-			", close: " << bars_[t].GetClosePrice() <<
-			", moves: " << bars_[t].GetNumberMoves() <<
-			", volume: " << bars_[t].GetAccumulatedVolume() <<
-			" }";
+	input.window_end = window_end;
+	std::sort (input.window_end.begin(), input.window_end.end());
+	input.window_end.erase (std::unique (input.window_end.begin(), input.window_end.end()), input.window_end.end());
+	std::vector<size_t> slot (window_end.size());
+	for (size_t w = 0; w < window_end.size(); ++w)
+		slot[w] = std::lower_bound (input.window_end.begin(), input.window_end.end(), window_end[w]) - input.window_end.begin();
+
+/* gather day bars into structure-of-arrays */
+	for (size_t s = 0; s < n; ++s) {
+		auto& bin = *bins[s];
+		DCHECK_EQ (day_count, bin.bin_decl_.bin_day_count);
+		for (unsigned t = 0; t < day_count; ++t) {
+			auto& bar = bin.GetBar (t);
+			input.open_price[t * n + s]         = bar.GetOpenPrice();
+			input.close_price[t * n + s]        = bar.GetClosePrice();
+			input.number_moves[t * n + s]       = bar.GetNumberMoves();
+			input.accumulated_volume[t * n + s] = bar.GetAccumulatedVolume();
+		}
 	}
 
 /* collate result set */
-	uint64_t accumulated_volume = 0;
-	double   accumulated_pc     = 0.0;
-	for (unsigned t = 0; t < bin_decl_.bin_day_count; ++t)
-	{
-		const double open_price = bars_[t].GetOpenPrice(),
-			    close_price = bars_[t].GetClosePrice();
-
-		accumulated_volume += bars_[t].GetAccumulatedVolume();
-		total_moves_       += bars_[t].GetNumberMoves();
-
-		if (open_price > 0.0)
-			accumulated_pc += ((100.0 * (close_price - open_price)) / open_price);
-
-		if (t < 20)
-			twentyday_avg_pc_  = accumulated_pc / t;
-		if (t < 15)
-			fifteenday_avg_pc_ = accumulated_pc / t;
-		if (t < 10)
-			tenday_avg_pc_     = accumulated_pc / t;
-
-/* test for zero-trade day */
-		if (bars_[t].GetNumberMoves() > 0) {
-			++trading_day_count_;
-
-			if (t < 20)
-				twentyday_avg_nonzero_pc_  = accumulated_pc / trading_day_count_;
-			if (t < 15)
-				fifteenday_avg_nonzero_pc_ = accumulated_pc / trading_day_count_;
-			if (t < 10)
-				tenday_avg_nonzero_pc_     = accumulated_pc / trading_day_count_;
+	collate_output_t output;
+	Collate (input, &output);
+
+/* scatter */
+	for (size_t s = 0; s < n; ++s) {
+		auto& bin = *bins[s];
+		for (size_t w = 0; w < slot.size(); ++w) {
+			bin.avg_pc_[w]         = output.avg_pc[slot[w] * n + s];
+			bin.avg_nonzero_pc_[w] = output.avg_nonzero_pc[slot[w] * n + s];
 		}
-
-		if (is_null_) {
-			is_null_ = false;
-/* may or may not be zero */
-			maximum_moves_ = minimum_moves_ = smallest_moves_ = bars_[t].GetNumberMoves();
-		} else {
-			if (bars_[t].GetNumberMoves() > 0)
-			{
-/* edge case: smallest-moves should not be zero if a trade-day is available */
-				if (0 == maximum_moves_)
-					maximum_moves_ = smallest_moves_ = bars_[t].GetNumberMoves();
-				else if (bars_[t].GetNumberMoves() < smallest_moves_)
-					smallest_moves_ = bars_[t].GetNumberMoves();
-				else if (bars_[t].GetNumberMoves() > maximum_moves_)
-					maximum_moves_ = bars_[t].GetNumberMoves();
-			}
-			if (bars_[t].GetNumberMoves() < minimum_moves_)
-				minimum_moves_ = bars_[t].GetNumberMoves();
+		bin.average_volume_            = output.average_volume[s];
+		bin.average_nonzero_volume_    = output.average_nonzero_volume[s];
+		bin.total_moves_               = output.total_moves[s];
+		bin.maximum_moves_             = output.maximum_moves[s];
+		bin.minimum_moves_             = output.minimum_moves[s];
+		bin.smallest_moves_            = output.smallest_moves[s];
+		bin.trading_day_count_         = output.trading_day_count[s];
+		bin.is_null_                   = false;
+
+		std::ostringstream pctchg;
+		for (size_t w = 0; w < slot.size(); ++w) {
+			pctchg << " pctchg_" << bin_decl.bin_windows[w] << "d=" << bin.avg_pc_[w]
+			       << " pctchg_" << bin_decl.bin_windows[w] << "td=" << bin.avg_nonzero_pc_[w];
 		}
-	}
 
-/* finalize */
-	if (trading_day_count_ > 0 && accumulated_volume > 0) {
-		average_volume_         = accumulated_volume / bin_decl_.bin_day_count;
-		average_nonzero_volume_ = accumulated_volume / trading_day_count_;
+//		DVLOG(1) << "Calculate() complete,"
+		LOG(INFO) << "Calculate() complete,"
+			" day_count=" << bin.trading_day_count_ <<
+			" acvol=" << output.accumulated_volume[s] << 
+			" avgvol=" << bin.average_volume_ <<
+			" avgrvl=" << bin.average_nonzero_volume_ <<	/* average real volume */
+			" count=" << bin.total_moves_ <<
+			" hicnt=" << bin.maximum_moves_ <<
+			" locnt=" << bin.minimum_moves_ <<
+			" smcnt=" << bin.smallest_moves_ <<
+			pctchg.str();
 	}
+}
 
-//	DVLOG(1) << "Calculate() complete,"
-	LOG(INFO) << "Calculate() complete,"
-		" day_count=" << trading_day_count_ <<
-		" acvol=" << accumulated_volume << 
-		" avgvol=" << average_volume_ <<
-		" avgrvl=" << average_nonzero_volume_ <<	/* average real volume */
-		" count=" << total_moves_ <<
-		" hicnt=" << maximum_moves_ <<
-		" locnt=" << minimum_moves_ <<
-		" smcnt=" << smallest_moves_ <<
-		" pctchg_10d=" << tenday_avg_pc_ <<
-		" pctchg_15d=" << fifteenday_avg_pc_ <<
-		" pctchg_20d=" << twentyday_avg_pc_ <<
-		" pctchg_10td=" << tenday_avg_nonzero_pc_ <<
-		" pctchg_15td=" << fifteenday_avg_nonzero_pc_ <<
-		" pctchg_20td=" << twentyday_avg_nonzero_pc_;
+/* One set of trade fields per tick source, the bins of every bin decl and
+ * symbol read the same fields so that one read serves all of them.
+ *
+ * Returns false on empty or inconsistent bins.
+ */
+bool
+gomi::GetTradeFields (
+	const std::vector<bin_t*>& bins,
+	trade_fields_t* fields
+	)
+{
+	if (bins.empty())
+		return false;
+	const auto& first = *bins.front();
+	for (auto it = bins.begin(); it != bins.end(); ++it) {
+		const auto& bin = **it;
+		if (bin.GetLastPriceField() != first.GetLastPriceField() ||
+		    bin.GetTickVolumeField() != first.GetTickVolumeField())
+		{
+			LOG(ERROR) << "Bin trade fields differ { "
+				"\"symbol\": \"" << bin.GetSymbolName() << "\""
+				", \"last_price\": [ \"" << first.GetLastPriceField() << "\", \"" << bin.GetLastPriceField() << "\" ]"
+				", \"tick_volume\": [ \"" << first.GetTickVolumeField() << "\", \"" << bin.GetTickVolumeField() << "\" ]"
+				" }";
+			return false;
+		}
+	}
+	fields->last_price = first.GetLastPriceField();
+	fields->tick_volume = first.GetTickVolumeField();
 	return true;
 }
 
@@ -5,6 +5,7 @@
 #define __GOMI_BIN_HH__
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <list>
 #include <unordered_map>
@@ -26,16 +27,25 @@
 #include <TBPrimitives.h>
 
 #include "gomi_bar.hh"
+#include "tick_source.hh"
 
 namespace gomi
 {
+	class scan_t;
+	class bin_t;
+
 /* definition of a /bin/ */
 	struct bin_decl_t
 	{
 		std::string bin_name;
 		boost::posix_time::time_duration bin_start, bin_end;
 		boost::local_time::time_zone_ptr bin_tz;
+/* business days of day bars, the longest of the analytic period and every window */
 		unsigned bin_day_count;
+/* leading business days of volume and moves analytics, at most bin_day_count */
+		unsigned bin_analytic_day_count;
+/* percentage change windows in business days, each published as n-day and n-trading-day */
+		std::vector<unsigned> bin_windows;
 	};
 
 	inline
@@ -46,6 +56,14 @@ namespace gomi
 			", end: \"" << boost::posix_time::to_simple_string (bin_decl.bin_end) << "\""
 			", tz: \"" << bin_decl.bin_tz->std_zone_abbrev() << "\""
 			", day_count: " << bin_decl.bin_day_count <<
+			", analytic_day_count: " << bin_decl.bin_analytic_day_count <<
+			", windows: [ ";
+		for (auto it = bin_decl.bin_windows.begin(); it != bin_decl.bin_windows.end(); ++it) {
+			if (it != bin_decl.bin_windows.begin())
+				o << ", ";
+			o << *it;
+		}
+		o << " ]"
 			" }";
 		return o;
 	}
@@ -76,31 +94,96 @@ namespace gomi
 			symbol_name_ (symbol_name),
 			last_price_field_ (last_price_field),
 			tick_volume_field_ (tick_volume_field),
-			bars_ (bin_decl_.bin_day_count)
+			bars_ (bin_decl_.bin_day_count),
+			head_ (0),
+			avg_pc_ (bin_decl_.bin_windows.size()),
+			avg_nonzero_pc_ (bin_decl_.bin_windows.size())
 		{
 			Clear();
 			handle_ = TBPrimitives::GetSymbolHandle (symbol_name_.c_str(), 1);
 		}
 
 		void Clear() {
-			tenday_avg_pc_ = fifteenday_avg_pc_ = twentyday_avg_pc_ = 0.0;
-			tenday_avg_nonzero_pc_ = fifteenday_avg_nonzero_pc_ = twentyday_avg_nonzero_pc_ = 0.0;
+			std::fill (avg_pc_.begin(), avg_pc_.end(), 0.0);
+			std::fill (avg_nonzero_pc_.begin(), avg_nonzero_pc_.end(), 0.0);
 			average_volume_ = average_nonzero_volume_ = total_moves_ = maximum_moves_ = minimum_moves_ = smallest_moves_ = 0;
 			close_time_ = boost::posix_time::not_a_date_time;
 			trading_day_count_ = 0;
 			is_null_ = true;
 		}
 
-/* calculate this bin for a given date /date/ */
-		bool Calculate (const boost::gregorian::date& date, FlexRecWorkAreaElement* work_area, FlexRecViewElement* view_element);
+/* discard all cached day bars */
+		void Reset() {
+			Reset (boost::gregorian::date (boost::gregorian::not_a_date_time));
+		}
+
+/* discard all cached day bars and start an empty cache at first effective business day /date/ */
+		void Reset (const boost::gregorian::date& date) {
+			std::for_each (bars_.begin(), bars_.end(), [](bar_t& bar) {
+				bar.Clear();
+			});
+			partial_.Clear();
+			head_ = 0;
+			cache_date_ = date;
+		}
+
+/* roll cached day bars forward /offset/ business days to a new first effective business day /date/ */
+		void Roll (const boost::gregorian::date& date, unsigned offset) {
+			const unsigned n = (unsigned)bars_.size();
+			if (offset >= n) {
+				Reset();
+			} else {
+				head_ = (head_ + n - offset) % n;
+				for (unsigned t = 0; t < offset; ++t)
+					GetBar (t).Clear();
+				partial_.Clear();
+			}
+			cache_date_ = date;
+		}
 
-		const char* GetSymbolName() { return symbol_name_.c_str(); }
-		const double GetTenDayPercentageChange() { return tenday_avg_pc_; }
-		const double GetFifteenDayPercentageChange() { return fifteenday_avg_pc_; }
-		const double GetTwentyDayPercentageChange() { return twentyday_avg_pc_; }
-		const double GetTenTradingDayPercentageChange() { return tenday_avg_nonzero_pc_; }
-		const double GetFifteenTradingDayPercentageChange() { return fifteenday_avg_nonzero_pc_; }
-		const double GetTwentyTradingDayPercentageChange() { return twentyday_avg_nonzero_pc_; }
+/* replace cached day bars with a copy of those of /other/, a bin of the same decl and symbol */
+		void CopyCache (const bin_t& other) {
+			bars_ = other.bars_;
+			head_ = other.head_;
+			partial_ = other.partial_;
+			partial_overlap_ = other.partial_overlap_;
+			cache_date_ = other.cache_date_;
+		}
+
+/* exchange cached day bars with /other/, analytic results of both are untouched */
+		void SwapCache (bin_t& other) {
+			bars_.swap (other.bars_);
+			std::swap (head_, other.head_);
+			std::swap (partial_, other.partial_);
+			std::swap (partial_overlap_, other.partial_overlap_);
+			std::swap (cache_date_, other.cache_date_);
+		}
+
+/* discard cached day bars overlapping [from, till) in Unix epoch, returns count discarded */
+		unsigned Invalidate (__time32_t from, __time32_t till) {
+			unsigned count = 0;
+			std::for_each (bars_.begin(), bars_.end(), [&](bar_t& bar) {
+				if (!bar.Overlaps (from, till))
+					return;
+				bar.Clear();
+				++count;
+			});
+			if (partial_.Overlaps (from, till))
+				partial_.Clear();
+			return count;
+		}
+
+/* day bar /t/ business days before the first effective business day */
+		bar_t& GetBar (unsigned t) { return bars_[(head_ + t) % bars_.size()]; }
+		unsigned GetBarCount() const { return (unsigned)bars_.size(); }
+		const boost::gregorian::date& GetCacheDate() const { return cache_date_; }
+
+		const char* GetSymbolName() const { return symbol_name_.c_str(); }
+		const std::string& GetLastPriceField() const { return last_price_field_; }
+		const std::string& GetTickVolumeField() const { return tick_volume_field_; }
+/* percentage change of window /i/ of bin_windows */
+		const double GetDayPercentageChange (size_t i) { return avg_pc_[i]; }
+		const double GetTradingDayPercentageChange (size_t i) { return avg_nonzero_pc_[i]; }
 		const uint64_t GetAverageVolume() { return average_volume_; }
 		const uint64_t GetAverageNonZeroVolume() { return average_nonzero_volume_; }
 		const uint64_t GetTotalMoves() { return total_moves_; }
@@ -113,6 +196,9 @@ namespace gomi
 		operator bool() const { return !is_null_; }
 
 	private:
+		friend class scan_t;
+		friend void CollateBins (const std::vector<bin_t*>& bins);
+
 		const bin_decl_t&	bin_decl_;
 /* Vhayu symbol name */
 		const std::string	symbol_name_;
@@ -121,12 +207,17 @@ namespace gomi
 /* Vhayu field names */
 		const std::string	last_price_field_,
 					tick_volume_field_;
-/* analytic state */
+/* analytic state, ring buffer of day bars */
 		std::vector<bar_t>	bars_;
-/* analytic results */
-		double			tenday_avg_pc_,      tenday_avg_nonzero_pc_,
-					fifteenday_avg_pc_,  fifteenday_avg_nonzero_pc_,
-					twentyday_avg_pc_,   twentyday_avg_nonzero_pc_;
+		unsigned		head_;
+/* open time period of the first effective business day up to its watermark,
+ * and the trades of the overlap before the watermark to detect late trades.
+ */
+		bar_t			partial_, partial_overlap_;
+/* first effective business day of cached bars */
+		boost::gregorian::date	cache_date_;
+/* analytic results, percentage changes in bin_windows order */
+		std::vector<double>	avg_pc_, avg_nonzero_pc_;
 		uint64_t		average_volume_, average_nonzero_volume_;
 		uint64_t		total_moves_;
 		uint64_t		maximum_moves_;
@@ -140,6 +231,16 @@ namespace gomi
 		bool			is_null_;
 	};
 
+/* collate day bars of bins sharing one bin decl into analytic results, bars
+ * populated by scan_t.
+ */
+	void CollateBins (const std::vector<bin_t*>& bins);
+
+/* FlexRecord fields read for the analytics of /bins/, returns false when
+ * there are no bins or bins name different fields.
+ */
+	bool GetTradeFields (const std::vector<bin_t*>& bins, trade_fields_t* fields);
+
 } /* namespace gomi */
 
 #endif /* __GOMI_BIN_HH__ */
@@ -0,0 +1,65 @@
+/* Bin unit test of the trade fields shared by tick sources.
+ *
+ * Returns zero on success, non-zero with each failure logged to stderr.
+ */
+
+#include "gomi_bin.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "unittest.hh"
+
+static
+std::vector<gomi::bin_t*>
+get_bins (
+	const std::vector<std::shared_ptr<gomi::bin_t>>& v
+	)
+{
+	std::vector<gomi::bin_t*> bins;
+	for (auto it = v.begin(); it != v.end(); ++it)
+		bins.push_back (it->get());
+	return bins;
+}
+
+/* Tick sources read the fields named by the bins, not assumed defaults, and
+ * bins naming different fields cannot share one tick source.
+ */
+static
+void
+test_trade_fields()
+{
+	gomi::bin_decl_t bin_decl;
+	bin_decl.bin_name = "0930-1000";
+	bin_decl.bin_day_count = 2;
+	bin_decl.bin_analytic_day_count = 2;
+
+	std::vector<std::shared_ptr<gomi::bin_t>> v;
+	v.push_back (std::make_shared<gomi::bin_t> (bin_decl, "A.N", "TradePrice", "TradeSize"));
+	v.push_back (std::make_shared<gomi::bin_t> (bin_decl, "B.N", "TradePrice", "TradeSize"));
+	gomi::trade_fields_t fields;
+	EXPECT(gomi::GetTradeFields (get_bins (v), &fields));
+	EXPECT("TradePrice" == fields.last_price);
+	EXPECT("TradeSize" == fields.tick_volume);
+
+	v.push_back (std::make_shared<gomi::bin_t> (bin_decl, "C.N", "TradePrice", "TickVolume"));
+	EXPECT(!gomi::GetTradeFields (get_bins (v), &fields));
+	v.back() = std::make_shared<gomi::bin_t> (bin_decl, "C.N", "LastPrice", "TradeSize");
+	EXPECT(!gomi::GetTradeFields (get_bins (v), &fields));
+
+	EXPECT(!gomi::GetTradeFields (std::vector<gomi::bin_t*>(), &fields));
+}
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	test_trade_fields();
+	return unittest::Result();
+}
+
+/* eof */
@@ -0,0 +1,904 @@
+/* Single pass multiple /bin/ FlexRecord scan.
+ */
+
+#include "gomi_scan.hh"
+
+#include <algorithm>
+#include <ctime>
+
+#include "chromium/logging.hh"
+#include "activity_index.hh"
+#include "gomi_bar.hh"
+#include "intraday_index.hh"
+
+/* Trades of the most recent minute may not have reached the database, a read
+ * only proves a time period quiet until this many seconds before the scan.
+ */
+static const int kSettleDelay = 60;
+
+/* Seconds of trades before a watermark re-read on resume, any difference is
+ * taken as late or corrected trades.
+ */
+static const int kWatermarkOverlap = 60;
+
+/* Scan state passed through the tick source as the callback closure.
+ */
+namespace
+{
+	struct scan_state_t
+	{
+/* elementary intervals of the read, bin time periods also split at resume points */
+		const std::vector<__time32_t>* boundaries;
+/* bar per elementary interval */
+		gomi::bar_t* slot_bars;
+/* cached elementary interval of the previous tick */
+		size_t slot;
+/* trades read and trades within bin time periods */
+		uint64_t rows, ticks;
+	};
+
+/* Batch scan state, elementary bars and previous tick position per symbol. */
+	struct batch_scan_state_t
+	{
+		const gomi::scan_t* scan;
+		const std::vector<gomi::scan_day_t>* days;
+/* bar per elementary interval indexed [symbol * slot_count + first_slot of day + interval] */
+		gomi::bar_t* slot_bars;
+		size_t slot_count;
+/* per symbol cached business day and elementary interval */
+		std::vector<std::pair<size_t, size_t>> cursors;
+/* trades read and trades within bin time periods */
+		uint64_t rows, ticks;
+	};
+
+/* Locate elementary interval of a tick, testing the cached interval first as
+ * ticks arrive in time order.  Returns false if outside every bin time period.
+ */
+	inline
+	bool
+	locate_slot (
+		const std::vector<__time32_t>& boundaries,
+		__time32_t timestamp,
+		size_t* slot
+		)
+	{
+		if (*slot + 1 < boundaries.size() &&
+		    timestamp >= boundaries[*slot] &&
+		    timestamp < boundaries[*slot + 1])
+		{
+			return true;
+		}
+		const auto it = std::upper_bound (boundaries.begin(), boundaries.end(), timestamp);
+		if (boundaries.begin() == it || boundaries.end() == it)
+			return false;
+		*slot = std::distance (boundaries.begin(), it) - 1;
+		return true;
+	}
+
+/* Merge the elementary bars of the intervals within [from, till) into /bar/,
+ * both ends must be /boundaries/.
+ */
+	inline
+	void
+	merge_slots (
+		const std::vector<__time32_t>& boundaries,
+		const gomi::bar_t* slot_bars,
+		__time32_t from,
+		__time32_t till,
+		gomi::bar_t* bar
+		)
+	{
+		const auto first = std::lower_bound (boundaries.begin(), boundaries.end(), from);
+		const auto last = std::lower_bound (first, boundaries.end(), till);
+		for (auto it = first; it < last; ++it)
+			bar->Merge (slot_bars[std::distance (boundaries.begin(), it)]);
+	}
+}
+
+/* The interval index only depends upon the bin decls and calendar, calculate
+ * once per refresh and share across all symbols.  Time periods are taken from
+ * the shared /period_table/ so that time zone conversion is not repeated.
+ */
+gomi::scan_t::scan_t (
+	const calendar_t& calendar,
+	period_table_t* period_table,
+	activity_index_t* activity_index,
+	const boost::gregorian::date& date,
+	const std::vector<bin_decl_t>& bin_decls
+	) :
+	bin_decls_ (bin_decls),
+	activity_index_ (activity_index),
+	as_of_ (_time32 (nullptr)),
+	slot_count_ (0)
+{
+	unsigned day_count = 0;
+	std::for_each (bin_decls_.begin(), bin_decls_.end(), [&day_count](const bin_decl_t& bin_decl) {
+		day_count = std::max (day_count, bin_decl.bin_day_count);
+	});
+/* no-op */
+	if (0 == day_count) {
+		DVLOG(4) << "empty query";
+		return;
+	}
+
+/* do not assume today is a business day */
+	std::vector<boost::gregorian::date> dates;
+	if (!calendar.GetBusinessDays (date, day_count, &dates)) {
+		LOG(ERROR) << "Calendar does not cover " << day_count << " business days on or before " << to_simple_string (date) << ".";
+		return;
+	}
+
+	days_.resize (day_count);
+	for (unsigned t = 0; t < day_count; ++t)
+	{
+		auto& day = days_[t];
+		day.date = dates[t];
+		day.windows.reserve (bin_decls_.size());
+
+		for (unsigned i = 0; i < bin_decls_.size(); ++i)
+		{
+			const auto& bin_decl = bin_decls_[i];
+			if (t >= bin_decl.bin_day_count) {
+				day.windows.push_back (std::make_pair (0, 0));
+				continue;
+			}
+			const auto window = period_table->Get (bin_decl, day.date);
+			day.windows.push_back (window);
+			if (window.first == window.second)
+				continue;
+			day.boundaries.push_back (window.first);
+			day.boundaries.push_back (window.second);
+		}
+
+/* elementary intervals, every bin time period is a contiguous run */
+		std::sort (day.boundaries.begin(), day.boundaries.end());
+		day.boundaries.erase (std::unique (day.boundaries.begin(), day.boundaries.end()), day.boundaries.end());
+		const size_t slot_count = day.boundaries.empty() ? 0 : day.boundaries.size() - 1;
+		day.first_slot = slot_count_;
+		slot_count_ += slot_count;
+
+		DVLOG(3) << "scan day: { "
+			  "date: \"" << to_simple_string (day.date) << "\""
+			", intervals: " << slot_count <<
+			" }";
+	}
+
+/* business days bucketed by binary search on a contiguous read */
+	for (size_t t = 0; t < days_.size(); ++t) {
+		if (!days_[t].boundaries.empty())
+			day_index_.push_back (std::make_pair (days_[t].boundaries.front(), t));
+	}
+	std::sort (day_index_.begin(), day_index_.end());
+}
+
+/*  IN: bins of one symbol, ordered as the bin decls.
+ * OUT: bins populated with day bars, collate with CollateBins().
+ *
+ * Returns false on error, true on success.  Each bin is populated regardless
+ * of error so that a failed day reads as a zero-trade day as before.
+ */
+bool
+gomi::scan_t::Calculate (
+	const std::vector<bin_t*>& bins,
+	tick_source_t* source,
+	intraday_index_t* index,
+	scan_stats_t* stats
+	) const
+{
+	Prepare (bins);
+	return Scan (bins, source, index, stats);
+}
+
+/* Look-ahead of a coming bin close, the history of the analytic period is
+ * final and cached, and the open time period of the first effective business
+ * day is kept up to a watermark, so that at close only the trades since the
+ * watermark are read.  Only the bar cache is rolled and filled, analytic
+ * results of /bins/ are left as published.
+ */
+bool
+gomi::scan_t::CalculateHistory (
+	const std::vector<bin_t*>& bins,
+	tick_source_t* source
+	) const
+{
+	DCHECK_EQ (bins.size(), bin_decls_.size());
+	if (days_.empty())
+		return true;
+	std::for_each (bins.begin(), bins.end(), [this](bin_t* bin) {
+		Roll (bin);
+	});
+	return Scan (bins, source, nullptr, nullptr);
+}
+
+/* One read per business day over the union of bin time periods, bar caches
+ * of /bins/ already rolled to this scan.
+ */
+bool
+gomi::scan_t::Scan (
+	const std::vector<bin_t*>& bins,
+	tick_source_t* source,
+	intraday_index_t* index,
+	scan_stats_t* stats
+	) const
+{
+/* no-op */
+	if (bins.empty() || days_.empty())
+		return true;
+
+	const TBSymbolHandle& handle = bins.front()->handle_;
+	const char* symbol_name = bins.front()->GetSymbolName();
+	std::vector<bar_t*> bars (bins.size());
+	std::vector<__time32_t> resume (bins.size()), watermarks (bins.size());
+	std::vector<uint32_t> moves (bins.size());
+	std::vector<time_window_t> windows, segments;
+	std::vector<__time32_t> boundaries;
+	std::vector<bar_t> slot_bars;
+	bool is_ok = true;
+
+/* open time periods are kept up to a watermark behind the settle delay */
+	const __time32_t watermark = as_of_ - kSettleDelay;
+
+	for (unsigned t = 0; t < days_.size(); ++t)
+	{
+		const auto& day = days_[t];
+		windows.clear();
+		for (unsigned i = 0; i < bins.size(); ++i) {
+			bars[i] = nullptr;
+			watermarks[i] = 0;
+			if (t >= bin_decls_[i].bin_day_count)
+				continue;
+			auto& bar = bins[i]->GetBar (t);
+			if (bar.IsFinal())
+				continue;
+			bar.Clear();
+			bar.SetTimePeriod (day.windows[i].first, day.windows[i].second);
+			resume[i] = day.windows[i].first;
+/* not yet open */
+			if (resume[i] >= as_of_) {
+				bar.is_null_ = false;
+				continue;
+			}
+/* resume an open time period from its watermark, re-reading the overlap */
+			const bar_t& partial = bins[i]->partial_;
+			if (0 == t && (bool)partial && partial.from_ == day.windows[i].first) {
+				bar.Merge (partial);
+				watermarks[i] = partial.till_;
+				resume[i] = bins[i]->partial_overlap_.from_;
+			}
+/* indexed prefix of the current day answered without reading trades */
+			else if (0 == t && nullptr != index &&
+			    index->Get (handle, symbol_name, day.date, bin_decls_[i].bin_tz, day.windows[i], source, &bar, &resume[i]))
+			{
+				if (resume[i] == day.windows[i].second) {
+					bar.is_final_ = IsSettled (day.windows[i].second);
+					continue;
+				}
+/* only the unindexed remainder is read */
+				bar.is_null_ = true;
+				bar.is_final_ = false;
+			}
+/* known quiet time period yields no trades */
+			resume[i] = std::min (GetQuietTill (symbol_name, resume[i]), day.windows[i].second);
+			if (resume[i] == day.windows[i].second) {
+				bar.is_null_ = false;
+				bar.is_final_ = IsSettled (day.windows[i].second);
+				continue;
+			}
+			moves[i] = bar.number_moves_;
+			bars[i] = &bar;
+			if (resume[i] != day.windows[i].second)
+				windows.push_back (std::make_pair (resume[i], day.windows[i].second));
+		}
+
+/* every bar cached */
+		if (std::none_of (bars.begin(), bars.end(), [](bar_t* bar) { return nullptr != bar; }))
+			continue;
+
+/* merge overlapping or adjacent windows into the minimal set of scans */
+		segments.clear();
+		std::sort (windows.begin(), windows.end());
+		for (auto it = windows.begin(); it != windows.end(); ++it) {
+			if (!segments.empty() && it->first <= segments.back().second)
+				segments.back().second = std::max (segments.back().second, it->second);
+			else
+				segments.push_back (*it);
+		}
+
+/* elementary intervals of this read, a partially indexed, quiet or
+ * watermarked bar resumes within its time period.
+ */
+		boundaries.assign (day.boundaries.begin(), day.boundaries.end());
+		for (unsigned i = 0; i < bins.size(); ++i) {
+			if (nullptr == bars[i])
+				continue;
+			if (resume[i] != day.windows[i].first)
+				boundaries.push_back (resume[i]);
+			if (0 != watermarks[i])
+				boundaries.push_back (watermarks[i]);
+			if (0 == t && watermark > day.windows[i].first && watermark < day.windows[i].second) {
+				boundaries.push_back (watermark - kWatermarkOverlap);
+				boundaries.push_back (watermark);
+			}
+		}
+		std::sort (boundaries.begin(), boundaries.end());
+		boundaries.erase (std::unique (boundaries.begin(), boundaries.end()), boundaries.end());
+/* no time period to scan */
+		if (boundaries.size() < 2)
+			continue;
+		slot_bars.assign (boundaries.size() - 1, bar_t());
+
+/* one pass per disjoint segment, each tick is applied to one elementary bar */
+		bool is_day_ok = true;
+		scan_state_t state = { &boundaries, slot_bars.data(), 0, 0, 0 };
+		for (auto it = segments.begin(); it != segments.end(); ++it) {
+			const bool is_read_ok = source->Read (handle, symbol_name, it->first, it->second, processTick, &state);
+			if (nullptr != stats)
+				stats->reads++;
+			if (!is_read_ok) {
+				is_day_ok = is_ok = false;
+				break;
+			}
+		}
+		if (nullptr != stats) {
+			stats->rows += state.rows;
+			stats->ticks += state.ticks;
+		}
+
+		for (unsigned i = 0; i < bins.size(); ++i) {
+			if (nullptr == bars[i])
+				continue;
+/* trades before the watermark are within the partial bar */
+			const __time32_t read_from = std::max (resume[i], watermarks[i]);
+			__time32_t from = read_from;
+/* overlap must be unchanged since the watermark was set, otherwise late or
+ * corrected trades invalidate the partial bar and the time period is read in
+ * full.
+ */
+			if (0 != watermarks[i] && is_day_ok && resume[i] == bins[i]->partial_overlap_.from_) {
+				bar_t overlap;
+				merge_slots (boundaries, slot_bars.data(), resume[i], watermarks[i], &overlap);
+				if (!IsSameBar (overlap, bins[i]->partial_overlap_)) {
+					LOG(INFO) << "Late trades before watermark: { "
+						  "symbol: \"" << symbol_name << "\""
+						", bin: \"" << bin_decls_[i].bin_name << "\""
+						", watermark: " << watermarks[i] <<
+						" }";
+					bins[i]->partial_.Clear();
+					bars[i]->Clear();
+					if (!Rescan (handle, symbol_name, std::make_pair (day.windows[i].first, resume[i]), source, stats, bars[i]))
+						is_day_ok = is_ok = false;
+					bars[i]->Merge (overlap);
+					moves[i] = 0;
+				}
+			}
+/* move watermark, partial bar excludes trades not yet settled */
+			if (0 == t && is_day_ok &&
+			    watermark - kWatermarkOverlap >= from && watermark > day.windows[i].first && watermark < day.windows[i].second)
+			{
+				bar_t& partial = bins[i]->partial_;
+				bar_t& overlap = bins[i]->partial_overlap_;
+				merge_slots (boundaries, slot_bars.data(), from, watermark - kWatermarkOverlap, bars[i]);
+				overlap.Clear();
+				overlap.SetTimePeriod (watermark - kWatermarkOverlap, watermark);
+				merge_slots (boundaries, slot_bars.data(), overlap.from_, overlap.till_, &overlap);
+				overlap.is_null_ = false;
+				bars[i]->Merge (overlap);
+				partial = *bars[i];
+				partial.SetTimePeriod (day.windows[i].first, watermark);
+				partial.is_null_ = false;
+				from = watermark;
+			}
+			merge_slots (boundaries, slot_bars.data(), from, day.windows[i].second, bars[i]);
+/* State now represents bar time period, which may be zero trades */
+			if (is_day_ok) {
+				bars[i]->is_null_ = false;
+				bars[i]->is_final_ = IsSettled (day.windows[i].second);
+				if (moves[i] == bars[i]->number_moves_)
+					SetQuiet (symbol_name, std::make_pair (read_from, day.windows[i].second));
+			}
+			VLOG(2) << "bar: { "
+				  "symbol: \"" << bins[i]->GetSymbolName() << "\""
+				", bin: \"" << bin_decls_[i].bin_name << "\""
+				", day: " << t <<
+				", from: " << day.windows[i].first <<
+				", till: " << day.windows[i].second <<
+				", open: " << bars[i]->GetOpenPrice() <<
+				", close: " << bars[i]->GetClosePrice() <<
+				", moves: " << bars[i]->GetNumberMoves() <<
+				", volume: " << bars[i]->GetAccumulatedVolume() <<
+				" }";
+		}
+	}
+	return is_ok;
+}
+
+/* Read /window/ of one symbol into /bar/, the fallback of a watermarked bar.
+ *
+ * Returns false on error, true on success.
+ */
+bool
+gomi::scan_t::Rescan (
+	const TBSymbolHandle& handle,
+	const char* symbol_name,
+	const time_window_t& window,
+	tick_source_t* source,
+	scan_stats_t* stats,
+	bar_t* bar
+	) const
+{
+	if (window.first >= window.second)
+		return true;
+	std::vector<__time32_t> boundaries (2);
+	boundaries[0] = window.first;
+	boundaries[1] = window.second;
+	bar_t slot_bar;
+	scan_state_t state = { &boundaries, &slot_bar, 0, 0, 0 };
+	const bool is_read_ok = source->Read (handle, symbol_name, window.first, window.second, processTick, &state);
+	if (nullptr != stats) {
+		stats->reads++;
+		stats->rows += state.rows;
+		stats->ticks += state.ticks;
+	}
+	bar->Merge (slot_bar);
+	return is_read_ok;
+}
+
+/* Trade content of two bars is identical.
+ */
+bool
+gomi::scan_t::IsSameBar (
+	const bar_t& lhs,
+	const bar_t& rhs
+	)
+{
+	return lhs.number_moves_ == rhs.number_moves_ &&
+		lhs.accumulated_volume_ == rhs.accumulated_volume_ &&
+		lhs.open_price_ == rhs.open_price_ &&
+		lhs.close_price_ == rhs.close_price_;
+}
+
+/*  IN: bins of a batch of symbols, each ordered as the bin decls.
+ * OUT: bins populated with day bars, collate with CollateBins().
+ *
+ * The trades of the whole batch are read with one call per business day, over
+ * the union of the time periods still to calculate on that day, and routed by
+ * symbol and timestamp to the bars.  Overnight gaps are never read.
+ *
+ * Returns false on error, true on success.
+ */
+bool
+gomi::scan_t::CalculateBatch (
+	const std::vector<std::vector<bin_t*>>& batch,
+	tick_source_t* source,
+	scan_stats_t* stats
+	) const
+{
+	std::vector<bar_t*> bars;
+	std::vector<bar_t> slot_bars;
+	std::vector<time_window_t> ranges;
+	if (!Bind (batch, &bars, &slot_bars, &ranges))
+		return true;
+
+	std::vector<TBSymbolHandle> handles;
+	std::vector<const char*> symbol_names;
+	handles.reserve (batch.size());
+	symbol_names.reserve (batch.size());
+	std::for_each (batch.begin(), batch.end(), [&](const std::vector<bin_t*>& bins) {
+		handles.push_back (bins.front()->handle_);
+		symbol_names.push_back (bins.front()->GetSymbolName());
+	});
+
+	batch_scan_state_t state;
+	state.scan = this;
+	state.days = &days_;
+	state.slot_bars = slot_bars.data();
+	state.slot_count = slot_count_;
+	state.cursors.assign (batch.size(), std::make_pair ((size_t)0, (size_t)0));
+	state.rows = state.ticks = 0;
+	bool is_ok = true;
+/* oldest business day first, each symbol then delivers in time order */
+	for (size_t t = ranges.size(); is_ok && t-- > 0;) {
+		if (ranges[t].first == ranges[t].second)
+			continue;
+		is_ok = source->ReadBatch (handles.data(), symbol_names.data(), batch.size(), ranges[t].first, ranges[t].second, processBatchTick, &state);
+		if (nullptr != stats)
+			stats->reads++;
+	}
+	if (nullptr != stats) {
+		stats->rows += state.rows;
+		stats->ticks += state.ticks;
+	}
+	Finish (batch, bars, slot_bars, is_ok);
+	DVLOG(3) << "batch of " << batch.size() << " symbols " << (is_ok ? "complete." : "failed.");
+	return is_ok;
+}
+
+/*  IN: bins of one symbol, ordered as the bin decls.
+ * OUT: bins populated with day bars, collate with CollateBins().
+ *
+ * One forward read replaces a read per business day, ticks are bucketed into
+ * business days by binary search of the day boundaries and ticks outside of
+ * every bin time period are dropped.  Cheaper than Calculate() when the call
+ * overhead exceeds the cost of the overnight rows, as with short bins on
+ * illiquid names.
+ *
+ * Returns false on error, true on success.
+ */
+bool
+gomi::scan_t::CalculateRange (
+	const std::vector<bin_t*>& bins,
+	tick_source_t* source,
+	scan_stats_t* stats
+	) const
+{
+	std::vector<std::vector<bin_t*>> batch (1, bins);
+	std::vector<bar_t*> bars;
+	std::vector<bar_t> slot_bars;
+	std::vector<time_window_t> ranges;
+	if (bins.empty() || !Bind (batch, &bars, &slot_bars, &ranges))
+		return true;
+
+/* earliest open to latest close over every business day */
+	time_window_t range (0, 0);
+	std::for_each (ranges.begin(), ranges.end(), [&range](const time_window_t& day_range) {
+		if (day_range.first == day_range.second)
+			return;
+		if (range.first == range.second) {
+			range = day_range;
+		} else {
+			range.first = std::min (range.first, day_range.first);
+			range.second = std::max (range.second, day_range.second);
+		}
+	});
+
+	bool is_ok = true;
+	if (range.first != range.second) {
+		batch_scan_state_t state;
+		state.scan = this;
+		state.days = &days_;
+		state.slot_bars = slot_bars.data();
+		state.slot_count = slot_count_;
+		state.cursors.assign (1, std::make_pair ((size_t)0, (size_t)0));
+		state.rows = state.ticks = 0;
+		is_ok = source->Read (bins.front()->handle_, bins.front()->GetSymbolName(), range.first, range.second, processRangeTick, &state);
+		if (nullptr != stats) {
+			stats->reads++;
+			stats->rows += state.rows;
+			stats->ticks += state.ticks;
+		}
+	}
+	Finish (batch, bars, slot_bars, is_ok);
+	return is_ok;
+}
+
+/* Prepare bins of a batch and collect the bars to calculate, indexed
+ * [(symbol * day_count + day) * bin_count + bin decl], empty elementary bars
+ * of every symbol, and per business day the time range covering their time
+ * periods, empty on days without bars to calculate.
+ *
+ * Returns false when there is nothing to calculate.
+ */
+bool
+gomi::scan_t::Bind (
+	const std::vector<std::vector<bin_t*>>& batch,
+	std::vector<bar_t*>* bars,
+	std::vector<bar_t>* slot_bars,
+	std::vector<time_window_t>* ranges
+	) const
+{
+	std::for_each (batch.begin(), batch.end(), [this](const std::vector<bin_t*>& bins) {
+		Prepare (bins);
+	});
+
+/* no-op */
+	if (batch.empty() || bin_decls_.empty() || days_.empty())
+		return false;
+
+	const size_t bin_count = bin_decls_.size();
+	const size_t day_count = days_.size();
+	bars->assign (batch.size() * day_count * bin_count, nullptr);
+	slot_bars->assign (batch.size() * slot_count_, bar_t());
+	ranges->assign (day_count, time_window_t (0, 0));
+	for (size_t s = 0; s < batch.size(); ++s) {
+		const auto& bins = batch[s];
+		for (unsigned t = 0; t < day_count; ++t) {
+			const auto& day = days_[t];
+			for (unsigned i = 0; i < bin_count; ++i) {
+				if (t >= bin_decls_[i].bin_day_count)
+					continue;
+				auto& bar = bins[i]->GetBar (t);
+				if (bar.IsFinal())
+					continue;
+				bar.Clear();
+				bar.SetTimePeriod (day.windows[i].first, day.windows[i].second);
+/* known quiet time period yields no trades */
+				if (day.windows[i].first != day.windows[i].second &&
+				    GetQuietTill (bins.front()->GetSymbolName(), day.windows[i].first) >= day.windows[i].second)
+				{
+					bar.is_null_ = false;
+					bar.is_final_ = IsSettled (day.windows[i].second);
+					continue;
+				}
+				(*bars)[(s * day_count + t) * bin_count + i] = &bar;
+				if (day.windows[i].first == day.windows[i].second)
+					continue;
+				auto& range = (*ranges)[t];
+				if (range.first == range.second) {
+					range = day.windows[i];
+				} else {
+					range.first = std::min (range.first, day.windows[i].first);
+					range.second = std::max (range.second, day.windows[i].second);
+				}
+			}
+		}
+	}
+	return true;
+}
+
+/* Complete bars of a contiguous read of /batch/ from the elementary bars.
+ */
+void
+gomi::scan_t::Finish (
+	const std::vector<std::vector<bin_t*>>& batch,
+	const std::vector<bar_t*>& bars,
+	const std::vector<bar_t>& slot_bars,
+	bool is_ok
+	) const
+{
+	const size_t bin_count = bin_decls_.size();
+	const size_t symbol_stride = days_.size() * bin_count;
+	for (size_t k = 0; k < bars.size(); ++k) {
+		bar_t* bar = bars[k];
+		if (nullptr == bar)
+			continue;
+		const auto& day = days_[(k % symbol_stride) / bin_count];
+		merge_slots (day.boundaries, slot_bars.data() + (k / symbol_stride) * slot_count_ + day.first_slot, bar->from_, bar->till_, bar);
+/* State now represents bar time period, which may be zero trades */
+		if (is_ok) {
+			bar->is_null_ = false;
+			bar->is_final_ = IsSettled (bar->till_);
+			if (0 == bar->number_moves_)
+				SetQuiet (batch[k / symbol_stride].front()->GetSymbolName(), std::make_pair (bar->from_, bar->till_));
+		}
+	}
+}
+
+/* A time period is final once late trades can no longer arrive, a bar read at
+ * the bin close is within the settle delay and must be read again.
+ */
+bool
+gomi::scan_t::IsSettled (
+	__time32_t till
+	) const
+{
+	return as_of_ >= till + kSettleDelay;
+}
+
+/* Returns end of known quiet time period starting at or before /timestamp/.
+ */
+__time32_t
+gomi::scan_t::GetQuietTill (
+	const char* symbol_name,
+	__time32_t timestamp
+	) const
+{
+	if (nullptr == activity_index_)
+		return timestamp;
+	return activity_index_->GetQuietTill (symbol_name, timestamp);
+}
+
+/* Record a read of /window/ without trades, trades of the last moments before
+ * the scan may yet arrive.
+ */
+void
+gomi::scan_t::SetQuiet (
+	const char* symbol_name,
+	const time_window_t& window
+	) const
+{
+	if (nullptr == activity_index_)
+		return;
+	const __time32_t till = std::min (window.second, as_of_ - kSettleDelay);
+	if (till > window.first)
+		activity_index_->SetQuiet (symbol_name, std::make_pair (window.first, till));
+}
+
+/* Business day of a tick by binary search of the first boundary of each day.
+ * Returns false if within an overnight gap.
+ */
+bool
+gomi::scan_t::Locate (
+	__time32_t timestamp,
+	size_t* day
+	) const
+{
+	auto it = std::upper_bound (day_index_.begin(), day_index_.end(), std::make_pair (timestamp, days_.size()));
+	if (day_index_.begin() == it)
+		return false;
+	--it;
+	if (timestamp >= days_[it->second].boundaries.back())
+		return false;
+	*day = it->second;
+	return true;
+}
+
+/* Business days not yet cached are read, one read per day and symbol, each
+ * with about as many trades as the average cached day.
+ */
+void
+gomi::scan_t::EstimateCost (
+	const std::vector<bin_t*>& bins,
+	uint64_t* reads,
+	uint64_t* ticks
+	) const
+{
+	unsigned pending_days = 0;
+	uint64_t day_ticks = 0;
+	for (unsigned i = 0; i < bins.size(); ++i) {
+		const auto* bin = bins[i];
+/* days to read after roll, the first effective business day is always re-read */
+		unsigned pending = (unsigned)days_.size();
+		for (unsigned t = 0; t < days_.size(); ++t) {
+			if (days_[t].date == bin->cache_date_) {
+				pending = std::max (t, 1u);
+				break;
+			}
+		}
+		pending_days = std::max (pending_days, std::min (pending, bin_decls_[i].bin_day_count));
+/* mean trades of cached days */
+		uint64_t sum = 0, count = 0;
+		std::for_each (bin->bars_.begin(), bin->bars_.end(), [&](const bar_t& bar) {
+			if (!bar)
+				return;
+			sum += bar.number_moves_;
+			++count;
+		});
+		if (count > 0)
+			day_ticks = std::max (day_ticks, sum / count);
+	}
+	*reads = pending_days;
+	*ticks = pending_days * day_ticks;
+}
+
+/* Reset bins of one symbol for a calculation and roll forward cached day bars.
+ */
+void
+gomi::scan_t::Prepare (
+	const std::vector<bin_t*>& bins
+	) const
+{
+	DCHECK_EQ (bins.size(), bin_decls_.size());
+	for (unsigned i = 0; i < bins.size(); ++i)
+		DCHECK_LE (bin_decls_[i].bin_day_count, bins[i]->bars_.size());
+
+/* reset state */
+	std::for_each (bins.begin(), bins.end(), [](bin_t* bin) {
+		bin->Clear();
+	});
+
+	if (bins.empty() || days_.empty())
+		return;
+
+/* save close of first business-day of analytic period */
+	for (unsigned i = 0; i < bins.size(); ++i) {
+		const auto& window = days_[0].windows[i];
+		if (window.first != window.second)
+			bins[i]->close_time_ = boost::posix_time::from_time_t (window.second);
+	}
+
+/* reuse finished day bars from previous calculations */
+	std::for_each (bins.begin(), bins.end(), [this](bin_t* bin) {
+		Roll (bin);
+	});
+}
+
+/* Move cached day bars of a bin to this scan's business days, bars of days
+ * no longer in the analytic period are discarded.
+ */
+void
+gomi::scan_t::Roll (
+	bin_t* bin
+	) const
+{
+	const auto& date = days_[0].date;
+	if (bin->cache_date_ == date)
+		return;
+	for (unsigned t = 1; t < days_.size(); ++t) {
+		if (days_[t].date == bin->cache_date_) {
+			DVLOG(4) << "roll " << bin->GetSymbolName() << " forward " << t << " business days.";
+			bin->Roll (date, t);
+			return;
+		}
+	}
+	bin->Reset();
+	bin->cache_date_ = date;
+}
+
+/* Apply a trade to the elementary bar containing the tick timestamp.
+ *
+ * Returns <1> to continue processing, <2> to halt processing due to an error.
+ */
+int
+gomi::scan_t::processTick (
+	void* closure,
+	__time32_t timestamp,
+	double last_price,
+	uint64_t tick_volume
+	)
+{
+	CHECK(nullptr != closure);
+	auto& state = *static_cast<scan_state_t*> (closure);
+	state.rows++;
+
+/* outside every bin time period */
+	if (!locate_slot (*state.boundaries, timestamp, &state.slot))
+		return 1;
+	state.ticks++;
+
+/* add to partial result of the elementary interval */
+	state.slot_bars[state.slot].Accumulate (last_price, tick_volume);
+
+/* continue processing */
+	return 1;
+}
+
+/* Apply a trade of a contiguous read of one symbol.
+ *
+ * Returns <1> to continue processing.
+ */
+int
+gomi::scan_t::processRangeTick (
+	void* closure,
+	__time32_t timestamp,
+	double last_price,
+	uint64_t tick_volume
+	)
+{
+	return processBatchTick (closure, 0, timestamp, last_price, tick_volume);
+}
+
+/* Apply a trade of a batch to the elementary bar of the symbol containing the
+ * tick timestamp.
+ *
+ * Returns <1> to continue processing.
+ */
+int
+gomi::scan_t::processBatchTick (
+	void* closure,
+	size_t symbol_index,
+	__time32_t timestamp,
+	double last_price,
+	uint64_t tick_volume
+	)
+{
+	CHECK(nullptr != closure);
+	auto& state = *static_cast<batch_scan_state_t*> (closure);
+	const auto& days = *state.days;
+	auto& cursor = state.cursors[symbol_index];
+	state.rows++;
+
+/* business day, typically as previous tick */
+	if (days[cursor.first].boundaries.empty() ||
+	    timestamp < days[cursor.first].boundaries.front() ||
+	    timestamp >= days[cursor.first].boundaries.back())
+	{
+		size_t t;
+/* overnight gap */
+		if (!state.scan->Locate (timestamp, &t))
+			return 1;
+		cursor.first = t;
+		cursor.second = 0;
+	}
+
+	const auto& day = days[cursor.first];
+	if (!locate_slot (day.boundaries, timestamp, &cursor.second))
+		return 1;
+	state.ticks++;
+
+	state.slot_bars[symbol_index * state.slot_count + day.first_slot + cursor.second].Accumulate (last_price, tick_volume);
+
+/* continue processing */
+	return 1;
+}
+
+/* eof */
@@ -0,0 +1,134 @@
+/* Single pass multiple /bin/ FlexRecord scan.
+ *
+ * Every configured bin of a symbol is calculated from one read of the union
+ * of all bin time periods per business day.  The bin time periods are split
+ * into disjoint elementary intervals, each tick is applied once to the bar of
+ * the elementary interval containing the tick timestamp and every bin bar is
+ * then assembled by merging the elementary bars it covers.  Tick work grows
+ * with the covered time span, not with the count of overlapping bin decls.
+ */
+
+#ifndef __GOMI_SCAN_HH__
+#define __GOMI_SCAN_HH__
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Boost Posix Time */
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+/* Boost Gregorian Calendar */
+#include <boost/date_time/gregorian/gregorian_types.hpp>
+
+/* Velocity Analytics Plugin Framework */
+#include <vpf/vpf.h>
+#include <TBPrimitives.h>
+
+#include "calendar.hh"
+#include "gomi_bin.hh"
+#include "period_table.hh"
+#include "tick_source.hh"
+
+namespace gomi
+{
+	class intraday_index_t;
+	class activity_index_t;
+
+/* counts of a calculation for cost modelling */
+	struct scan_stats_t
+	{
+/* tick source read calls */
+		uint64_t reads;
+/* every trade delivered by the tick source */
+		uint64_t rows;
+/* trades within bin time periods */
+		uint64_t ticks;
+	};
+
+/* interval index of a set of /bin/ decls for one business day */
+	struct scan_day_t
+	{
+/* business day */
+		boost::gregorian::date date;
+/* time period per bin decl in Unix epoch, empty when bin is not active for this day */
+		std::vector<time_window_t> windows;
+/* sorted unique start and end times of all bin time periods in Unix epoch,
+ * defining elementary intervals [ boundaries[i], boundaries[i + 1] ).
+ */
+		std::vector<__time32_t> boundaries;
+/* offset of the first elementary interval of this day within all days */
+		size_t first_slot;
+	};
+
+	class scan_t : boost::noncopyable
+	{
+	public:
+/* build interval index for /bin_decls/ over business days of /calendar/ ending
+ * on or before /date/, time periods without trades in /activity_index/ are not
+ * read.
+ */
+		scan_t (const calendar_t& calendar, period_table_t* period_table, activity_index_t* activity_index, const boost::gregorian::date& date, const std::vector<bin_decl_t>& bin_decls);
+
+/* calculate all bins of one symbol, /bins/ ordered as the bin decls, closed
+ * minute aligned bars of the current day are taken from /index/ when provided.
+ */
+		bool Calculate (const std::vector<bin_t*>& bins, tick_source_t* source, intraday_index_t* index = nullptr, scan_stats_t* stats = nullptr) const;
+/* calculate all bins of one symbol ahead of their close, an open time period
+ * of the first effective business day is kept up to a watermark so that a
+ * later Calculate() only reads trades since.  Fills the bar cache only,
+ * analytic results are untouched.
+ */
+		bool CalculateHistory (const std::vector<bin_t*>& bins, tick_source_t* source) const;
+/* calculate all bins of a batch of symbols with one read over the analytic
+ * period, /batch/ holds the bins of each symbol ordered as the bin decls.
+ */
+		bool CalculateBatch (const std::vector<std::vector<bin_t*>>& batch, tick_source_t* source, scan_stats_t* stats = nullptr) const;
+/* calculate all bins of one symbol with one read from the earliest open to
+ * the latest close of the analytic period.
+ */
+		bool CalculateRange (const std::vector<bin_t*>& bins, tick_source_t* source, scan_stats_t* stats = nullptr) const;
+/* expected per-day reads and trades of calculating bins of one symbol, from
+ * the trade counts of cached day bars.
+ */
+		void EstimateCost (const std::vector<bin_t*>& bins, uint64_t* reads, uint64_t* ticks) const;
+
+		const std::vector<scan_day_t>& GetDays() const { return days_; }
+
+	private:
+		bool Scan (const std::vector<bin_t*>& bins, tick_source_t* source, intraday_index_t* index, scan_stats_t* stats) const;
+		bool Rescan (const TBSymbolHandle& handle, const char* symbol_name, const time_window_t& window, tick_source_t* source, scan_stats_t* stats, bar_t* bar) const;
+		static bool IsSameBar (const bar_t& lhs, const bar_t& rhs);
+		void Prepare (const std::vector<bin_t*>& bins) const;
+		void Roll (bin_t* bin) const;
+		bool Bind (const std::vector<std::vector<bin_t*>>& batch, std::vector<bar_t*>* bars, std::vector<bar_t>* slot_bars, std::vector<time_window_t>* ranges) const;
+		bool Locate (__time32_t timestamp, size_t* day) const;
+		void Finish (const std::vector<std::vector<bin_t*>>& batch, const std::vector<bar_t*>& bars, const std::vector<bar_t>& slot_bars, bool is_ok) const;
+		bool IsSettled (__time32_t till) const;
+		__time32_t GetQuietTill (const char* symbol_name, __time32_t timestamp) const;
+		void SetQuiet (const char* symbol_name, const time_window_t& window) const;
+		static int processTick (void* closure, __time32_t timestamp, double last_price, uint64_t tick_volume);
+		static int processRangeTick (void* closure, __time32_t timestamp, double last_price, uint64_t tick_volume);
+		static int processBatchTick (void* closure, size_t symbol_index, __time32_t timestamp, double last_price, uint64_t tick_volume);
+
+		const std::vector<bin_decl_t> bin_decls_;
+		activity_index_t* activity_index_;
+/* bars are final when calculated after the close of their time period and the settle delay */
+		const __time32_t as_of_;
+/* indexed by business day offset, zero is the first effective business day */
+		std::vector<scan_day_t> days_;
+/* first boundary and offset of each business day with a bin time period, ascending in time */
+		std::vector<std::pair<__time32_t, size_t>> day_index_;
+/* elementary intervals over all business days */
+		size_t slot_count_;
+	};
+
+} /* namespace gomi */
+
+#endif /* __GOMI_SCAN_HH__ */
+
+/* eof */
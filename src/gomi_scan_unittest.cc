@@ -0,0 +1,385 @@
+/* Scan unit test with the synthetic tick source, runs without the Analytics
+ * Engine database.
+ *
+ * Returns zero on success, non-zero with each failure logged to stderr.
+ */
+
+#include "gomi_scan.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "activity_index.hh"
+#include "calendar.hh"
+#include "period_table.hh"
+#include "tick_source.hh"
+#include "unittest.hh"
+
+static const char* kPath = "gomi_scan_unittest.txt";
+
+/* Mean seconds between synthetic trades. */
+static const unsigned kTickInterval = 30;
+
+/* Settle delay and watermark overlap of scans. */
+static const int kSettleDelay = 60;
+static const int kWatermarkOverlap = 60;
+
+namespace
+{
+/* synthetic trades, recording the time range of every batch read */
+	class recording_tick_source_t : public gomi::synthetic_tick_source_t
+	{
+	public:
+		recording_tick_source_t() : gomi::synthetic_tick_source_t (kTickInterval) {}
+
+		virtual bool ReadBatch (const TBSymbolHandle* handles, const char* const* symbol_names, size_t symbol_count, __time32_t from, __time32_t till, gomi::batch_tick_callback_t callback, void* closure) override {
+			ranges.push_back (gomi::time_window_t (from, till));
+			return gomi::tick_source_t::ReadBatch (handles, symbol_names, symbol_count, from, till, callback, closure);
+		}
+
+		std::vector<gomi::time_window_t> ranges;
+	};
+
+/* synthetic trades plus one late trade at /late/ when set */
+	class late_tick_source_t : public gomi::synthetic_tick_source_t
+	{
+	public:
+		late_tick_source_t() : gomi::synthetic_tick_source_t (5), late (0) {}
+
+		virtual bool Read (const TBSymbolHandle& handle, const char* symbol_name, __time32_t from, __time32_t till, gomi::tick_callback_t callback, void* closure) override {
+			if (0 == late || late < from || late >= till)
+				return gomi::synthetic_tick_source_t::Read (handle, symbol_name, from, till, callback, closure);
+			return gomi::synthetic_tick_source_t::Read (handle, symbol_name, from, late, callback, closure) &&
+			       1 == callback (closure, late, 1.0, 100) &&
+			       gomi::synthetic_tick_source_t::Read (handle, symbol_name, late, till, callback, closure);
+		}
+
+		__time32_t late;
+	};
+
+/* bins of every symbol, each ordered as the bin decls */
+	typedef std::vector<std::vector<std::shared_ptr<gomi::bin_t>>> symbol_bins_t;
+}
+
+static
+std::vector<gomi::bin_decl_t>
+make_bin_decls()
+{
+	using boost::posix_time::time_duration;
+	const boost::local_time::time_zone_ptr tz (new boost::local_time::posix_time_zone ("EST-5EDT,M3.2.0,M11.1.0"));
+	const struct {
+		const char* name;
+		time_duration start, end;
+		unsigned day_count;
+	} decls[] = {
+		{ "0930-1000", time_duration (9, 30, 0), time_duration (10, 0, 0), 5 },
+		{ "0930-1600", time_duration (9, 30, 0), time_duration (16, 0, 0), 5 },
+		{ "1530-1600", time_duration (15, 30, 0), time_duration (16, 0, 0), 3 }
+	};
+	std::vector<gomi::bin_decl_t> bin_decls;
+	for (size_t i = 0; i < sizeof (decls) / sizeof (decls[0]); ++i) {
+		gomi::bin_decl_t bin_decl;
+		bin_decl.bin_name = decls[i].name;
+		bin_decl.bin_start = decls[i].start;
+		bin_decl.bin_end = decls[i].end;
+		bin_decl.bin_tz = tz;
+		bin_decl.bin_day_count = decls[i].day_count;
+		bin_decl.bin_analytic_day_count = decls[i].day_count;
+		bin_decl.bin_windows.push_back (decls[i].day_count);
+		bin_decls.push_back (bin_decl);
+	}
+	return bin_decls;
+}
+
+static
+symbol_bins_t
+make_bins (
+	const std::vector<gomi::bin_decl_t>& bin_decls,
+	const std::vector<const char*>& symbol_names
+	)
+{
+	symbol_bins_t symbol_bins (symbol_names.size());
+	for (size_t j = 0; j < symbol_names.size(); ++j)
+		for (size_t i = 0; i < bin_decls.size(); ++i)
+			symbol_bins[j].push_back (std::make_shared<gomi::bin_t> (bin_decls[i], symbol_names[j], "LastPrice", "TickVolume"));
+	return symbol_bins;
+}
+
+static
+std::vector<gomi::bin_t*>
+get_bins (
+	const std::vector<std::shared_ptr<gomi::bin_t>>& v
+	)
+{
+	std::vector<gomi::bin_t*> bins;
+	for (auto it = v.begin(); it != v.end(); ++it)
+		bins.push_back (it->get());
+	return bins;
+}
+
+static
+bool
+load_calendar (
+	gomi::calendar_t* calendar
+	)
+{
+	FILE* fp = fopen (kPath, "w");
+	if (nullptr == fp)
+		return false;
+	fputs ("2012-03-05\n2012-03-06\n2012-03-07\n2012-03-08\n2012-03-09\n2012-03-12\n", fp);
+	fclose (fp);
+	const bool is_ok = calendar->LoadFile (kPath);
+	remove (kPath);
+	return is_ok;
+}
+
+/* Same day bars of every symbol, bin decl and business day, returns count of
+ * bars with trades.
+ */
+static
+unsigned
+expect_same_bars (
+	const std::vector<gomi::bin_decl_t>& bin_decls,
+	const symbol_bins_t& lhs,
+	const symbol_bins_t& rhs
+	)
+{
+	unsigned traded = 0;
+	for (size_t j = 0; j < lhs.size(); ++j) {
+		for (size_t i = 0; i < bin_decls.size(); ++i) {
+			for (unsigned t = 0; t < bin_decls[i].bin_day_count; ++t) {
+				auto& a = lhs[j][i]->GetBar (t);
+				auto& b = rhs[j][i]->GetBar (t);
+				EXPECT((bool)a && (bool)b);
+				EXPECT(a.IsFinal() && b.IsFinal());
+				EXPECT(a.GetOpenPrice() == b.GetOpenPrice());
+				EXPECT(a.GetClosePrice() == b.GetClosePrice());
+				EXPECT(a.GetNumberMoves() == b.GetNumberMoves());
+				EXPECT(a.GetAccumulatedVolume() == b.GetAccumulatedVolume());
+				if (a.GetNumberMoves() > 0)
+					++traded;
+			}
+		}
+	}
+	return traded;
+}
+
+/* One batch read per business day over the union of that day's bin time
+ * periods yields the same day bars as a read per symbol and business day,
+ * and as one contiguous read per symbol.
+ */
+static
+void
+test_batch()
+{
+	using boost::gregorian::date;
+	gomi::calendar_t calendar;
+	EXPECT(load_calendar (&calendar));
+
+	const auto bin_decls = make_bin_decls();
+	gomi::period_table_t period_table;
+	const gomi::scan_t scan (calendar, &period_table, nullptr, date (2012, 3, 12), bin_decls);
+	EXPECT(5 == scan.GetDays().size());
+
+	std::vector<const char*> symbol_names;
+	symbol_names.push_back ("A.N");
+	symbol_names.push_back ("B.N");
+	symbol_names.push_back ("C.N");
+	symbol_names.push_back ("D.N");
+
+	gomi::synthetic_tick_source_t source (kTickInterval);
+	auto per_symbol = make_bins (bin_decls, symbol_names);
+	for (size_t j = 0; j < per_symbol.size(); ++j)
+		EXPECT(scan.Calculate (get_bins (per_symbol[j]), &source));
+
+	recording_tick_source_t batch_source;
+	auto batch = make_bins (bin_decls, symbol_names);
+	std::vector<std::vector<gomi::bin_t*>> batch_bins;
+	for (size_t j = 0; j < batch.size(); ++j)
+		batch_bins.push_back (get_bins (batch[j]));
+	gomi::scan_stats_t stats = { 0, 0, 0 };
+	EXPECT(scan.CalculateBatch (batch_bins, &batch_source, &stats));
+	EXPECT(stats.reads == scan.GetDays().size());
+	EXPECT(stats.ticks > 0 && stats.rows >= stats.ticks);
+
+/* each read lies within one business day, overnight gaps are never read */
+	EXPECT(batch_source.ranges.size() == scan.GetDays().size());
+	for (size_t k = 0; k < batch_source.ranges.size(); ++k) {
+		const auto& range = batch_source.ranges[k];
+		const auto& day = scan.GetDays()[scan.GetDays().size() - 1 - k];
+		EXPECT(range.first == day.boundaries.front());
+		EXPECT(range.second == day.boundaries.back());
+	}
+
+	auto range = make_bins (bin_decls, symbol_names);
+	gomi::scan_stats_t range_stats = { 0, 0, 0 };
+	for (size_t j = 0; j < range.size(); ++j)
+		EXPECT(scan.CalculateRange (get_bins (range[j]), &source, &range_stats));
+/* contiguous reads also deliver overnight trades */
+	EXPECT(range_stats.reads == range.size());
+	EXPECT(range_stats.rows > range_stats.ticks);
+	EXPECT(range_stats.ticks == stats.ticks);
+
+	EXPECT(expect_same_bars (bin_decls, per_symbol, batch) > 0);
+	EXPECT(expect_same_bars (bin_decls, per_symbol, range) > 0);
+
+/* final bars are not read again */
+	batch_source.ranges.clear();
+	EXPECT(scan.CalculateBatch (batch_bins, &batch_source));
+	EXPECT(batch_source.ranges.empty());
+	EXPECT(expect_same_bars (bin_decls, per_symbol, batch) > 0);
+}
+
+/* Reads of thin names without trades record quiet time periods, later scans
+ * of new bins skip them and still yield the same day bars.
+ */
+static
+void
+test_quiet()
+{
+	using boost::gregorian::date;
+	gomi::calendar_t calendar;
+	EXPECT(load_calendar (&calendar));
+
+/* half hour bins only, a read of the full day bin spans both */
+	auto bin_decls = make_bin_decls();
+	bin_decls.erase (bin_decls.begin() + 1);
+	gomi::period_table_t period_table;
+	gomi::activity_index_t activity_index;
+	const gomi::scan_t scan (calendar, &period_table, &activity_index, date (2012, 3, 12), bin_decls);
+	const gomi::scan_t reference_scan (calendar, &period_table, nullptr, date (2012, 3, 12), bin_decls);
+
+	std::vector<const char*> symbol_names;
+	symbol_names.push_back ("A.N");
+	symbol_names.push_back ("B.N");
+
+/* about one trade an hour leaves many half hour bars empty */
+	gomi::synthetic_tick_source_t source (60 * 60);
+	auto reference = make_bins (bin_decls, symbol_names);
+	for (size_t j = 0; j < reference.size(); ++j)
+		EXPECT(reference_scan.Calculate (get_bins (reference[j]), &source));
+
+	auto first = make_bins (bin_decls, symbol_names);
+	gomi::scan_stats_t first_stats = { 0, 0, 0 };
+	for (size_t j = 0; j < first.size(); ++j)
+		EXPECT(scan.Calculate (get_bins (first[j]), &source, nullptr, &first_stats));
+	EXPECT(symbol_names.size() == activity_index.GetSymbolCount());
+
+	auto second = make_bins (bin_decls, symbol_names);
+	gomi::scan_stats_t second_stats = { 0, 0, 0 };
+	for (size_t j = 0; j < second.size(); ++j)
+		EXPECT(scan.Calculate (get_bins (second[j]), &source, nullptr, &second_stats));
+	EXPECT(second_stats.reads < first_stats.reads);
+	EXPECT(second_stats.ticks == first_stats.ticks);
+
+	EXPECT(expect_same_bars (bin_decls, reference, first) > 0);
+	EXPECT(expect_same_bars (bin_decls, reference, second) > 0);
+
+/* expired quiet time periods are read again */
+	activity_index.Expire (_time32 (nullptr));
+	EXPECT(0 == activity_index.GetSymbolCount());
+	auto third = make_bins (bin_decls, symbol_names);
+	gomi::scan_stats_t third_stats = { 0, 0, 0 };
+	for (size_t j = 0; j < third.size(); ++j)
+		EXPECT(scan.Calculate (get_bins (third[j]), &source, nullptr, &third_stats));
+	EXPECT(third_stats.reads == first_stats.reads);
+	EXPECT(expect_same_bars (bin_decls, reference, third) > 0);
+}
+
+/* Rescans of an open time period resume at the watermark and re-read only
+ * the overlap before it, a late trade within the overlap discards the partial
+ * bar and the time period is read in full.
+ */
+static
+void
+test_watermark()
+{
+	using namespace boost::posix_time;
+	using boost::gregorian::date;
+	using boost::gregorian::days;
+	const ptime now (second_clock::universal_time());
+	const time_duration tod (now.time_of_day());
+/* watermark and its overlap must lie within today's time period */
+	if (tod < minutes (5) || tod > hours (23) + minutes (55)) {
+		fprintf (stderr, "watermark test skipped at midnight.\n");
+		return;
+	}
+	const date today (now.date());
+	FILE* fp = fopen (kPath, "w");
+	EXPECT(nullptr != fp);
+	if (nullptr == fp)
+		return;
+	fprintf (fp, "%s\n%s\n", to_iso_extended_string (today - days (1)).c_str(), to_iso_extended_string (today).c_str());
+	fclose (fp);
+	gomi::calendar_t calendar;
+	EXPECT(calendar.LoadFile (kPath));
+	remove (kPath);
+
+/* open time period from up to an hour ago until an hour after now */
+	gomi::bin_decl_t bin_decl;
+	bin_decl.bin_name = "open";
+	bin_decl.bin_start = std::max (tod - hours (1), time_duration (0, 0, 0));
+	bin_decl.bin_end = std::min (tod + hours (1), time_duration (23, 59, 59));
+	bin_decl.bin_tz.reset (new boost::local_time::posix_time_zone ("UTC0"));
+	bin_decl.bin_day_count = 2;
+	bin_decl.bin_analytic_day_count = 2;
+	bin_decl.bin_windows.push_back (2);
+	const std::vector<gomi::bin_decl_t> bin_decls (1, bin_decl);
+	std::vector<const char*> symbol_names (1, "A.N");
+	gomi::period_table_t period_table;
+
+	late_tick_source_t source;
+	auto bins = make_bins (bin_decls, symbol_names);
+	gomi::scan_stats_t first_stats = { 0, 0, 0 };
+	const __time32_t t0 = _time32 (nullptr);
+	{
+		const gomi::scan_t scan (calendar, &period_table, nullptr, today, bin_decls);
+		EXPECT(scan.Calculate (get_bins (bins[0]), &source, nullptr, &first_stats));
+	}
+	EXPECT(!bins[0][0]->GetBar (0).IsFinal());
+
+/* without late trades only the overlap and trades since are read */
+	gomi::scan_stats_t second_stats = { 0, 0, 0 };
+	{
+		const gomi::scan_t scan (calendar, &period_table, nullptr, today, bin_decls);
+		EXPECT(scan.Calculate (get_bins (bins[0]), &source, nullptr, &second_stats));
+	}
+	EXPECT(second_stats.rows < first_stats.rows);
+
+/* late trade within the overlap of either watermark */
+	source.late = t0 - kSettleDelay - kWatermarkOverlap / 2;
+	{
+		const gomi::scan_t scan (calendar, &period_table, nullptr, today, bin_decls);
+		EXPECT(scan.Calculate (get_bins (bins[0]), &source, nullptr));
+	}
+	auto reference = make_bins (bin_decls, symbol_names);
+	{
+		const gomi::scan_t scan (calendar, &period_table, nullptr, today, bin_decls);
+		EXPECT(scan.Calculate (get_bins (reference[0]), &source, nullptr));
+	}
+	for (unsigned t = 0; t < bin_decl.bin_day_count; ++t) {
+		auto& a = bins[0][0]->GetBar (t);
+		auto& b = reference[0][0]->GetBar (t);
+		EXPECT((bool)a && (bool)b);
+		EXPECT(a.GetNumberMoves() == b.GetNumberMoves());
+		EXPECT(a.GetAccumulatedVolume() == b.GetAccumulatedVolume());
+		EXPECT(a.GetOpenPrice() == b.GetOpenPrice());
+		EXPECT(a.GetClosePrice() == b.GetClosePrice());
+	}
+}
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	test_batch();
+	test_quiet();
+	test_watermark();
+	return unittest::Result();
+}
+
+/* eof */
@@ -0,0 +1,301 @@
+/* Minute resolution intraday index for ad-hoc bin queries.
+ */
+
+#include "intraday_index.hh"
+
+#include <algorithm>
+#include <ctime>
+
+#include "chromium/logging.hh"
+
+/* http://en.wikipedia.org/wiki/Unix_epoch */
+static const boost::gregorian::date kUnixEpoch (1970, 1, 1);
+
+/* Trades of the most recent minutes may not have reached the database, only
+ * seal minutes closed at least this many seconds ago.
+ */
+static const int kSealDelay = 60;
+
+/* Convert Posix time to Unix Epoch time.
+ */
+static
+__time32_t
+to_unix_epoch (
+	const boost::posix_time::ptime t
+	)
+{
+	return (t - boost::posix_time::ptime (kUnixEpoch)).total_seconds();
+}
+
+/* Start and end of a local calendar day in Unix epoch, 23 or 25 hours on
+ * daylight saving transitions.  Returns false if local midnight does not exist.
+ */
+static
+bool
+to_day_window (
+	const boost::gregorian::date& date,
+	const boost::local_time::time_zone_ptr& tz,
+	gomi::time_window_t* window
+	)
+{
+	using namespace boost::local_time;
+	const local_date_time start_ldt (date, boost::posix_time::hours (0), tz, local_date_time::NOT_DATE_TIME_ON_ERROR);
+	const local_date_time end_ldt (date + boost::gregorian::days (1), boost::posix_time::hours (0), tz, local_date_time::NOT_DATE_TIME_ON_ERROR);
+	if (start_ldt.is_not_a_date_time() || end_ldt.is_not_a_date_time())
+		return false;
+	window->first = to_unix_epoch (start_ldt.utc_time());
+	window->second = to_unix_epoch (end_ldt.utc_time());
+	return true;
+}
+
+gomi::intraday_day_t::intraday_day_t (
+	__time32_t from,
+	__time32_t till
+	) :
+	from_ (from),
+	till_ (till),
+	sealed_ (from)
+{
+	moves_.push_back (0);
+	volume_.push_back (0);
+	rank_.push_back (0);
+}
+
+void
+gomi::intraday_day_t::Absorb (
+	__time32_t timestamp,
+	double last_price,
+	uint64_t tick_volume
+	)
+{
+	if (timestamp < sealed_ || timestamp >= till_)
+		return;
+	const uint16_t minute = (uint16_t)((timestamp - from_) / 60);
+	DCHECK (minute_.empty() || minute >= minute_.back());
+	if (minute_.empty() || minute > minute_.back()) {
+		minute_.push_back (minute);
+		open_.push_back (last_price);
+		close_.push_back (last_price);
+		moves_.push_back (moves_.back());
+		volume_.push_back (volume_.back());
+	}
+	close_.back() = last_price;
+	++moves_.back();
+	volume_.back() += tick_volume;
+}
+
+void
+gomi::intraday_day_t::Seal (
+	__time32_t till
+	)
+{
+	till = std::min (till, till_);
+	const unsigned minute_count = (till - from_) / 60;
+	size_t k = rank_.back();
+	for (unsigned m = (unsigned)rank_.size(); m <= minute_count; ++m) {
+		while (k < minute_.size() && minute_[k] < m)
+			++k;
+		rank_.push_back ((uint16_t)k);
+	}
+	sealed_ = std::max (sealed_, from_ + (__time32_t)(60 * minute_count));
+}
+
+bool
+gomi::intraday_day_t::Get (
+	const time_window_t& window,
+	bar_t* bar,
+	__time32_t* till
+	) const
+{
+	if (window.first < from_ || window.first >= sealed_ || window.second > till_ || window.second <= window.first)
+		return false;
+	const __time32_t end = std::min (window.second, sealed_);
+	if (0 != (window.first - from_) % 60 || 0 != (end - from_) % 60)
+		return false;
+	const size_t i = rank_[(window.first - from_) / 60];
+	const size_t j = rank_[(end - from_) / 60];
+	if (i == j)
+		bar->Restore (0.0, 0.0, 0, 0);
+	else
+		bar->Restore (open_[i], close_[j - 1], moves_[j] - moves_[i], volume_[j] - volume_[i]);
+	*till = end;
+	return true;
+}
+
+gomi::intraday_index_t::intraday_index_t (
+	size_t symbol_limit
+	) :
+	symbol_limit_ (symbol_limit)
+{
+}
+
+/* Returns symbol entry, created if absent, and marks most recently used.
+ */
+std::shared_ptr<gomi::intraday_index_t::symbol_t>
+gomi::intraday_index_t::Acquire (
+	const char* symbol_name,
+	const boost::local_time::time_zone_ptr& tz
+	)
+{
+	std::string key (symbol_name);
+	key.push_back ('@');
+	key.append (tz->std_zone_name());
+
+	boost::lock_guard<boost::mutex> lock (lock_);
+	auto it = symbols_.find (key);
+	if (symbols_.end() != it) {
+		lru_.splice (lru_.begin(), lru_, it->second->lru);
+		return it->second;
+	}
+/* evict, in-flight users retain their reference */
+	while (!lru_.empty() && symbols_.size() >= symbol_limit_) {
+		symbols_.erase (lru_.back());
+		lru_.pop_back();
+	}
+	auto symbol = std::make_shared<symbol_t>();
+	lru_.push_front (key);
+	symbol->lru = lru_.begin();
+	symbols_.insert (std::make_pair (key, symbol));
+	return symbol;
+}
+
+/* Returns the day of /date/ with every closed minute indexed, nullptr on
+ * error.  Caller holds the symbol lock.
+ */
+std::shared_ptr<gomi::intraday_day_t>
+gomi::intraday_index_t::Seal (
+	symbol_t* symbol,
+	const TBSymbolHandle& handle,
+	const char* symbol_name,
+	const boost::gregorian::date& date,
+	const boost::local_time::time_zone_ptr& tz,
+	tick_source_t* source
+	)
+{
+	auto& day = symbol->days[date];
+	if (!(bool)day) {
+		time_window_t day_window;
+		if (!to_day_window (date, tz, &day_window)) {
+			symbol->days.erase (date);
+			return nullptr;
+		}
+		day.reset (new intraday_day_t (day_window.first, day_window.second));
+	}
+
+/* extend the sealed period of the current day */
+	if (day->GetSealed() < day->GetTill()) {
+		const __time32_t now = _time32 (nullptr) - kSealDelay;
+		if (now > day->GetFrom()) {
+			const __time32_t till = std::min (day->GetTill(), day->GetFrom() + 60 * ((now - day->GetFrom()) / 60));
+			if (till > day->GetSealed()) {
+/* a partial read cannot be resumed, index the day again on next use */
+				if (!source->Read (handle, symbol_name, day->GetSealed(), till, processTick, day.get())) {
+					symbol->days.erase (date);
+					return nullptr;
+				}
+				day->Seal (till);
+				DVLOG(4) << "indexed " << symbol_name << " " << to_simple_string (date) << " until " << till;
+			}
+		}
+	}
+	return day;
+}
+
+bool
+gomi::intraday_index_t::Get (
+	const TBSymbolHandle& handle,
+	const char* symbol_name,
+	const boost::gregorian::date& date,
+	const boost::local_time::time_zone_ptr& tz,
+	const time_window_t& window,
+	tick_source_t* source,
+	bar_t* bar,
+	__time32_t* till
+	)
+{
+	if (0 == symbol_limit_ || window.first == window.second)
+		return false;
+	auto symbol = Acquire (symbol_name, tz);
+	boost::lock_guard<boost::mutex> lock (symbol->lock);
+	const auto day = Seal (symbol.get(), handle, symbol_name, date, tz, source);
+	return (bool)day && day->Get (window, bar, till);
+}
+
+bool
+gomi::intraday_index_t::Extend (
+	const TBSymbolHandle& handle,
+	const char* symbol_name,
+	const boost::gregorian::date& date,
+	const boost::local_time::time_zone_ptr& tz,
+	tick_source_t* source
+	)
+{
+	if (0 == symbol_limit_)
+		return false;
+	auto symbol = Acquire (symbol_name, tz);
+	boost::lock_guard<boost::mutex> lock (symbol->lock);
+	return (bool)Seal (symbol.get(), handle, symbol_name, date, tz, source);
+}
+
+void
+gomi::intraday_index_t::Invalidate (
+	const char* symbol_name,
+	const time_window_t& window
+	)
+{
+	std::string prefix (symbol_name);
+	prefix.push_back ('@');
+
+	boost::lock_guard<boost::mutex> lock (lock_);
+	std::for_each (symbols_.begin(), symbols_.end(), [&](const std::pair<const std::string, std::shared_ptr<symbol_t>>& pair) {
+		if (0 != pair.first.compare (0, prefix.size(), prefix))
+			return;
+		boost::lock_guard<boost::mutex> symbol_lock (pair.second->lock);
+		auto& days = pair.second->days;
+		for (auto it = days.begin(); it != days.end();) {
+			if (it->second->GetFrom() < window.second && window.first < it->second->GetTill())
+				it = days.erase (it);
+			else
+				++it;
+		}
+	});
+}
+
+void
+gomi::intraday_index_t::Expire (
+	const boost::gregorian::date& date
+	)
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	std::for_each (symbols_.begin(), symbols_.end(), [&date](const std::pair<const std::string, std::shared_ptr<symbol_t>>& pair) {
+		boost::lock_guard<boost::mutex> symbol_lock (pair.second->lock);
+		auto& days = pair.second->days;
+		days.erase (days.begin(), days.lower_bound (date));
+	});
+}
+
+size_t
+gomi::intraday_index_t::GetSymbolCount() const
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	return symbols_.size();
+}
+
+/* Returns <1> to continue processing.
+ */
+int
+gomi::intraday_index_t::processTick (
+	void* closure,
+	__time32_t timestamp,
+	double last_price,
+	uint64_t tick_volume
+	)
+{
+	CHECK(nullptr != closure);
+	auto& day = *static_cast<intraday_day_t*> (closure);
+	day.Absorb (timestamp, last_price, tick_volume);
+/* continue processing */
+	return 1;
+}
+
+/* eof */
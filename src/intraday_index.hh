@@ -0,0 +1,120 @@
+/* Minute resolution intraday index for ad-hoc bin queries.
+ *
+ * Each indexed symbol day is reduced to one minute sub-bars with prefix sums
+ * of moves and volume, the bar of any minute aligned time period is then the
+ * difference of two prefix entries with open and close taken from the first
+ * and last active minute, without reading trades again.
+ */
+
+#ifndef __INTRADAY_INDEX_HH__
+#define __INTRADAY_INDEX_HH__
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Boost Date Time */
+#include <boost/date_time/local_time/local_time.hpp>
+
+/* Boost Gregorian Calendar */
+#include <boost/date_time/gregorian/gregorian_types.hpp>
+
+/* Boost threading. */
+#include <boost/thread.hpp>
+
+/* Velocity Analytics Plugin Framework */
+#include <vpf/vpf.h>
+#include <TBPrimitives.h>
+
+#include "gomi_bar.hh"
+#include "period_table.hh"
+#include "tick_source.hh"
+
+namespace gomi
+{
+/* one minute sub-bars of one symbol over one local calendar day */
+	class intraday_day_t : boost::noncopyable
+	{
+	public:
+		intraday_day_t (__time32_t from, __time32_t till);
+
+/* add a trade, trades must be presented in time order */
+		void Absorb (__time32_t timestamp, double last_price, uint64_t tick_volume);
+/* all trades before /till/ have been absorbed, rounded down to a minute */
+		void Seal (__time32_t till);
+
+/* bar of minute aligned /window/ up to the sealed period, /till/ set to the
+ * end of the answered prefix.  Returns false if no prefix can be answered.
+ */
+		bool Get (const time_window_t& window, bar_t* bar, __time32_t* till) const;
+
+		__time32_t GetFrom() const { return from_; }
+		__time32_t GetTill() const { return till_; }
+		__time32_t GetSealed() const { return sealed_; }
+
+	private:
+		const __time32_t from_, till_;
+		__time32_t sealed_;
+/* per active minute: minute offset from start of day, first and last trade price */
+		std::vector<uint16_t> minute_;
+		std::vector<double> open_, close_;
+/* prefix sums over active minutes, leading zero */
+		std::vector<uint32_t> moves_;
+		std::vector<uint64_t> volume_;
+/* per minute boundary up to sealed_, count of active minutes before */
+		std::vector<uint16_t> rank_;
+	};
+
+	class intraday_index_t : boost::noncopyable
+	{
+	public:
+/* retain at most /symbol_limit/ symbols, least recently used are discarded */
+		explicit intraday_index_t (size_t symbol_limit);
+
+/* bar of /symbol_name/ for /window/ of business day /date/ in /tz/, trades of
+ * the day are read from /source/ on first use.  /till/ is set to the end of
+ * the answered prefix, trades from /till/ on are not yet indexed.  Returns
+ * false if the window is not minute aligned, the caller then scans trades.
+ */
+		bool Get (const TBSymbolHandle& handle, const char* symbol_name, const boost::gregorian::date& date, const boost::local_time::time_zone_ptr& tz, const time_window_t& window, tick_source_t* source, bar_t* bar, __time32_t* till);
+/* index trades of /symbol_name/ on /date/ closed since the last call */
+		bool Extend (const TBSymbolHandle& handle, const char* symbol_name, const boost::gregorian::date& date, const boost::local_time::time_zone_ptr& tz, tick_source_t* source);
+/* discard indexed days of /symbol_name/ overlapping /window/ in any time zone */
+		void Invalidate (const char* symbol_name, const time_window_t& window);
+/* discard days before /date/ */
+		void Expire (const boost::gregorian::date& date);
+
+		size_t GetSymbolCount() const;
+
+	private:
+		struct symbol_t
+		{
+			boost::mutex lock;
+			std::map<boost::gregorian::date, std::shared_ptr<intraday_day_t>> days;
+			std::list<std::string>::iterator lru;
+		};
+
+		std::shared_ptr<symbol_t> Acquire (const char* symbol_name, const boost::local_time::time_zone_ptr& tz);
+		std::shared_ptr<intraday_day_t> Seal (symbol_t* symbol, const TBSymbolHandle& handle, const char* symbol_name, const boost::gregorian::date& date, const boost::local_time::time_zone_ptr& tz, tick_source_t* source);
+		static int processTick (void* closure, __time32_t timestamp, double last_price, uint64_t tick_volume);
+
+		const size_t symbol_limit_;
+		std::unordered_map<std::string, std::shared_ptr<symbol_t>> symbols_;
+/* most recently used first */
+		std::list<std::string> lru_;
+		mutable boost::mutex lock_;
+	};
+
+} /* namespace gomi */
+
+#endif /* __INTRADAY_INDEX_HH__ */
+
+/* eof */
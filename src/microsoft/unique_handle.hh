@@ -22,6 +22,33 @@ namespace ms
 		}
 	};
 
+/* CreateFile returns INVALID_HANDLE_VALUE on failure instead of NULL. */
+	struct file_handle_traits
+	{
+		static HANDLE invalid() throw()
+		{
+			return INVALID_HANDLE_VALUE;
+		}
+ 
+		static void close(HANDLE value) throw()
+		{
+			CloseHandle (value);
+		}
+	};
+
+	struct map_view_traits
+	{
+		static void* invalid() throw()
+		{
+			return nullptr;
+		}
+ 
+		static void close(void* value) throw()
+		{
+			UnmapViewOfFile (value);
+		}
+	};
+
 	template <typename Type, typename Traits>
 	class unique_handle
 	{
@@ -105,6 +132,8 @@ namespace ms
  * handle h (CreateEvent (...));
  */
 	typedef unique_handle<HANDLE, handle_traits> handle;
+	typedef unique_handle<HANDLE, file_handle_traits> file_handle;
+	typedef unique_handle<void*, map_view_traits> map_view;
 
 } /* namespace ms */
 
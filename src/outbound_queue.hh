@@ -0,0 +1,165 @@
+/* Prioritised outbound message queue with per stream image conflation.
+ *
+ * Messages are queued per publish priority and dequeued highest priority
+ * first, in order within a priority.  Only the newest image of a stream is
+ * submitted: a pending image is overwritten in place, and messages queued
+ * before the newest image are stale as it holds every value they do.
+ *
+ * Not thread safe, the session serialises access with its queue lock.
+ */
+
+#ifndef __OUTBOUND_QUEUE_HH__
+#define __OUTBOUND_QUEUE_HH__
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
+/* Boost Posix Time */
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+/* Boost noncopyable base class */
+#include <boost/utility.hpp>
+
+#include "chromium/logging.hh"
+
+namespace gomi
+{
+/* Publish priority, realtime summaries are sent ahead of archive streams. */
+	enum publish_priority_t {
+		PUBLISH_PRIORITY_REALTIME,
+		PUBLISH_PRIORITY_ARCHIVE,
+		PUBLISH_PRIORITY_MAX
+	};
+
+	enum enqueue_result_t {
+		ENQUEUE_QUEUED,
+/* pending image of the stream overwritten */
+		ENQUEUE_CONFLATED,
+/* queue at capacity */
+		ENQUEUE_DROPPED
+	};
+
+/* /Msg/ shared between session queues, /Token/ identifies the stream. */
+	template <typename Msg, typename Token>
+	class outbound_queue_t : boost::noncopyable
+	{
+	public:
+		struct outbound_t
+		{
+			std::shared_ptr<const Msg> msg;
+			Token* token;
+			size_t size;
+			boost::posix_time::ptime enqueue_time;
+			uint64_t generation;
+			uint64_t token_generation;
+/* counted in SESSION_PC_MSGS_PACED */
+			bool is_paced;
+		};
+
+		explicit outbound_queue_t (size_t capacity) :
+			depth_ (0),
+			capacity_ (capacity)
+		{
+		}
+
+/* Queue /outbound/ at /priority/, an image overwrites a pending image of the
+ * same token taking its message.
+ */
+		enqueue_result_t Push (publish_priority_t priority, bool is_image, outbound_t* outbound) {
+			DCHECK_LT (priority, PUBLISH_PRIORITY_MAX);
+			auto it = pending_.find (outbound->token);
+			if (is_image && pending_.end() != it && nullptr != it->second.image) {
+				auto& image = *it->second.image;
+				image.msg.swap (outbound->msg);
+				image.size = outbound->size;
+				image.generation = ++it->second.generation;
+				return ENQUEUE_CONFLATED;
+			}
+			if (depth_ >= capacity_)
+				return ENQUEUE_DROPPED;
+			if (pending_.end() == it) {
+				pending_t pending;
+				pending.generation = 0;
+				pending.image = nullptr;
+				pending.count = 0;
+				it = pending_.insert (std::make_pair (outbound->token, pending)).first;
+			}
+			if (is_image)
+				++it->second.generation;
+			outbound->generation = it->second.generation;
+/* deque references survive push_back and pop_front of other elements */
+			queue_[priority].push_back (*outbound);
+			++it->second.count;
+			if (is_image)
+				it->second.image = &queue_[priority].back();
+			++depth_;
+			return ENQUEUE_QUEUED;
+		}
+
+/* Next message of the highest non-empty priority, nullptr when empty. */
+		outbound_t* Front() {
+			auto queue = std::find_if (queue_, queue_ + PUBLISH_PRIORITY_MAX, [](const std::deque<outbound_t>& q) {
+				return !q.empty();
+			});
+			return (queue_ + PUBLISH_PRIORITY_MAX == queue) ? nullptr : &queue->front();
+		}
+
+/* Queued message is not superseded by a later image of the stream. */
+		bool IsCurrent (const outbound_t& outbound) const {
+			auto it = pending_.find (outbound.token);
+			DCHECK (pending_.end() != it);
+			return it->second.generation == outbound.generation;
+		}
+
+/* Remove Front(). */
+		void PopFront() {
+			auto queue = std::find_if (queue_, queue_ + PUBLISH_PRIORITY_MAX, [](const std::deque<outbound_t>& q) {
+				return !q.empty();
+			});
+			DCHECK (queue_ + PUBLISH_PRIORITY_MAX != queue);
+			auto it = pending_.find (queue->front().token);
+			DCHECK (pending_.end() != it);
+			if (&queue->front() == it->second.image)
+				it->second.image = nullptr;
+			if (0 == --it->second.count)
+				pending_.erase (it);
+			queue->pop_front();
+			--depth_;
+		}
+
+		void Clear() {
+			std::for_each (queue_, queue_ + PUBLISH_PRIORITY_MAX, [](std::deque<outbound_t>& q) {
+				q.clear();
+			});
+			pending_.clear();
+			depth_ = 0;
+		}
+
+		size_t GetDepth() const { return depth_; }
+		size_t GetCapacity() const { return capacity_; }
+
+	private:
+		std::deque<outbound_t> queue_[PUBLISH_PRIORITY_MAX];
+/* Per stream token, generation of the newest image with the queued image it
+ * overwrites in place, messages of older generations are conflated.
+ */
+		struct pending_t
+		{
+			uint64_t generation;
+			outbound_t* image;
+			size_t count;
+		};
+		std::unordered_map<Token*, pending_t> pending_;
+		size_t depth_;
+		const size_t capacity_;
+	};
+
+} /* namespace gomi */
+
+#endif /* __OUTBOUND_QUEUE_HH__ */
+
+/* eof */
@@ -0,0 +1,232 @@
+/* Outbound queue unit test of priority order and image conflation.
+ *
+ * Returns zero on success, non-zero with each failure logged to stderr.
+ */
+
+#include "outbound_queue.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "token_bucket.hh"
+#include "unittest.hh"
+
+namespace
+{
+/* message payload is a serial number, streams are distinct addresses */
+	struct token_t {};
+	typedef gomi::outbound_queue_t<int, token_t> queue_t;
+}
+
+static
+gomi::enqueue_result_t
+push (
+	queue_t* queue,
+	gomi::publish_priority_t priority,
+	token_t* token,
+	bool is_image,
+	int msg
+	)
+{
+	queue_t::outbound_t outbound;
+	outbound.msg = std::make_shared<const int> (msg);
+	outbound.token = token;
+	outbound.size = 100;
+	outbound.token_generation = 0;
+	outbound.is_paced = false;
+	return queue->Push (priority, is_image, &outbound);
+}
+
+/* Messages in submit order as the sender thread drains, stale messages are
+ * discarded.
+ */
+static
+std::vector<int>
+drain (
+	queue_t* queue
+	)
+{
+	std::vector<int> msgs;
+	while (0 != queue->GetDepth()) {
+		const auto* front = queue->Front();
+		EXPECT(nullptr != front);
+		if (queue->IsCurrent (*front))
+			msgs.push_back (*front->msg);
+		queue->PopFront();
+	}
+	EXPECT(nullptr == queue->Front());
+	return msgs;
+}
+
+static
+std::vector<int>
+make_list (
+	int a,
+	int b,
+	int c,
+	int d
+	)
+{
+	std::vector<int> list;
+	const int v[] = { a, b, c, d };
+	for (size_t i = 0; i < 4 && 0 != v[i]; ++i)
+		list.push_back (v[i]);
+	return list;
+}
+
+/* Realtime messages are dequeued ahead of archive messages, each priority in
+ * arrival order.
+ */
+static
+void
+test_priority()
+{
+	queue_t queue (100);
+	token_t a, b, c;
+	EXPECT(gomi::ENQUEUE_QUEUED == push (&queue, gomi::PUBLISH_PRIORITY_ARCHIVE, &a, false, 1));
+	EXPECT(gomi::ENQUEUE_QUEUED == push (&queue, gomi::PUBLISH_PRIORITY_REALTIME, &b, false, 2));
+	EXPECT(gomi::ENQUEUE_QUEUED == push (&queue, gomi::PUBLISH_PRIORITY_ARCHIVE, &c, false, 3));
+	EXPECT(gomi::ENQUEUE_QUEUED == push (&queue, gomi::PUBLISH_PRIORITY_REALTIME, &b, false, 4));
+	EXPECT(4 == queue.GetDepth());
+	EXPECT(make_list (2, 4, 1, 3) == drain (&queue));
+
+/* a realtime message arriving mid-drain goes ahead of queued archive messages */
+	push (&queue, gomi::PUBLISH_PRIORITY_ARCHIVE, &a, false, 1);
+	push (&queue, gomi::PUBLISH_PRIORITY_ARCHIVE, &c, false, 2);
+	EXPECT(1 == *queue.Front()->msg);
+	queue.PopFront();
+	push (&queue, gomi::PUBLISH_PRIORITY_REALTIME, &b, false, 3);
+	EXPECT(make_list (3, 2, 0, 0) == drain (&queue));
+}
+
+/* A pending image is overwritten in place, updates queued before the newest
+ * image are discarded, updates after it and other streams are kept.
+ */
+static
+void
+test_conflation()
+{
+	queue_t queue (100);
+	token_t a, b;
+	EXPECT(gomi::ENQUEUE_QUEUED == push (&queue, gomi::PUBLISH_PRIORITY_ARCHIVE, &a, true, 1));
+	EXPECT(gomi::ENQUEUE_QUEUED == push (&queue, gomi::PUBLISH_PRIORITY_ARCHIVE, &a, false, 2));
+	EXPECT(gomi::ENQUEUE_QUEUED == push (&queue, gomi::PUBLISH_PRIORITY_ARCHIVE, &b, false, 3));
+	EXPECT(gomi::ENQUEUE_CONFLATED == push (&queue, gomi::PUBLISH_PRIORITY_ARCHIVE, &a, true, 4));
+	EXPECT(gomi::ENQUEUE_QUEUED == push (&queue, gomi::PUBLISH_PRIORITY_ARCHIVE, &a, false, 5));
+	EXPECT(4 == queue.GetDepth());
+	EXPECT(make_list (4, 3, 5, 0) == drain (&queue));
+
+/* once the image is dequeued the next image is queued behind pending updates */
+	push (&queue, gomi::PUBLISH_PRIORITY_REALTIME, &a, true, 1);
+	push (&queue, gomi::PUBLISH_PRIORITY_REALTIME, &a, false, 2);
+	EXPECT(1 == *queue.Front()->msg);
+	queue.PopFront();
+	EXPECT(gomi::ENQUEUE_QUEUED == push (&queue, gomi::PUBLISH_PRIORITY_REALTIME, &a, true, 3));
+	EXPECT(gomi::ENQUEUE_CONFLATED == push (&queue, gomi::PUBLISH_PRIORITY_REALTIME, &a, true, 4));
+	EXPECT(make_list (4, 0, 0, 0) == drain (&queue));
+}
+
+/* A full queue drops new messages yet still conflates pending images, a
+ * cleared queue starts empty.
+ */
+static
+void
+test_capacity()
+{
+	queue_t queue (2);
+	token_t a, b, c;
+	EXPECT(gomi::ENQUEUE_QUEUED == push (&queue, gomi::PUBLISH_PRIORITY_ARCHIVE, &a, true, 1));
+	EXPECT(gomi::ENQUEUE_QUEUED == push (&queue, gomi::PUBLISH_PRIORITY_ARCHIVE, &b, false, 2));
+	EXPECT(gomi::ENQUEUE_DROPPED == push (&queue, gomi::PUBLISH_PRIORITY_REALTIME, &c, true, 3));
+	EXPECT(gomi::ENQUEUE_DROPPED == push (&queue, gomi::PUBLISH_PRIORITY_ARCHIVE, &a, false, 4));
+	EXPECT(gomi::ENQUEUE_CONFLATED == push (&queue, gomi::PUBLISH_PRIORITY_ARCHIVE, &a, true, 5));
+	EXPECT(2 == queue.GetDepth());
+
+	queue.Clear();
+	EXPECT(0 == queue.GetDepth());
+	EXPECT(nullptr == queue.Front());
+	EXPECT(gomi::ENQUEUE_QUEUED == push (&queue, gomi::PUBLISH_PRIORITY_ARCHIVE, &a, true, 6));
+	EXPECT(make_list (6, 0, 0, 0) == drain (&queue));
+}
+
+/* Sender drain paced by the message and byte buckets on a simulated clock,
+ * as the session sender thread: the byte burst passes at once, the remainder
+ * at the byte rate, and a realtime message queued meanwhile is next out.
+ */
+static
+void
+test_paced_drain()
+{
+	using namespace boost::posix_time;
+	queue_t queue (100);
+	token_t a, b;
+	gomi::token_bucket_t msg_bucket, byte_bucket;
+/* 100 msgs/s burst 10, 1000 byte messages at 50,000 bytes/s burst 5 */
+	msg_bucket.Reset (100.0, 10.0);
+	byte_bucket.Reset (50000.0, 5000.0);
+	const ptime t0 (microsec_clock::universal_time());
+	for (int n = 1; n <= 20; ++n) {
+		queue_t::outbound_t outbound;
+		outbound.msg = std::make_shared<const int> (n);
+		outbound.token = &a;
+		outbound.size = 1000;
+		outbound.token_generation = 0;
+		outbound.is_paced = false;
+		queue.Push (gomi::PUBLISH_PRIORITY_ARCHIVE, false, &outbound);
+	}
+	ptime now (t0);
+	std::vector<int> msgs;
+	std::vector<double> times;
+	unsigned paced = 0;
+	while (0 != queue.GetDepth()) {
+		auto& front = *queue.Front();
+		const double wait = std::max (msg_bucket.GetWait (1.0, now),
+					      byte_bucket.GetWait ((double)front.size, now));
+		if (wait > 0.0) {
+			if (!front.is_paced) {
+				front.is_paced = true;
+				++paced;
+			}
+			now += microseconds ((long)(wait * 1000000.0) + 1);
+			continue;
+		}
+		msgs.push_back (*front.msg);
+		times.push_back ((now - t0).total_microseconds() / 1e6);
+		msg_bucket.Consume (1.0);
+		byte_bucket.Consume ((double)front.size);
+		queue.PopFront();
+		if (10 == msgs.size()) {
+			queue_t::outbound_t outbound;
+			outbound.msg = std::make_shared<const int> (100);
+			outbound.token = &b;
+			outbound.size = 1000;
+			outbound.token_generation = 0;
+			outbound.is_paced = false;
+			queue.Push (gomi::PUBLISH_PRIORITY_REALTIME, false, &outbound);
+		}
+	}
+	EXPECT(21 == msgs.size());
+	EXPECT(16 == paced);
+	EXPECT(100 == msgs[10]);
+	for (size_t i = 0; i < times.size(); ++i) {
+		const double expected = (i < 5) ? 0.0 : (i - 4) * 0.02;
+		EXPECT(std::fabs (times[i] - expected) < 1e-3);
+	}
+}
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	test_priority();
+	test_conflation();
+	test_capacity();
+	test_paced_drain();
+	return unittest::Result();
+}
+
+/* eof */
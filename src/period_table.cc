@@ -0,0 +1,99 @@
+/* Bin time periods in UTC.
+ */
+
+#include "period_table.hh"
+
+/* Boost Date Time */
+#include <boost/date_time/local_time/local_time.hpp>
+
+#include "chromium/logging.hh"
+
+/* http://en.wikipedia.org/wiki/Unix_epoch */
+static const boost::gregorian::date kUnixEpoch (1970, 1, 1);
+
+/* Convert Posix time to Unix Epoch time.
+ */
+static
+__time32_t
+to_unix_epoch (
+	const boost::posix_time::ptime t
+	)
+{
+	return (t - boost::posix_time::ptime (kUnixEpoch)).total_seconds();
+}
+
+/* Calculate the start and end of each time of a bin for a given date.
+ */
+static
+boost::posix_time::time_period
+to_time_period (
+	const gomi::bin_decl_t& bin_decl,
+	const boost::gregorian::date& date
+	)
+{
+	using namespace boost;
+	using namespace local_time;
+	using namespace posix_time;
+
+/* start: apply provided time-of-day */
+	const local_date_time start_ldt (date, bin_decl.bin_start, bin_decl.bin_tz, local_date_time::NOT_DATE_TIME_ON_ERROR);
+	CHECK (!start_ldt.is_not_a_date_time());
+
+/* end */
+	const local_date_time end_ldt (date, bin_decl.bin_end, bin_decl.bin_tz, local_date_time::NOT_DATE_TIME_ON_ERROR);
+	CHECK (!end_ldt.is_not_a_date_time());
+
+	time_period tp (start_ldt.utc_time(), end_ldt.utc_time());
+	return tp;
+}
+
+gomi::time_window_t
+gomi::period_table_t::Get (
+	const bin_decl_t& bin_decl,
+	const boost::gregorian::date& date
+	)
+{
+	key_t key;
+	key.date = date;
+	key.bin_start = bin_decl.bin_start;
+	key.bin_end = bin_decl.bin_end;
+	key.bin_tz = bin_decl.bin_tz;
+
+	boost::lock_guard<boost::mutex> lock (lock_);
+	auto it = windows_.find (key);
+	if (windows_.end() != it)
+		return it->second;
+
+	time_window_t window (0, 0);
+	const auto tp = to_time_period (bin_decl, date);
+	if (!tp.is_null())
+		window = std::make_pair (to_unix_epoch (tp.begin()), to_unix_epoch (tp.end()));
+	windows_.insert (std::make_pair (key, window));
+	DVLOG(4) << "time period: { "
+		  "bin: \"" << bin_decl.bin_name << "\""
+		", date: \"" << to_simple_string (date) << "\""
+		", from: " << window.first <<
+		", till: " << window.second <<
+		" }";
+	return window;
+}
+
+void
+gomi::period_table_t::Expire (
+	const boost::gregorian::date& date
+	)
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	auto it = windows_.begin();
+	while (windows_.end() != it && it->first.date < date)
+		it = windows_.erase (it);
+}
+
+size_t
+gomi::period_table_t::GetSize() const
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	return windows_.size();
+}
+
+/* eof */
@@ -0,0 +1,72 @@
+/* Bin time periods in UTC.
+ *
+ * The time period of a bin on a business day depends only upon the bin decl
+ * and the date, the time zone conversion is performed once and the Unix epoch
+ * result shared by every symbol, scan and refresh.
+ */
+
+#ifndef __PERIOD_TABLE_HH__
+#define __PERIOD_TABLE_HH__
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <utility>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Boost Posix Time */
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+/* Boost Gregorian Calendar */
+#include <boost/date_time/gregorian/gregorian_types.hpp>
+
+/* Boost threading. */
+#include <boost/thread.hpp>
+
+#include "gomi_bin.hh"
+
+namespace gomi
+{
+/* [from, till) in Unix epoch, from == till for an empty time period */
+	typedef std::pair<__time32_t, __time32_t> time_window_t;
+
+	class period_table_t : boost::noncopyable
+	{
+	public:
+/* time period of /bin_decl/ on /date/, calculated on first use */
+		time_window_t Get (const bin_decl_t& bin_decl, const boost::gregorian::date& date);
+/* discard time periods of days before /date/ */
+		void Expire (const boost::gregorian::date& date);
+
+		size_t GetSize() const;
+
+	private:
+		struct key_t
+		{
+			bool operator< (const key_t& rhs) const {
+				if (date != rhs.date)
+					return date < rhs.date;
+				if (bin_start != rhs.bin_start)
+					return bin_start < rhs.bin_start;
+				if (bin_end != rhs.bin_end)
+					return bin_end < rhs.bin_end;
+				return bin_tz.get() < rhs.bin_tz.get();
+			}
+
+			boost::gregorian::date date;
+			boost::posix_time::time_duration bin_start, bin_end;
+			boost::local_time::time_zone_ptr bin_tz;
+		};
+
+/* ordered by date first for expiry */
+		std::map<key_t, time_window_t> windows_;
+		mutable boost::mutex lock_;
+	};
+
+} /* namespace gomi */
+
+#endif /* __PERIOD_TABLE_HH__ */
+
+/* eof */
@@ -99,6 +99,7 @@ gomi::provider_t::CreateItemStream (
 	item_stream->rfa_name.set (name, 0, true);
 	item_stream->token.resize (sessions_.size());
 	item_stream->token.shrink_to_fit();
+	item_stream->has_image.assign (sessions_.size(), 0);
 	unsigned i = 0;
 	std::for_each (sessions_.begin(), sessions_.end(),
 		[&name, &item_stream, &i](std::unique_ptr<session_t>& it)
@@ -123,21 +124,129 @@ gomi::provider_t::CreateItemStream (
 bool
 gomi::provider_t::Send (
 	item_stream_t*const stream,
-	rfa::message::RespMsg*const msg
+	rfa::message::RespMsg*const msg,
+	size_t size
 )
 {
-	unsigned i = 0;
-	std::for_each (sessions_.begin(), sessions_.end(),
-		[stream, msg, &i](std::unique_ptr<session_t>& it)
-	{
-		assert ((bool)it);
-		assert (!stream->token.empty());
-		it->Send (msg, stream->token[i], nullptr);
-		++i;
-	});
-	cumulative_stats_[PROVIDER_PC_MSGS_SENT]++;
-	last_activity_ = boost::posix_time::microsec_clock::universal_time();
-	return true;
+	return Submit (stream, msg, size, FANOUT_ALL);
+}
+
+/* Send a refresh image to sessions that have not received one on their
+ * current token, i.e. new streams and sessions recovering from login loss.
+ */
+bool
+gomi::provider_t::SendImage (
+	item_stream_t*const stream,
+	rfa::message::RespMsg*const msg,
+	size_t size
+)
+{
+	return Submit (stream, msg, size, FANOUT_IMAGE);
+}
+
+/* Send an update to sessions already holding an image of the stream.
+ */
+bool
+gomi::provider_t::SendUpdate (
+	item_stream_t*const stream,
+	rfa::message::RespMsg*const msg,
+	size_t size
+)
+{
+	return Submit (stream, msg, size, FANOUT_UPDATE);
+}
+
+/* Fan-out of one message to the selected sessions.  The message is prepared
+ * and validated once and copied once, as the caller re-uses the message and
+ * its field list for the next stream, every session queues the same copy at
+ * the stream priority for its own paced sender thread.
+ * A stream whose message cannot be queued is re-imaged on next publish.
+ *
+ * The field list is encoded once, but RFA 7.2 OMM submission only takes a
+ * message object and encodes it into each connection's own buffer, so
+ * pre-encoded bytes cannot be shared across sessions.
+ */
+bool
+gomi::provider_t::Submit (
+	item_stream_t*const stream,
+	rfa::message::RespMsg*const msg,
+	size_t size,
+	fanout_t fanout
+	)
+{
+	assert (stream->token.size() == sessions_.size());
+#ifdef DEBUG
+/* 4.2.8 Message Validation.  RFA provides an interface to verify that
+ * constructed messages of these types conform to the Reuters Domain
+ * Models as specified in RFA API 7 RDM Usage Guide.
+ */
+	RFA_String warningText;
+	const uint8_t validation_status = msg->validateMsg (&warningText);
+	if (rfa::message::MsgValidationWarning == validation_status) {
+		LOG(ERROR) << "respMsg::validateMsg: { \"warningText\": \"" << warningText << "\" }";
+	} else {
+		assert (rfa::message::MsgValidationOk == validation_status);
+	}
+#endif
+	std::shared_ptr<const rfa::message::RespMsg> copy (CopyMsg (*msg));
+	std::for_each (sessions_.begin(), sessions_.end(),
+		[&](std::unique_ptr<session_t>& it)
+	{
+		it->Enqueue (copy, stream, size, fanout);
+	});
+	cumulative_stats_[PROVIDER_PC_MSGS_SENT]++;
+	last_activity_ = boost::posix_time::microsec_clock::universal_time();
+	return true;
+}
+
+unsigned
+gomi::provider_t::GetImageCount (
+	const item_stream_t& stream
+	) const
+{
+	return (unsigned)std::count_if (sessions_.begin(), sessions_.end(),
+		[&stream](const std::unique_ptr<session_t>& it)
+	{
+		return it->HasImage (stream);
+	});
+}
+
+void
+gomi::provider_t::ResetImages()
+{
+	LOG(INFO) << "Resetting " << directory_.size() << " stream images.";
+	std::for_each (sessions_.begin(), sessions_.end(),
+		[](std::unique_ptr<session_t>& it)
+	{
+		it->ResetImages();
+	});
+}
+
+/* Copy of a message built from references for the outbound queues.  The copy
+ * is constructed for deep copies so that each value set, including the
+ * attribute info and payload field list, is copied from the caller's objects.
+ */
+rfa::message::RespMsg*
+gomi::provider_t::CopyMsg (
+	const rfa::message::RespMsg& msg
+	)
+{
+	auto copy = new rfa::message::RespMsg (true);	/* deep copy */
+	const uint16_t hint_mask = msg.getHintMask();
+	copy->setMsgModelType (msg.getMsgModelType());
+	copy->setRespType (msg.getRespType());
+	copy->setIndicationMask (msg.getIndicationMask());
+	if (hint_mask & rfa::message::RespMsg::RespTypeNumFlag)
+		copy->setRespTypeNum (msg.getRespTypeNum());
+	if (hint_mask & rfa::message::RespMsg::AttribInfoFlag)
+		copy->setAttribInfo (msg.getAttribInfo());
+	if (hint_mask & rfa::message::RespMsg::RespStatusFlag)
+		copy->setRespStatus (msg.getRespStatus());
+	if (hint_mask & rfa::message::RespMsg::QualityOfServiceFlag)
+		copy->setQualityOfService (msg.getQualityOfService());
+	if (hint_mask & rfa::message::RespMsg::PayloadFlag)
+		copy->setPayload (msg.getPayload());
+	return copy;
 }
 
 void
@@ -7,8 +7,10 @@
 #pragma once
 
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 /* Boost Posix Time */
 #include <boost/date_time/posix_time/posix_time.hpp>
@@ -25,6 +27,7 @@
 #include "rfa.hh"
 #include "config.hh"
 #include "deleter.hh"
+#include "session.hh"
 
 namespace gomi
 {
@@ -38,10 +41,23 @@ namespace gomi
 	class item_stream_t : boost::noncopyable
 	{
 	public:
+		item_stream_t() :
+			priority (PUBLISH_PRIORITY_ARCHIVE)
+		{
+		}
+
 /* Fixed name for this stream. */
 		rfa::common::RFA_String rfa_name;
 /* Session token which is valid from login success to login close. */
 		std::vector<rfa::sessionLayer::ItemToken*> token;
+/* Per session, a refresh image has been sent on the current token, one byte
+ * per session as each is written under its own session lock.
+ */
+		std::vector<uint8_t> has_image;
+/* Last published value per field id, updates carry only fields that differ. */
+		std::map<int, int64_t> last_value;
+/* Order of the stream in session outbound queues. */
+		publish_priority_t priority;
 	};
 
 	class session_t;
@@ -57,7 +73,14 @@ namespace gomi
 		bool Init() throw (rfa::common::InvalidConfigurationException, rfa::common::InvalidUsageException);
 
 		bool CreateItemStream (const char* name, std::shared_ptr<item_stream_t> item_stream) throw (rfa::common::InvalidUsageException);
-		bool Send (item_stream_t*const item_stream, rfa::message::RespMsg*const msg) throw (rfa::common::InvalidUsageException);
+/* /size/ is the estimated encoded size of /msg/ for pacing. */
+		bool Send (item_stream_t*const item_stream, rfa::message::RespMsg*const msg, size_t size) throw (rfa::common::InvalidUsageException);
+/* Refresh only to sessions without an image, update only to sessions with one. */
+		bool SendImage (item_stream_t*const item_stream, rfa::message::RespMsg*const msg, size_t size) throw (rfa::common::InvalidUsageException);
+		bool SendUpdate (item_stream_t*const item_stream, rfa::message::RespMsg*const msg, size_t size) throw (rfa::common::InvalidUsageException);
+		unsigned GetImageCount (const item_stream_t& item_stream) const;
+/* Next publish of every stream is a full refresh image. */
+		void ResetImages();
 
 		uint8_t GetRwfMajorVersion() const {
 			return min_rwf_major_version_;
@@ -77,6 +100,9 @@ namespace gomi
 #endif
 		void GetServiceState (rfa::data::ElementList*const elementList);
 
+		bool Submit (item_stream_t*const item_stream, rfa::message::RespMsg*const msg, size_t size, fanout_t fanout) throw (rfa::common::InvalidUsageException);
+		static rfa::message::RespMsg* CopyMsg (const rfa::message::RespMsg& msg);
+
 		void SetRwfMajorVersion (uint8_t rwf_major_version) { min_rwf_major_version_ = rwf_major_version; }
 		void SetRwfMinorVersion (uint8_t rwf_minor_version) { min_rwf_minor_version_ = rwf_minor_version; }
 
@@ -0,0 +1,188 @@
+/* Run-time selection of trade scan strategy.
+ */
+
+#include "scan_planner.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#include "chromium/logging.hh"
+
+/* Weight of history per observation, older scans fade as day activity changes. */
+static const double kDecay = 0.95;
+
+/* Prior costs until observed: Primitives calls are cheap, FlexRecReader::Open
+ * is ~250ms and Close ~150ms, contiguous reads also carry overnight trades.
+ */
+static const double kPriorCallCost[] = { 100e-6, 400e-3, 100e-6 };
+static const double kPriorRowCost[]  = { 0.5e-6, 1.0e-6, 0.5e-6 };
+static const double kPriorReadRatio[] = { 1.0, 1.0, 2.0 };
+static const double kPriorWeight = 0.1;
+
+/* Every n-th decision favours a strategy with few observations so that both
+ * models keep learning.
+ */
+static const uint32_t kExploreInterval = 32;
+static const uint32_t kMinObservations = 8;
+
+gomi::scan_planner_t::scan_planner_t() :
+	choice_count_ (0)
+{
+	static_assert (_countof (kPriorCallCost) == SCAN_STRATEGY_MAX, "prior per strategy");
+	static_assert (_countof (kPriorReadRatio) == SCAN_STRATEGY_MAX, "prior per strategy");
+	for (int i = 0; i < SCAN_STRATEGY_MAX; ++i) {
+		auto& model = models_[i];
+		model.s_cc = model.s_cr = model.s_rr = model.s_ct = model.s_rt = 0.0;
+		model.call_cost = kPriorCallCost[i];
+		model.row_cost = kPriorRowCost[i];
+		model.s_rows = kPriorWeight * 1e6 * kPriorReadRatio[i];
+		model.s_ticks = kPriorWeight * 1e6;
+		model.observation_count = model.decision_count = 0;
+/* pseudo-observations of a single call and of a million rows */
+		Observe (&model, 1.0, 0.0, kPriorCallCost[i], kPriorWeight);
+		Observe (&model, 0.0, 1e6, 1e6 * kPriorRowCost[i], kPriorWeight);
+	}
+}
+
+gomi::scan_strategy_t
+gomi::scan_planner_t::Choose (
+	uint64_t symbols,
+	uint64_t days,
+	uint64_t calls,
+	uint64_t ticks
+	)
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	double cost[SCAN_STRATEGY_MAX];
+	cost[SCAN_PER_SYMBOL] = Estimate (models_[SCAN_PER_SYMBOL], (double)calls, (double)ticks);
+	cost[SCAN_BATCH] = Estimate (models_[SCAN_BATCH], (double)days, (double)ticks);
+	cost[SCAN_RANGE] = Estimate (models_[SCAN_RANGE], (double)symbols, (double)ticks);
+	scan_strategy_t strategy = SCAN_PER_SYMBOL;
+	for (int i = 0; i < SCAN_STRATEGY_MAX; ++i) {
+		if (cost[i] < cost[strategy])
+			strategy = (scan_strategy_t)i;
+	}
+/* least observed strategy */
+	if (0 == (++choice_count_ % kExploreInterval)) {
+		scan_strategy_t other = strategy;
+		for (int i = 0; i < SCAN_STRATEGY_MAX; ++i) {
+			if (models_[i].observation_count < models_[other].observation_count)
+				other = (scan_strategy_t)i;
+		}
+		if (models_[other].observation_count < kMinObservations)
+			strategy = other;
+	}
+	models_[strategy].decision_count++;
+	DVLOG(3) << "scan plan: { "
+		  "\"symbols\": " << symbols <<
+		", \"days\": " << days <<
+		", \"calls\": " << calls <<
+		", \"ticks\": " << ticks <<
+		", \"per_symbol\": " << cost[SCAN_PER_SYMBOL] <<
+		", \"batch\": " << cost[SCAN_BATCH] <<
+		", \"range\": " << cost[SCAN_RANGE] <<
+		", \"strategy\": " << strategy <<
+		" }";
+	return strategy;
+}
+
+void
+gomi::scan_planner_t::Record (
+	scan_strategy_t strategy,
+	uint64_t calls,
+	uint64_t rows,
+	uint64_t ticks,
+	double seconds
+	)
+{
+	DCHECK_LT (strategy, SCAN_STRATEGY_MAX);
+	boost::lock_guard<boost::mutex> lock (lock_);
+	auto& model = models_[strategy];
+	Observe (&model, (double)calls, (double)rows, seconds, 1.0);
+	model.s_rows = kDecay * model.s_rows + (double)rows;
+	model.s_ticks = kDecay * model.s_ticks + (double)ticks;
+	model.observation_count++;
+}
+
+void
+gomi::scan_planner_t::Observe (
+	model_t* model,
+	double calls,
+	double rows,
+	double seconds,
+	double weight
+	)
+{
+	model->s_cc = kDecay * model->s_cc + weight * calls * calls;
+	model->s_cr = kDecay * model->s_cr + weight * calls * rows;
+	model->s_rr = kDecay * model->s_rr + weight * rows * rows;
+	model->s_ct = kDecay * model->s_ct + weight * calls * seconds;
+	model->s_rt = kDecay * model->s_rt + weight * rows * seconds;
+
+/* solve 2x2 normal equations, keep previous fit when degenerate */
+	const double det = model->s_cc * model->s_rr - model->s_cr * model->s_cr;
+	if (std::fabs (det) <= 1e-12 * model->s_cc * model->s_rr)
+		return;
+	const double a = (model->s_ct * model->s_rr - model->s_rt * model->s_cr) / det;
+	const double b = (model->s_cc * model->s_rt - model->s_cr * model->s_ct) / det;
+	model->call_cost = std::max (0.0, a);
+	model->row_cost = std::max (0.0, b);
+}
+
+double
+gomi::scan_planner_t::Estimate (
+	const model_t& model,
+	double calls,
+	double ticks
+	)
+{
+/* rows read per trade within bin time periods */
+	const double ratio = (model.s_ticks > 0.0) ? model.s_rows / model.s_ticks : 1.0;
+	return calls * model.call_cost + ticks * ratio * model.row_cost;
+}
+
+/* Returns per-call overhead in seconds.
+ */
+double
+gomi::scan_planner_t::GetCallOverhead (
+	scan_strategy_t strategy
+	) const
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	return models_[strategy].call_cost;
+}
+
+/* Returns rows per second excluding call overhead.
+ */
+double
+gomi::scan_planner_t::GetRowRate (
+	scan_strategy_t strategy
+	) const
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	const double row_cost = models_[strategy].row_cost;
+	return (row_cost > 0.0) ? 1.0 / row_cost : 0.0;
+}
+
+/* Returns rows read per trade within bin time periods.
+ */
+double
+gomi::scan_planner_t::GetReadRatio (
+	scan_strategy_t strategy
+	) const
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	const auto& model = models_[strategy];
+	return (model.s_ticks > 0.0) ? model.s_rows / model.s_ticks : 1.0;
+}
+
+uint32_t
+gomi::scan_planner_t::GetDecisionCount (
+	scan_strategy_t strategy
+	) const
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	return models_[strategy].decision_count;
+}
+
+/* eof */
@@ -0,0 +1,80 @@
+/* Run-time selection of trade scan strategy.
+ *
+ * The cost of each strategy is modelled as a per-call overhead plus a per-row
+ * cost, fitted by decaying least squares to observed scans.  Rows read exceed
+ * the trades within bin time periods by a per strategy ratio, also observed.
+ * Each batch of symbols is assigned the strategy with the lowest estimated
+ * cost.
+ */
+
+#ifndef __SCAN_PLANNER_HH__
+#define __SCAN_PLANNER_HH__
+#pragma once
+
+#include <cstdint>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Boost threading. */
+#include <boost/thread.hpp>
+
+namespace gomi
+{
+	enum scan_strategy_t {
+/* one Primitives read per symbol and time period */
+		SCAN_PER_SYMBOL,
+/* one cursor per batch of symbols and business day */
+		SCAN_BATCH,
+/* one Primitives read per symbol over the analytic period */
+		SCAN_RANGE,
+		SCAN_STRATEGY_MAX
+	};
+
+	class scan_planner_t : boost::noncopyable
+	{
+	public:
+		scan_planner_t();
+
+/* cheapest strategy for /symbols/ needing /calls/ per-symbol reads, one
+ * batch read per each of /days/ business days, or one read per symbol, each
+ * yielding /ticks/ trades within bin time periods.
+ */
+		scan_strategy_t Choose (uint64_t symbols, uint64_t days, uint64_t calls, uint64_t ticks);
+/* observed scan of /calls/ reads delivering /rows/ trades of which /ticks/
+ * within bin time periods in /seconds/.
+ */
+		void Record (scan_strategy_t strategy, uint64_t calls, uint64_t rows, uint64_t ticks, double seconds);
+
+/* model parameters and decisions for monitoring */
+		double GetCallOverhead (scan_strategy_t strategy) const;
+		double GetRowRate (scan_strategy_t strategy) const;
+		double GetReadRatio (scan_strategy_t strategy) const;
+		uint32_t GetDecisionCount (scan_strategy_t strategy) const;
+
+	private:
+		struct model_t
+		{
+/* decayed sums of the normal equations of time = calls * a + rows * b */
+			double s_cc, s_cr, s_rr, s_ct, s_rt;
+/* fitted per-call and per-row seconds */
+			double call_cost, row_cost;
+/* decayed rows read and trades within bin time periods */
+			double s_rows, s_ticks;
+			uint32_t observation_count;
+			uint32_t decision_count;
+		};
+
+		void Observe (model_t* model, double calls, double rows, double seconds, double weight);
+		static double Estimate (const model_t& model, double calls, double ticks);
+
+		model_t models_[SCAN_STRATEGY_MAX];
+		uint32_t choice_count_;
+		mutable boost::mutex lock_;
+	};
+
+} /* namespace gomi */
+
+#endif /* __SCAN_PLANNER_HH__ */
+
+/* eof */
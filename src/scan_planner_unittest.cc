@@ -0,0 +1,132 @@
+/* Scan planner unit test of the cost model fit and strategy selection.
+ *
+ * Returns zero on success, non-zero with each failure logged to stderr.
+ */
+
+#include "scan_planner.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "unittest.hh"
+
+/* Known costs of the observed scans. */
+static const double kCallCost[] = { 50e-6, 300e-3, 80e-6 };
+static const double kRowCost[]  = { 2e-6, 0.5e-6, 1e-6 };
+/* rows read per trade within bin time periods */
+static const double kReadRatio[] = { 1.0, 1.25, 4.0 };
+
+/* within 5%, the decayed priors linger in the fit */
+static
+bool
+is_near (
+	double expected,
+	double actual
+	)
+{
+	return std::fabs (actual - expected) <= 5e-2 * std::fabs (expected);
+}
+
+/* Record scans of varied calls and rows at the known costs of every strategy. */
+static
+void
+observe (
+	gomi::scan_planner_t* planner,
+	unsigned count
+	)
+{
+	for (unsigned n = 0; n < count; ++n) {
+		for (int i = 0; i < gomi::SCAN_STRATEGY_MAX; ++i) {
+			const uint64_t calls = 1 + (n * 7) % 40;
+			const uint64_t ticks = 1000 + (n * 7919) % 50000;
+			const uint64_t rows = (uint64_t)(ticks * kReadRatio[i]);
+			const double seconds = calls * kCallCost[i] + rows * kRowCost[i];
+			planner->Record ((gomi::scan_strategy_t)i, calls, rows, ticks, seconds);
+		}
+	}
+}
+
+/* Observed scans override the priors, the fit recovers the per-call and
+ * per-row costs and the ratio of rows read.
+ */
+static
+void
+test_fit()
+{
+	gomi::scan_planner_t planner;
+	observe (&planner, 200);
+	for (int i = 0; i < gomi::SCAN_STRATEGY_MAX; ++i) {
+		const auto strategy = (gomi::scan_strategy_t)i;
+		EXPECT(is_near (kCallCost[i], planner.GetCallOverhead (strategy)));
+		EXPECT(is_near (1.0 / kRowCost[i], planner.GetRowRate (strategy)));
+		EXPECT(is_near (kReadRatio[i], planner.GetReadRatio (strategy)));
+	}
+}
+
+/* Few liquid days favour a batch cursor, many reads of thin names favour one
+ * contiguous read per symbol, otherwise per-symbol reads.
+ */
+static
+void
+test_choose()
+{
+	gomi::scan_planner_t planner;
+	observe (&planner, 200);
+/* 10 symbols, 5 days, 10 x 5 x 2 periods, 2 million trades:
+ *   per-symbol 100 x 50us + 2M x 2us        = 4.005s
+ *   batch        5 x 300ms + 2M x 1.25 x 0.5us = 2.75s
+ *   range       10 x 80us + 2M x 4 x 1us     = 8.0008s
+ */
+	EXPECT(gomi::SCAN_BATCH == planner.Choose (10, 5, 100, 2000000));
+/* 10 symbols, 20 days, 10 x 20 x 10 periods, 1,000 trades:
+ *   per-symbol 2000 x 50us + 1000 x 2us     = 0.102s
+ *   batch        20 x 300ms                  = 6s
+ *   range        10 x 80us + 1000 x 4 x 1us  = 0.0048s
+ */
+	EXPECT(gomi::SCAN_RANGE == planner.Choose (10, 20, 2000, 1000));
+/* 10 symbols, 5 days, one period each, 100,000 trades:
+ *   per-symbol  50 x 50us + 100000 x 2us     = 0.2025s
+ *   batch        5 x 300ms + ...             > 1.5s
+ *   range       10 x 80us + 100000 x 4 x 1us = 0.4008s
+ */
+	EXPECT(gomi::SCAN_PER_SYMBOL == planner.Choose (10, 5, 50, 100000));
+	EXPECT(1 == planner.GetDecisionCount (gomi::SCAN_BATCH));
+	EXPECT(1 == planner.GetDecisionCount (gomi::SCAN_RANGE));
+	EXPECT(1 == planner.GetDecisionCount (gomi::SCAN_PER_SYMBOL));
+}
+
+/* A strategy without observations is tried at the exploration interval even
+ * when costlier.
+ */
+static
+void
+test_explore()
+{
+	gomi::scan_planner_t planner;
+	for (unsigned n = 0; n < 8; ++n) {
+		planner.Record (gomi::SCAN_PER_SYMBOL, 100, 1000, 1000, 100 * 50e-6 + 1000 * 2e-6);
+		planner.Record (gomi::SCAN_BATCH, 5, 1000, 1000, 5 * 300e-3 + 1000 * 0.5e-6);
+	}
+/* a thousand symbols price a read per symbol above 100 per-symbol reads */
+	for (unsigned n = 1; n <= 64; ++n) {
+		const auto strategy = planner.Choose (1000, 5, 100, 1000);
+		EXPECT((0 == n % 32) ? gomi::SCAN_RANGE == strategy : gomi::SCAN_PER_SYMBOL == strategy);
+	}
+	EXPECT(2 == planner.GetDecisionCount (gomi::SCAN_RANGE));
+	EXPECT(62 == planner.GetDecisionCount (gomi::SCAN_PER_SYMBOL));
+}
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	test_fit();
+	test_choose();
+	test_explore();
+	return unittest::Result();
+}
+
+/* eof */
@@ -4,6 +4,7 @@
 #include "session.hh"
 
 #include <algorithm>
+#include <cstdlib>
 #include <utility>
 
 #include "chromium/logging.hh"
@@ -13,6 +14,9 @@
 
 using rfa::common::RFA_String;
 
+/* Outbound messages pending per session without configured capacity. */
+static const size_t kDefaultQueueCapacity = 65536;
+
 gomi::session_t::session_t (
 	std::shared_ptr<gomi::provider_t> provider,
 	const unsigned instance_id,
@@ -32,7 +36,12 @@ gomi::session_t::session_t (
 	rwf_minor_version_ (0),
 	is_muted_ (true),
 	stream_state_ (0),
-	data_state_ (0)
+	data_state_ (0),
+	queue_ (config.queue_capacity.empty() ? kDefaultQueueCapacity : std::atol (config.queue_capacity.c_str())),
+	last_queue_latency_ (0),
+	max_queue_latency_ (0),
+	token_generation_ (0),
+	paced_time_ (0)
 {
 	ZeroMemory (cumulative_stats_, sizeof (cumulative_stats_));
 	ZeroMemory (snap_stats_, sizeof (snap_stats_));
@@ -44,6 +53,12 @@ gomi::session_t::session_t (
 
 gomi::session_t::~session_t()
 {
+	if ((bool)sender_thread_) {
+		VLOG(3) << prefix_<< "Stopping sender thread.";
+		sender_thread_->interrupt();
+		sender_thread_->join();
+		sender_thread_.reset();
+	}
 	VLOG(3) << prefix_<< "Unregistering RFA session clients.";
 	if (nullptr != item_handle_)
 		omm_provider_->unregisterClient (item_handle_), item_handle_ = nullptr;
@@ -79,6 +94,25 @@ gomi::session_t::Init()
 	rfa::sessionLayer::OMMErrorIntSpec ommErrorIntSpec;
 	error_item_handle_ = omm_provider_->registerClient (event_queue_.get(), &ommErrorIntSpec, *this, nullptr /* closure */);
 	if (nullptr == error_item_handle_)
+		return false;
+
+/* outbound queue of published messages */
+	VLOG(3) << prefix_<< "Starting sender thread, queue capacity " << queue_.GetCapacity() << " messages.";
+	const long publish_rate = std::atol (config_.publish_rate.c_str());
+	const long publish_byte_rate = std::atol (config_.publish_byte_rate.c_str());
+	const long publish_burst = config_.publish_burst.empty() ? publish_rate : std::atol (config_.publish_burst.c_str());
+	const long publish_byte_burst = config_.publish_byte_burst.empty() ? publish_byte_rate : std::atol (config_.publish_byte_burst.c_str());
+	msg_bucket_.Reset (publish_rate, publish_burst);
+	byte_bucket_.Reset (publish_byte_rate, publish_byte_burst);
+	if (publish_rate > 0 || publish_byte_rate > 0)
+		LOG(INFO) << prefix_ << "Publish pacing: { "
+			  "\"rate\": " << publish_rate <<
+			", \"burst\": " << publish_burst <<
+			", \"byteRate\": " << publish_byte_rate <<
+			", \"byteBurst\": " << publish_byte_burst <<
+			" }";
+	sender_thread_.reset (new boost::thread ([this](){ SenderRun(); }));
+	if (!(bool)sender_thread_)
 		return false;
 
 	return SendLoginRequest();
@@ -225,7 +259,7 @@ gomi::session_t::CreateItemStream (
  */
 uint32_t
 gomi::session_t::Send (
-	rfa::message::RespMsg*const msg,
+	const rfa::message::RespMsg*const msg,
 	rfa::sessionLayer::ItemToken*const token,
 	void* closure
 	)
@@ -236,15 +270,181 @@ gomi::session_t::Send (
 	return Submit (msg, token, closure);
 }
 
+/* Queue /msg/ on the outbound queue of the stream priority, the message is
+ * shared with the queues of other sessions and never modified.  The token and
+ * image state of the stream are read and written under the queue lock so that
+ * they are consistent with a concurrent token reset on login recovery.
+ *
+ * A refresh is queued only to a session without an image for FANOUT_IMAGE, an
+ * update only to a session with one.  When the session is muted or the queue
+ * is full the message is not delivered and the stream is re-imaged on next
+ * publish.  A pending image of the stream is overwritten in place.
+ */
+void
+gomi::session_t::Enqueue (
+	std::shared_ptr<const rfa::message::RespMsg> msg,
+	item_stream_t*const stream,
+	size_t size,
+	fanout_t fanout
+	)
+{
+	const publish_priority_t priority = stream->priority;
+	const bool is_image = (FANOUT_UPDATE != fanout);
+
+	queue_t::outbound_t outbound;
+	outbound.msg = std::move (msg);
+	outbound.size = size;
+	outbound.enqueue_time = boost::posix_time::microsec_clock::universal_time();
+	outbound.is_paced = false;
+	{
+		boost::lock_guard<boost::mutex> lock (queue_lock_);
+		auto& has_image = stream->has_image[instance_id_];
+		if ((FANOUT_IMAGE == fanout && has_image) ||
+		    (FANOUT_UPDATE == fanout && !has_image))
+			return;
+		if (is_muted_) {
+			has_image = false;
+			return;
+		}
+		outbound.token = stream->token[instance_id_];
+		outbound.token_generation = token_generation_;
+		switch (queue_.Push (priority, is_image, &outbound)) {
+		case ENQUEUE_CONFLATED:
+			has_image = true;
+			cumulative_stats_[SESSION_PC_MSGS_CONFLATED]++;
+			return;
+		case ENQUEUE_DROPPED:
+			has_image = false;
+			cumulative_stats_[SESSION_PC_MSGS_DROPPED]++;
+			return;
+		default:
+			if (is_image)
+				has_image = true;
+			cumulative_stats_[SESSION_PC_MSGS_ENQUEUED]++;
+			break;
+		}
+	}
+	queue_cond_.notify_one();
+}
+
+bool
+gomi::session_t::HasImage (
+	const item_stream_t& stream
+	) const
+{
+	boost::lock_guard<boost::mutex> lock (queue_lock_);
+	return 0 != stream.has_image[instance_id_];
+}
+
+void
+gomi::session_t::ResetImages()
+{
+	boost::lock_guard<boost::mutex> lock (queue_lock_);
+	std::for_each (provider_->directory_.begin(), provider_->directory_.end(),
+		[&](std::pair<std::string, std::weak_ptr<item_stream_t>> it)
+	{
+		if (auto sp = it.second.lock())
+			sp->has_image[instance_id_] = false;
+	});
+}
+
+size_t
+gomi::session_t::GetQueueDepth() const
+{
+	boost::lock_guard<boost::mutex> lock (queue_lock_);
+	return queue_.GetDepth();
+}
+
+uint32_t
+gomi::session_t::GetLastQueueLatency() const
+{
+	boost::lock_guard<boost::mutex> lock (queue_lock_);
+	return last_queue_latency_;
+}
+
+uint32_t
+gomi::session_t::GetMaxQueueLatency() const
+{
+	boost::lock_guard<boost::mutex> lock (queue_lock_);
+	return max_queue_latency_;
+}
+
+uint64_t
+gomi::session_t::GetPacedTime() const
+{
+	boost::lock_guard<boost::mutex> lock (queue_lock_);
+	return paced_time_;
+}
+
+/* Sender thread, submits queued messages highest priority first and paced by
+ * the message and byte token buckets.
+ */
+void
+gomi::session_t::SenderRun()
+{
+	using namespace boost::posix_time;
+	LOG(INFO) << prefix_ << "Sender started.";
+	try {
+		while (true) {
+			queue_t::outbound_t outbound;
+			{
+				boost::unique_lock<boost::mutex> lock (queue_lock_);
+				while (0 == queue_.GetDepth())
+					queue_cond_.wait (lock);
+				auto& front = *queue_.Front();
+				if (!queue_.IsCurrent (front)) {
+					queue_.PopFront();
+					cumulative_stats_[SESSION_PC_MSGS_CONFLATED]++;
+					continue;
+				}
+/* wait for tokens outside the lock, a higher priority message may arrive meanwhile */
+				const ptime now (microsec_clock::universal_time());
+				const double wait = std::max (msg_bucket_.GetWait (1.0, now),
+							      byte_bucket_.GetWait ((double)front.size, now));
+				if (wait > 0.0) {
+/* a message is counted once however many waits precede its submit */
+					if (!front.is_paced) {
+						front.is_paced = true;
+						cumulative_stats_[SESSION_PC_MSGS_PACED]++;
+					}
+					const long wait_us = (long)(wait * 1000000.0) + 1;
+					paced_time_ += wait_us;
+					lock.unlock();
+					boost::this_thread::sleep (microseconds (wait_us));
+					continue;
+				}
+				outbound = front;
+				queue_.PopFront();
+				const auto latency = now - outbound.enqueue_time;
+				last_queue_latency_ = (uint32_t)latency.total_microseconds();
+				if (last_queue_latency_ > max_queue_latency_)
+					max_queue_latency_ = last_queue_latency_;
+			}
+			msg_bucket_.Consume (1.0);
+			byte_bucket_.Consume ((double)outbound.size);
+			try {
+				boost::lock_guard<boost::mutex> lock (token_lock_);
+/* token regenerated since dequeue, the stream is re-imaged on the new token */
+				if (outbound.token_generation == token_generation_)
+					Send (outbound.msg.get(), outbound.token, nullptr);
+			} catch (rfa::common::InvalidUsageException& e) {
+				LOG(ERROR) << prefix_ << "InvalidUsageException: { StatusText: \"" << e.getStatus().getStatusText() << "\" }";
+			}
+		}
+	} catch (boost::thread_interrupted&) {
+		LOG(INFO) << prefix_ << "Sender stopped.";
+	}
+}
+
 uint32_t
 gomi::session_t::Submit (
-	rfa::message::RespMsg*const msg,
+	const rfa::message::RespMsg*const msg,
 	rfa::sessionLayer::ItemToken*const token,
 	void* closure
 	)
 {
 	rfa::sessionLayer::OMMItemCmd itemCmd;
-	itemCmd.setMsg (*static_cast<rfa::common::Msg*> (msg));
+	itemCmd.setMsg (*static_cast<const rfa::common::Msg*> (msg));
 /* 7.5.9.7 Set the unique item identifier. */
 	itemCmd.setItemToken (token);
 /* 7.5.9.8 Write the response message directly out to the network through the
@@ -475,6 +675,13 @@ gomi::session_t::ResetTokens()
 	}
 
 	LOG(INFO) << prefix_ << "Resetting " << provider_->directory_.size() << " provider tokens";
+/* no submit in flight and no enqueue until every token is replaced, queued
+ * messages reference the previous tokens.
+ */
+	boost::lock_guard<boost::mutex> token_lock (token_lock_);
+	boost::lock_guard<boost::mutex> queue_lock (queue_lock_);
+	queue_.Clear();
+	++token_generation_;
 /* Cannot use std::for_each (auto λ) due to language limitations. */
 	std::for_each (provider_->directory_.begin(), provider_->directory_.end(),
 		[&](std::pair<std::string, std::weak_ptr<item_stream_t>> it)
@@ -482,6 +689,8 @@ gomi::session_t::ResetTokens()
 		if (auto sp = it.second.lock()) {
 			sp->token[instance_id_] = &(omm_provider_->generateItemToken());
 			assert (nullptr != sp->token[instance_id_]);
+/* new token requires a refresh image before any update */
+			sp->has_image[instance_id_] = false;
 			cumulative_stats_[SESSION_PC_TOKENS_GENERATED]++;
 		}
 	});
@@ -8,7 +8,6 @@
 
 #include <cstdint>
 #include <memory>
-#include <unordered_map>
 
 /* Boost Posix Time */
 #include "boost/date_time/posix_time/posix_time.hpp"
@@ -16,12 +15,17 @@
 /* Boost noncopyable base class */
 #include <boost/utility.hpp>
 
+/* Boost threading. */
+#include <boost/thread.hpp>
+
 /* RFA 7.2 */
 #include <rfa/rfa.hh>
 
 #include "rfa.hh"
 #include "config.hh"
 #include "deleter.hh"
+#include "outbound_queue.hh"
+#include "token_bucket.hh"
 
 namespace gomi
 {
@@ -47,11 +51,23 @@ namespace gomi
 		SESSION_PC_MMT_DIRECTORY_MALFORMED,
 		SESSION_PC_MMT_DIRECTORY_SENT,
 		SESSION_PC_TOKENS_GENERATED,
+		SESSION_PC_MSGS_ENQUEUED,
+		SESSION_PC_MSGS_DROPPED,
+		SESSION_PC_MSGS_PACED,
+		SESSION_PC_MSGS_CONFLATED,
 /* marker */
 		SESSION_PC_MAX
 	};
 
+/* Sessions receiving a message of an item stream. */
+	enum fanout_t {
+		FANOUT_ALL,
+		FANOUT_IMAGE,
+		FANOUT_UPDATE
+	};
+
 	class provider_t;
+	class item_stream_t;
 
 	class session_t :
 		public rfa::common::Client,
@@ -64,7 +80,21 @@ namespace gomi
 		bool Init() throw (rfa::common::InvalidConfigurationException, rfa::common::InvalidUsageException);
 
 		bool CreateItemStream (const char* name, rfa::sessionLayer::ItemToken** token) throw (rfa::common::InvalidUsageException);
-		uint32_t Send (rfa::message::RespMsg*const msg, rfa::sessionLayer::ItemToken*const token, void* closure) throw (rfa::common::InvalidUsageException);
+		uint32_t Send (const rfa::message::RespMsg*const msg, rfa::sessionLayer::ItemToken*const token, void* closure) throw (rfa::common::InvalidUsageException);
+/* Queue shared /msg/ of about /size/ bytes on this session's token of /stream/
+ * for the sender thread, the stream image state of the session is updated
+ * with the outcome.  A refresh supersedes pending messages of the stream.
+ */
+		void Enqueue (std::shared_ptr<const rfa::message::RespMsg> msg, item_stream_t*const stream, size_t size, fanout_t fanout);
+/* A refresh image of /stream/ has been queued on the current token. */
+		bool HasImage (const item_stream_t& stream) const;
+/* Next publish of every stream is a full refresh image. */
+		void ResetImages();
+		size_t GetQueueDepth() const;
+/* sender statistics, read under the queue lock */
+		uint32_t GetLastQueueLatency() const;
+		uint32_t GetMaxQueueLatency() const;
+		uint64_t GetPacedTime() const;
 
 /* RFA event callback. */
 		void processEvent (const rfa::common::Event& event) override;
@@ -77,7 +107,7 @@ namespace gomi
 		}
 
 	private:
-		uint32_t Submit (rfa::message::RespMsg*const msg, rfa::sessionLayer::ItemToken*const token, void* closure) throw (rfa::common::InvalidUsageException);
+		uint32_t Submit (const rfa::message::RespMsg*const msg, rfa::sessionLayer::ItemToken*const token, void* closure) throw (rfa::common::InvalidUsageException);
 
 		void OnOMMItemEvent (const rfa::sessionLayer::OMMItemEvent& event);
                 void OnRespMsg (const rfa::message::RespMsg& msg);
@@ -90,6 +120,7 @@ namespace gomi
 		bool SendLoginRequest() throw (rfa::common::InvalidUsageException);
 		bool SendDirectoryResponse();
 		bool ResetTokens();
+		void SenderRun();
 
 		std::shared_ptr<provider_t> provider_;
 		const session_config_t& config_;
@@ -129,6 +160,32 @@ namespace gomi
 		int stream_state_;
 		int data_state_;
 
+/* Outbound messages drained by the sender thread so that a slow connection
+ * does not stall publishing or other sessions.
+ */
+		typedef outbound_queue_t<rfa::message::RespMsg, rfa::sessionLayer::ItemToken> queue_t;
+		queue_t queue_;
+		mutable boost::mutex queue_lock_;
+		boost::condition_variable queue_cond_;
+		std::unique_ptr<boost::thread> sender_thread_;
+/* Held across token regeneration and each submit, a message dequeued before
+ * regeneration references a previous token and is discarded.
+ */
+		boost::mutex token_lock_;
+		uint64_t token_generation_;
+
+/* Enqueue to dequeue latency in microseconds, guarded by queue_lock_. */
+		uint32_t last_queue_latency_;
+		uint32_t max_queue_latency_;
+
+/* Publish pacing by message count and estimated bytes. */
+		token_bucket_t msg_bucket_;
+		token_bucket_t byte_bucket_;
+/* Cumulative microseconds the sender waited on pacing, pacing waits are
+ * typically well under a millisecond.  Guarded by queue_lock_.
+ */
+		uint64_t paced_time_;
+
 /** Performance Counters **/
 		boost::posix_time::ptime last_activity_;
 		uint32_t cumulative_stats_[SESSION_PC_MAX];
@@ -16,14 +16,19 @@
 #include "error.hh"
 #include "rfaostream.hh"
 #include "gomi_bin.hh"
+#include "gomi_scan.hh"
+#include "intraday_index.hh"
+#include "worker_pool.hh"
 #include "portware.hh"
 
 /* Feed log file FlexRecord name */
 static const char* kGomiFlexRecordName = "Gomi";
 
-/* Default FlexRecord fields. */
-static const char* kDefaultLastPriceField = "LastPrice";
-static const char* kDefaultTickVolumeField = "TickVolume";
+/* Percentage change windows of query results, truncated to dayCount. */
+static const unsigned kQueryWindows[] = { 10, 15, 20 };
+
+/* Largest query dayCount, about eight years of business days. */
+static const long kMaximumQueryDayCount = 2000;
 
 /* Tcl exported API. */
 static const char* kBasicFunctionName = "gomi_query";
@@ -31,13 +36,15 @@ static const char* kFeedLogFunctionName = "gomi_feedlog";
 static const char* kRepublishFunctionName = "gomi_republish";
 static const char* kRepublishLastBinFunctionName = "gomi_republish_last_bin";
 static const char* kRecalculateFunctionName = "gomi_recalculate";
+static const char* kInvalidateFunctionName = "gomi_invalidate";
 
 static const char* kTclApi[] = {
 	kBasicFunctionName,
 	kFeedLogFunctionName,
 	kRepublishFunctionName,
 	kRepublishLastBinFunctionName,
-	kRecalculateFunctionName
+	kRecalculateFunctionName,
+	kInvalidateFunctionName
 };
 
 /* Register Tcl API.
@@ -118,6 +125,8 @@ gomi::gomi_t::execute (
 			retval = TclRepublishLastBinQuery (cmdInfo, cmdData);
 		else if (0 == strcmp (command, kRecalculateFunctionName))
 			retval = TclRecalculateQuery (cmdInfo, cmdData);
+		else if (0 == strcmp (command, kInvalidateFunctionName))
+			retval = TclInvalidateQuery (cmdInfo, cmdData);
 		else
 			Tcl_SetResult (interp, "unknown function", TCL_STATIC);
 	}
@@ -186,13 +195,19 @@ gomi::gomi_t::TclGomiQuery (
 
 /* count of days for bin analytic */
 	long day_count;
-	Tcl_GetLongFromObj (interp, objv[3], &day_count);
-	if (0 == day_count) {
+	if (TCL_OK != Tcl_GetLongFromObj (interp, objv[3], &day_count))
+		return TCL_ERROR;
+	if (day_count <= 0) {
 		Tcl_SetResult (interp, "dayCount must be greater than zero", TCL_STATIC);
 		return TCL_ERROR;
 	}
+	if (day_count > kMaximumQueryDayCount) {
+		Tcl_SetResult (interp, "dayCount too large", TCL_STATIC);
+		return TCL_ERROR;
+	}
 
-	bin_decl.bin_day_count = day_count;
+	bin_decl.bin_day_count = bin_decl.bin_analytic_day_count = day_count;
+	bin_decl.bin_windows.assign (kQueryWindows, kQueryWindows + _countof (kQueryWindows));
 	DVLOG(3) << "dayCount=" << bin_decl.bin_day_count;
 
 /* startTime, not converted by "clock scan" as we require time-of-day only */
@@ -233,7 +248,7 @@ gomi::gomi_t::TclGomiQuery (
 
 		int len = 0;
 		char* symbol_text = Tcl_GetStringFromObj (objPtr, &len);
-		auto bin = std::make_shared<bin_t> (bin_decl, symbol_text, kDefaultLastPriceField, kDefaultTickVolumeField);
+		auto bin = std::make_shared<bin_t> (bin_decl, symbol_text, trade_fields_.last_price.c_str(), trade_fields_.tick_volume.c_str());
 		assert ((bool)bin);
 		if (len > 0) {
 			query.push_back (bin);
@@ -248,19 +263,28 @@ gomi::gomi_t::TclGomiQuery (
 	using namespace boost::local_time;
 	const auto now_in_tz = local_sec_clock::local_time (bin_decl.bin_tz);
 	const auto today_in_tz = now_in_tz.local_time().date();
-	auto work_area = work_area_.get();
-	auto view_element = view_element_.get();	
-	std::for_each (query.begin(), query.end(), [today_in_tz, work_area, view_element](std::shared_ptr<bin_t>& it) {
-		it->Calculate (today_in_tz, work_area, view_element);
+	const scan_t scan (*GetCalendar (today_in_tz, bin_decl.bin_day_count), period_table_.get(), activity_index_.get(), today_in_tz, std::vector<bin_decl_t> (1, bin_decl));
+/* a fixed calendar file may not reach back far enough */
+	if (scan.GetDays().empty()) {
+		Tcl_SetResult (interp, "dayCount exceeds business day calendar", TCL_STATIC);
+		return TCL_ERROR;
+	}
+	pool_->ParallelFor (query.size(), [&](size_t i, tick_source_t* source) {
+		scan.Calculate (std::vector<bin_t*> (1, query[i].get()), source, intraday_index_.get());
+	});
+	std::vector<bin_t*> bins;
+	std::for_each (query.begin(), query.end(), [&bins](const std::shared_ptr<bin_t>& bin) {
+		bins.push_back (bin.get());
 	});
+	CollateBins (bins);
 	DVLOG(3) << "query complete, compiling result set.";
 
 /* Convert STL container result set into a new Tcl list. */
 	Tcl_Obj* resultListPtr = Tcl_NewListObj (0, NULL);
 	std::for_each (query.begin(), query.end(), [&](std::shared_ptr<bin_t>& it) {
-		const double tenday_pc_rounded     = portware::round (it->GetTenDayPercentageChange());
-		const double fifteenday_pc_rounded = portware::round (it->GetFifteenDayPercentageChange());
-		const double twentyday_pc_rounded  = portware::round (it->GetTwentyDayPercentageChange());
+		const double tenday_pc_rounded     = portware::round (it->GetDayPercentageChange (0));
+		const double fifteenday_pc_rounded = portware::round (it->GetDayPercentageChange (1));
+		const double twentyday_pc_rounded  = portware::round (it->GetDayPercentageChange (2));
 
 		Tcl_Obj* elemObjPtr[] = {
 			Tcl_NewStringObj (it->GetSymbolName(), -1),
@@ -394,13 +418,19 @@ gomi::gomi_t::TclFeedLogQuery (
 
 /* count of days for bin analytic */
 	long day_count = 0;
-	Tcl_GetLongFromObj (interp, objv[4], &day_count);
-	if (0 == day_count) {
+	if (TCL_OK != Tcl_GetLongFromObj (interp, objv[4], &day_count))
+		return TCL_ERROR;
+	if (day_count <= 0) {
 		Tcl_SetResult (interp, "dayCount must be greater than zero", TCL_STATIC);
 		return TCL_ERROR;
 	}
+	if (day_count > kMaximumQueryDayCount) {
+		Tcl_SetResult (interp, "dayCount too large", TCL_STATIC);
+		return TCL_ERROR;
+	}
 
-	bin_decl.bin_day_count = day_count;
+	bin_decl.bin_day_count = bin_decl.bin_analytic_day_count = day_count;
+	bin_decl.bin_windows.assign (kQueryWindows, kQueryWindows + _countof (kQueryWindows));
 	DLOG(INFO) << "dayCount=" << bin_decl.bin_day_count;
 
 /* startTime, not converted by "clock scan" as we require time-of-day only */
@@ -441,7 +471,7 @@ gomi::gomi_t::TclFeedLogQuery (
 
 		int len = 0;
 		char* symbol_text = Tcl_GetStringFromObj (objPtr, &len);
-		auto bin = std::make_shared<bin_t> (bin_decl, symbol_text, kDefaultLastPriceField, kDefaultTickVolumeField);
+		auto bin = std::make_shared<bin_t> (bin_decl, symbol_text, trade_fields_.last_price.c_str(), trade_fields_.tick_volume.c_str());
 		assert ((bool)bin);
 		if (len > 0) {
 			query.push_back (bin);
@@ -456,11 +486,20 @@ gomi::gomi_t::TclFeedLogQuery (
 	using namespace boost::local_time;
 	const auto now_in_tz = local_sec_clock::local_time (bin_decl.bin_tz);
 	const auto today_in_tz = now_in_tz.local_time().date();
-	auto work_area = work_area_.get();
-	auto view_element = view_element_.get();	
-	std::for_each (query.begin(), query.end(), [today_in_tz, work_area, view_element](std::shared_ptr<bin_t>& it) {
-		it->Calculate (today_in_tz, work_area, view_element);
+	const scan_t scan (*GetCalendar (today_in_tz, bin_decl.bin_day_count), period_table_.get(), activity_index_.get(), today_in_tz, std::vector<bin_decl_t> (1, bin_decl));
+/* a fixed calendar file may not reach back far enough */
+	if (scan.GetDays().empty()) {
+		Tcl_SetResult (interp, "dayCount exceeds business day calendar", TCL_STATIC);
+		return TCL_ERROR;
+	}
+	pool_->ParallelFor (query.size(), [&](size_t i, tick_source_t* source) {
+		scan.Calculate (std::vector<bin_t*> (1, query[i].get()), source, intraday_index_.get());
+	});
+	std::vector<bin_t*> bins;
+	std::for_each (query.begin(), query.end(), [&bins](const std::shared_ptr<bin_t>& bin) {
+		bins.push_back (bin.get());
 	});
+	CollateBins (bins);
 	DVLOG(3) << "query complete, compiling result set.";
 		
 /* create flexrecord for each result */
@@ -469,9 +508,9 @@ gomi::gomi_t::TclFeedLogQuery (
 		std::ostringstream symbol_name;
 		symbol_name << it->GetSymbolName() << config_.suffix;
 
-		const double tenday_pc_rounded     = portware::round (it->GetTenDayPercentageChange());
-		const double fifteenday_pc_rounded = portware::round (it->GetFifteenDayPercentageChange());
-		const double twentyday_pc_rounded  = portware::round (it->GetTwentyDayPercentageChange());
+		const double tenday_pc_rounded     = portware::round (it->GetDayPercentageChange (0));
+		const double fifteenday_pc_rounded = portware::round (it->GetDayPercentageChange (1));
+		const double twentyday_pc_rounded  = portware::round (it->GetDayPercentageChange (2));
 
 /* TODO: timestamp from end of last bin */
 		__time32_t timestamp = 0;
@@ -551,6 +590,8 @@ gomi::gomi_t::TclRepublishLastBinQuery (
 
 	try {
 		last_refresh_ = boost::posix_time::not_a_date_time;
+/* republish full images, an unchanged bin yields no updates */
+		provider_->ResetImages();
 		TimeRefresh();
 	} catch (rfa::common::InvalidUsageException& e) {
 		LOG(ERROR) << "InvalidUsageException: { "
@@ -593,4 +634,93 @@ gomi::gomi_t::TclRecalculateQuery (
 	return TCL_OK;
 }
 
+/* gomi_invalidate <symbol-list> <date> [<startTime> <endTime>]
+ *
+ * Recalculate and republish the analytics of symbols with late or corrected
+ * trades on a business day, optionally limited to a time period in the
+ * configured time zone.
+ *
+ * example:
+ *	gomi_invalidate [TIBX.O, NKE.N] "2012-07-20" "09:30" "09:40"
+ */
+int
+gomi::gomi_t::TclInvalidateQuery (
+	const vpf::CommandInfo& cmdInfo,
+	vpf::TCLCommandData& cmdData
+	)
+{
+	TCLLibPtrs* tclStubsPtr = reinterpret_cast<TCLLibPtrs*> (cmdData.mClientData);
+	Tcl_Interp* interp = cmdData.mInterp;		/* Current interpreter. */
+	int objc = cmdData.mObjc;			/* Number of arguments. */
+	Tcl_Obj** CONST objv = cmdData.mObjv;		/* Argument strings. */
+
+	if (objc != 3 && objc != 5) {
+		Tcl_WrongNumArgs (interp, 1, objv, "symbolList date ?startTime endTime?");
+		return TCL_ERROR;
+	}
+
+/* date, ISO 8601 extended format */
+	int len = 0;
+	const std::string date_str (Tcl_GetStringFromObj (objv[2], &len));
+	const boost::gregorian::date date (boost::gregorian::from_simple_string (date_str));
+	if (date.is_special()) {
+		Tcl_SetResult (interp, "bad date", TCL_STATIC);
+		return TCL_ERROR;
+	}
+
+/* whole day unless a time period is provided */
+	boost::posix_time::time_duration start_time (boost::posix_time::hours (0));
+	boost::posix_time::time_duration end_time (boost::posix_time::hours (24));
+	if (5 == objc) {
+		const std::string start_time_str (Tcl_GetStringFromObj (objv[3], &len));
+		start_time = boost::posix_time::duration_from_string (start_time_str);
+		const std::string end_time_str (Tcl_GetStringFromObj (objv[4], &len));
+		end_time = boost::posix_time::duration_from_string (end_time_str);
+		if (end_time <= start_time) {
+			Tcl_SetResult (interp, "endTime must be after startTime", TCL_STATIC);
+			return TCL_ERROR;
+		}
+	}
+
+/* symbolList must be a list object. */
+	int listLen, result = Tcl_ListObjLength (interp, objv[1], &listLen);
+	if (TCL_OK != result)
+		return result;
+	if (0 == listLen) {
+		Tcl_SetResult (interp, "bad symbolList", TCL_STATIC);
+		return TCL_ERROR;
+	}
+	std::vector<std::string> symbols;
+	for (int i = 0; i < listLen; i++)
+	{
+		Tcl_Obj* objPtr = nullptr;
+		Tcl_ListObjIndex (interp, objv[1], i, &objPtr);
+		const char* symbol_text = Tcl_GetStringFromObj (objPtr, &len);
+		if (0 == len) {
+			Tcl_SetResult (interp, "bad symbolList", TCL_STATIC);
+			return TCL_ERROR;
+		}
+		symbols.push_back (symbol_text);
+	}
+
+/* Refresh already running.  Note locking is handled outside query to enable
+ * feedback to Tcl interface.
+ */
+	boost::unique_lock<boost::shared_mutex> lock (query_mutex_, boost::try_to_lock_t());
+	if (!lock.owns_lock()) {
+		Tcl_SetResult (interp, "query already running", TCL_STATIC);
+		return TCL_ERROR;
+	}
+
+	try {
+		Invalidate (symbols, date, start_time, end_time);
+	} catch (rfa::common::InvalidUsageException& e) {
+		LOG(ERROR) << "InvalidUsageException: { "
+			"Severity: \"" << severity_string (e.getSeverity()) << "\""
+			", Classification: \"" << classification_string (e.getClassification()) << "\""
+			", StatusText: \"" << e.getStatus().getStatusText() << "\" }";
+	}
+	return TCL_OK;
+}
+
 /* eof */
\ No newline at end of file
@@ -0,0 +1,363 @@
+/* Trade tick sources for bar calculation.
+ */
+
+#include "tick_source.hh"
+
+#include <set>
+#include <string>
+#include <unordered_map>
+
+/* Velocity Analytics Plugin Framework */
+#include <FlexRecReader.h>
+
+#include "chromium/logging.hh"
+
+/* Flex Record Trade identifier. */
+static const uint32_t kTradeId = 40001;
+
+/* Flex Record name for trades, also the name of the full view */
+static const char* kTradeRecord = "Trade";
+
+/* Name */
+static const char* kTimeStampField = "TimeStamp";
+
+/* Index within any Trade view */
+static const int kFRTimeStamp  = 0;	/* fixed field: server receipt time */
+
+/* http://xorshift.di.unimi.it/splitmix64.c */
+static
+uint64_t
+splitmix64 (
+	uint64_t x
+	)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+/* FlexRecord Primitives callback closure.
+ */
+namespace
+{
+/* position of field /name/ within a view, -1 if not present */
+	template <typename View>
+	int
+	find_field (
+		const View& view,
+		const std::string& name
+		)
+	{
+		for (size_t k = 0; k < view.size(); ++k)
+			if (name == view[k].name)
+				return (int)k;
+		return -1;
+	}
+
+	struct flexrecord_state_t
+	{
+		gomi::tick_callback_t callback;
+		void* closure;
+/* end of time period, exclusive */
+		__time32_t till;
+/* view positions, Primitives only */
+		int last_price_index;
+		int tick_volume_index;
+/* callback halted the read */
+		bool is_halted;
+	};
+
+/* single symbol callback closure of a batch read */
+	struct batch_state_t
+	{
+		gomi::batch_tick_callback_t callback;
+		void* closure;
+		size_t symbol_index;
+	};
+
+	int
+	processBatchTick (
+		void* closure,
+		__time32_t timestamp,
+		double last_price,
+		uint64_t tick_volume
+		)
+	{
+		const auto& state = *static_cast<batch_state_t*> (closure);
+		return state.callback (state.closure, state.symbol_index, timestamp, last_price, tick_volume);
+	}
+
+/* single symbol closure of a cursor read */
+	int
+	processSymbolTick (
+		void* closure,
+		size_t symbol_index,
+		__time32_t timestamp,
+		double last_price,
+		uint64_t tick_volume
+		)
+	{
+		const auto& state = *static_cast<flexrecord_state_t*> (closure);
+		return state.callback (state.closure, timestamp, last_price, tick_volume);
+	}
+}
+
+bool
+gomi::tick_source_t::ReadBatch (
+	const TBSymbolHandle* handles,
+	const char* const* symbol_names,
+	size_t symbol_count,
+	__time32_t from,
+	__time32_t till,
+	batch_tick_callback_t callback,
+	void* closure
+	)
+{
+	for (size_t i = 0; i < symbol_count; ++i) {
+		batch_state_t state = { callback, closure, i };
+		if (!Read (handles[i], symbol_names[i], from, till, processBatchTick, &state))
+			return false;
+	}
+	return true;
+}
+
+gomi::flexrecord_tick_source_t::flexrecord_tick_source_t (
+	FlexRecDefinitionManager* manager,
+	const std::string& view_name,
+	const trade_fields_t& fields
+	) :
+	manager_ (manager),
+	view_name_ (view_name),
+	fields_ (fields),
+	last_price_index_ (-1),
+	tick_volume_index_ (-1)
+{
+	CHECK(nullptr != manager_);
+}
+
+/* Returns true on success, false on failure.
+ */
+bool
+gomi::flexrecord_tick_source_t::Init()
+{
+	work_area_.reset (manager_->AcquireWorkArea(), [this](FlexRecWorkAreaElement* work_area){ manager_->ReleaseWorkArea (work_area); });
+	view_element_.reset (manager_->AcquireView(), [this](FlexRecViewElement* view_element){ manager_->ReleaseView (view_element); });
+
+	const char* view_name = view_name_.empty() ? kTradeRecord : view_name_.c_str();
+	if (!manager_->GetView (view_name, view_element_->view)) {
+		LOG(ERROR) << "FlexRecDefinitionManager::GetView failed for view \"" << view_name << "\"";
+		return false;
+	}
+
+/* positions of the trade fields as defined, not as assumed */
+	last_price_index_ = find_field (view_element_->view, fields_.last_price);
+	tick_volume_index_ = find_field (view_element_->view, fields_.tick_volume);
+	if (-1 == last_price_index_ || -1 == tick_volume_index_) {
+		LOG(ERROR) << "View \"" << view_name << "\" missing trade fields { "
+			"\"" << fields_.last_price << "\": " << last_price_index_ <<
+			", \"" << fields_.tick_volume << "\": " << tick_volume_index_ <<
+			" }";
+		return false;
+	}
+	return true;
+}
+
+bool
+gomi::flexrecord_tick_source_t::Read (
+	const TBSymbolHandle& handle,
+	const char* symbol_name,
+	__time32_t from,
+	__time32_t till,
+	tick_callback_t callback,
+	void* closure
+	)
+{
+	flexrecord_state_t state = { callback, closure, till, last_price_index_, tick_volume_index_, false };
+	try {
+		FlexRecPrimitives::GetFlexRecords (
+					handle,
+					const_cast<char*> (kTradeRecord),
+					from, till, 0 /* forward */,
+					0 /* no limit */,
+					view_element_->view,
+					work_area_->data,
+					processFlexRecord,
+					&state /* closure */
+						);
+	} catch (std::exception& e) {
+		LOG(ERROR) << "FlexRecPrimitives::GetFlexRecords raised exception " << e.what();
+		return false;
+	}
+	return !state.is_halted;
+}
+
+/* Extract a trade from the view.  The Primitives time range is not exclusive
+ * of /till/, the first trade at or after the end of the time period ends the
+ * read.
+ *
+ * Returns <1> to continue processing, <2> to halt processing due to an error
+ * or the end of the time period.
+ */
+int
+gomi::flexrecord_tick_source_t::processFlexRecord (
+	FRTreeCallbackInfo* info
+	)
+{
+	CHECK(nullptr != info->callersData);
+	auto& state = *static_cast<flexrecord_state_t*> (info->callersData);
+
+/* extract from view */
+	const __time32_t timestamp   = *static_cast<__time32_t*> (info->theView[kFRTimeStamp].data);
+	if (timestamp >= state.till)
+		return 2;
+	const double     last_price  = *static_cast<double*>     (info->theView[state.last_price_index].data);
+	const uint64_t   tick_volume = *static_cast<uint64_t*>   (info->theView[state.tick_volume_index].data);
+
+	const int status = state.callback (state.closure, timestamp, last_price, tick_volume);
+	if (1 != status)
+		state.is_halted = true;
+	return status;
+}
+
+gomi::flexrecord_cursor_tick_source_t::flexrecord_cursor_tick_source_t (
+	const trade_fields_t& fields
+	) :
+	fields_ (fields)
+{
+}
+
+bool
+gomi::flexrecord_cursor_tick_source_t::Read (
+	const TBSymbolHandle& handle,
+	const char* symbol_name,
+	__time32_t from,
+	__time32_t till,
+	tick_callback_t callback,
+	void* closure
+	)
+{
+	flexrecord_state_t state = { callback, closure, till, 0, 0, false };
+	return ReadBatch (&handle, &symbol_name, 1, from, till, processSymbolTick, &state);
+}
+
+/* One cursor over every symbol of the batch, rows are routed back to the
+ * requesting symbol by name.
+ *
+ * Returns false on error or when the callback halts, true on success.
+ */
+bool
+gomi::flexrecord_cursor_tick_source_t::ReadBatch (
+	const TBSymbolHandle* handles,
+	const char* const* symbol_names,
+	size_t symbol_count,
+	__time32_t from,
+	__time32_t till,
+	batch_tick_callback_t callback,
+	void* closure
+	)
+{
+	if (0 == symbol_count)
+		return true;
+
+/* Symbol names */
+	std::set<std::string> symbol_set;
+	std::unordered_map<std::string, size_t> symbol_index;
+	for (size_t i = 0; i < symbol_count; ++i) {
+		symbol_set.insert (symbol_names[i]);
+		symbol_index.insert (std::make_pair (std::string (symbol_names[i]), i));
+	}
+
+/* FlexRecord fields, only those of the analytics are copied */
+	__time32_t timestamp;
+	double   last_price;
+	uint64_t tick_volume;
+	std::set<FlexRecBinding> binding_set;
+	FlexRecBinding binding (kTradeId);
+	binding.Bind (kTimeStampField, &timestamp);
+	binding.Bind (fields_.last_price.c_str(), &last_price);
+	binding.Bind (fields_.tick_volume.c_str(), &tick_volume);
+	binding_set.insert (binding);
+
+/* Open cursor */
+	FlexRecReader fr;
+	try {
+		char error_text[1024];
+		const int cursor_status = fr.Open (symbol_set, binding_set, from, till, 0 /* forward */, 0 /* no limit */, error_text);
+		if (1 != cursor_status) {
+			LOG(ERROR) << "FlexRecReader::Open failed { \"code\": " << cursor_status
+				<< ", \"text\": \"" << error_text << "\" }";
+			return false;
+		}
+	} catch (std::exception& e) {
+/* typically out-of-memory exceptions due to insufficient virtual memory */
+		LOG(ERROR) << "FlexRecReader::Open raised exception " << e.what();
+		return false;
+	}
+
+/* iterate through all ticks, rows of one symbol are typically consecutive */
+	std::string last_symbol;
+	size_t i = 0;
+	bool is_halted = false;
+	while (!is_halted && fr.Next()) {
+/* time period is [from, till), rows of other symbols may follow */
+		if (timestamp >= till)
+			continue;
+/* FlexRecReader accessor not used by the baseline, unchecked against the SDK header */
+		const char* symbol_name = fr.GetCurrentSymbolName();
+		if (last_symbol != symbol_name) {
+			auto it = symbol_index.find (symbol_name);
+			if (symbol_index.end() == it)
+				continue;
+			last_symbol = symbol_name;
+			i = it->second;
+		}
+		is_halted = (1 != callback (closure, i, timestamp, last_price, tick_volume));
+	}
+
+/* Cleanup */
+	fr.Close();
+	return !is_halted;
+}
+
+gomi::synthetic_tick_source_t::synthetic_tick_source_t (
+	unsigned mean_interval
+	) :
+	mean_interval_ (mean_interval > 0 ? mean_interval : 1)
+{
+}
+
+/* Trades are a function of symbol name and second only so that any split of
+ * a time period into scans yields identical bars.
+ */
+bool
+gomi::synthetic_tick_source_t::Read (
+	const TBSymbolHandle& handle,
+	const char* symbol_name,
+	__time32_t from,
+	__time32_t till,
+	tick_callback_t callback,
+	void* closure
+	)
+{
+/* FNV-1a of symbol name */
+	uint64_t seed = 14695981039346656037ULL;
+	for (const char* p = symbol_name; '\0' != *p; ++p) {
+		seed ^= (uint8_t)*p;
+		seed *= 1099511628211ULL;
+	}
+	const double base_price = 10.0 + (double)(seed % 10000) / 100.0;
+
+	for (__time32_t t = from; t < till; ++t) {
+		const uint64_t h = splitmix64 (seed ^ (uint64_t)t);
+		if (0 != h % mean_interval_)
+			continue;
+		const double last_price = base_price + (double)((h >> 16) % 201) / 100.0 - 1.0;
+		const uint64_t tick_volume = 100 * (1 + ((h >> 32) % 50));
+		if (1 != callback (closure, t, last_price, tick_volume))
+			return false;
+	}
+	return true;
+}
+
+/* eof */
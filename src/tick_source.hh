@@ -0,0 +1,112 @@
+/* Trade tick sources for bar calculation.
+ *
+ * FlexRecord Primitives are not shareable between threads, each calculating
+ * thread owns a source with a private work area and view.
+ */
+
+#ifndef __TICK_SOURCE_HH__
+#define __TICK_SOURCE_HH__
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Velocity Analytics Plugin Framework */
+#include <vpf/vpf.h>
+#include <TBPrimitives.h>
+
+namespace gomi
+{
+/* Returns <1> to continue processing, <2> to halt processing, as FlexRecord Primitives. */
+	typedef int (*tick_callback_t) (void* closure, __time32_t timestamp, double last_price, uint64_t tick_volume);
+/* as above with index of symbol within the batch */
+	typedef int (*batch_tick_callback_t) (void* closure, size_t symbol_index, __time32_t timestamp, double last_price, uint64_t tick_volume);
+
+/* FlexRecord fields required by the configured analytics. */
+	struct trade_fields_t
+	{
+		std::string last_price;
+		std::string tick_volume;
+	};
+
+	class tick_source_t : boost::noncopyable
+	{
+	public:
+		virtual ~tick_source_t() {}
+
+/* deliver every trade of a symbol within [from, till) in time order, returns false on error or when /callback/ halts */
+		virtual bool Read (const TBSymbolHandle& handle, const char* symbol_name, __time32_t from, __time32_t till, tick_callback_t callback, void* closure) = 0;
+/* deliver every trade of /symbol_count/ symbols within [from, till), in time
+ * order per symbol, default is one Read per symbol.
+ */
+		virtual bool ReadBatch (const TBSymbolHandle* handles, const char* const* symbol_names, size_t symbol_count, __time32_t from, __time32_t till, batch_tick_callback_t callback, void* closure);
+	};
+
+/* Trades from the Analytics Engine database.
+ *
+ * The default Trade view materialises every field of the record for each
+ * row, a projected /view_name/ defined in the FlexRecord definitions holds
+ * only the trade fields.  Field positions are resolved by name at Init.
+ */
+	class flexrecord_tick_source_t : public tick_source_t
+	{
+	public:
+		flexrecord_tick_source_t (FlexRecDefinitionManager* manager, const std::string& view_name, const trade_fields_t& fields);
+
+		bool Init();
+		virtual bool Read (const TBSymbolHandle& handle, const char* symbol_name, __time32_t from, __time32_t till, tick_callback_t callback, void* closure) override;
+
+	private:
+		static int processFlexRecord (FRTreeCallbackInfo* info);
+
+		FlexRecDefinitionManager* manager_;
+		const std::string view_name_;
+		const trade_fields_t fields_;
+/* view positions of last price and tick volume, resolved by Init */
+		int last_price_index_, tick_volume_index_;
+		std::shared_ptr<FlexRecWorkAreaElement> work_area_;
+		std::shared_ptr<FlexRecViewElement> view_element_;
+	};
+
+/* Trades from the Analytics Engine database through the FlexRecord Cursor
+ * API.  Opening a cursor is expensive, ~250ms, and closing ~150ms, a batch
+ * of symbols over the full analytic period shares one cursor.
+ */
+	class flexrecord_cursor_tick_source_t : public tick_source_t
+	{
+	public:
+		explicit flexrecord_cursor_tick_source_t (const trade_fields_t& fields);
+
+		virtual bool Read (const TBSymbolHandle& handle, const char* symbol_name, __time32_t from, __time32_t till, tick_callback_t callback, void* closure) override;
+		virtual bool ReadBatch (const TBSymbolHandle* handles, const char* const* symbol_names, size_t symbol_count, __time32_t from, __time32_t till, batch_tick_callback_t callback, void* closure) override;
+
+	private:
+		const trade_fields_t fields_;
+	};
+
+/* Deterministic pseudo-random trades, a stand-in for testing without a
+ * populated database.  Each symbol trades on average once every
+ * /mean_interval/ seconds, the same second always yields the same trade.
+ */
+	class synthetic_tick_source_t : public tick_source_t
+	{
+	public:
+		explicit synthetic_tick_source_t (unsigned mean_interval);
+
+		virtual bool Read (const TBSymbolHandle& handle, const char* symbol_name, __time32_t from, __time32_t till, tick_callback_t callback, void* closure) override;
+
+	private:
+		const unsigned mean_interval_;
+	};
+
+} /* namespace gomi */
+
+#endif /* __TICK_SOURCE_HH__ */
+
+/* eof */
@@ -0,0 +1,155 @@
+/* Tick source unit test with the synthetic source, runs without the
+ * Analytics Engine database.
+ *
+ * Returns zero on success, non-zero with each failure logged to stderr.
+ */
+
+#include "tick_source.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "unittest.hh"
+
+static const __time32_t kFrom = 1331280000;	/* 2012/03/09 08:00 UTC */
+static const __time32_t kTill = kFrom + 60 * 60;
+
+namespace
+{
+	struct tick_t
+	{
+		size_t symbol_index;
+		__time32_t timestamp;
+		double last_price;
+		uint64_t tick_volume;
+
+		bool operator== (const tick_t& rhs) const {
+			return symbol_index == rhs.symbol_index &&
+			       timestamp == rhs.timestamp &&
+			       last_price == rhs.last_price &&
+			       tick_volume == rhs.tick_volume;
+		}
+	};
+
+	struct closure_t
+	{
+		std::vector<tick_t> ticks;
+		size_t symbol_index;
+		size_t limit;
+	};
+
+	int
+	processTick (
+		void* closure,
+		__time32_t timestamp,
+		double last_price,
+		uint64_t tick_volume
+		)
+	{
+		auto& state = *static_cast<closure_t*> (closure);
+		const tick_t tick = { state.symbol_index, timestamp, last_price, tick_volume };
+		state.ticks.push_back (tick);
+		return state.ticks.size() < state.limit ? 1 : 2;
+	}
+
+	int
+	processBatchTick (
+		void* closure,
+		size_t symbol_index,
+		__time32_t timestamp,
+		double last_price,
+		uint64_t tick_volume
+		)
+	{
+		auto& state = *static_cast<closure_t*> (closure);
+		const tick_t tick = { symbol_index, timestamp, last_price, tick_volume };
+		state.ticks.push_back (tick);
+		return 1;
+	}
+}
+
+static
+std::vector<tick_t>
+read (
+	gomi::tick_source_t* source,
+	const char* symbol_name,
+	size_t symbol_index,
+	__time32_t from,
+	__time32_t till,
+	size_t limit = (size_t)-1
+	)
+{
+	closure_t state;
+	state.symbol_index = symbol_index;
+	state.limit = limit;
+	const TBSymbolHandle handle = TBSymbolHandle();
+	const bool is_ok = source->Read (handle, symbol_name, from, till, processTick, &state);
+/* a halting callback fails the read */
+	EXPECT(is_ok == (state.ticks.size() < limit));
+	return state.ticks;
+}
+
+/* Trades lie within [from, till) in time order, any split of a time period
+ * yields the same trades, and a halting callback ends the read.
+ */
+static
+void
+test_read()
+{
+	gomi::synthetic_tick_source_t source (5);
+	const auto ticks = read (&source, "A.N", 0, kFrom, kTill);
+	EXPECT(!ticks.empty());
+	for (size_t i = 0; i < ticks.size(); ++i) {
+		EXPECT(ticks[i].timestamp >= kFrom && ticks[i].timestamp < kTill);
+		if (i > 0)
+			EXPECT(ticks[i - 1].timestamp <= ticks[i].timestamp);
+	}
+
+	const __time32_t middle = kFrom + 17 * 60 + 13;
+	auto split = read (&source, "A.N", 0, kFrom, middle);
+	const auto tail = read (&source, "A.N", 0, middle, kTill);
+	split.insert (split.end(), tail.begin(), tail.end());
+	EXPECT(ticks == split);
+
+	EXPECT(read (&source, "A.N", 0, kFrom, kFrom).empty());
+	EXPECT(3 == read (&source, "A.N", 0, kFrom, kTill, 3).size());
+}
+
+/* The default batch read matches one read per symbol with each trade
+ * routed to the index of its symbol.
+ */
+static
+void
+test_read_batch()
+{
+	gomi::synthetic_tick_source_t source (5);
+	const char* symbol_names[] = { "A.N", "B.N", "C.N" };
+	const size_t symbol_count = sizeof (symbol_names) / sizeof (symbol_names[0]);
+	std::vector<TBSymbolHandle> handles (symbol_count);
+	closure_t batch;
+	batch.symbol_index = 0;
+	batch.limit = (size_t)-1;
+	EXPECT(source.ReadBatch (handles.data(), symbol_names, symbol_count, kFrom, kTill, processBatchTick, &batch));
+
+	std::vector<tick_t> expected;
+	for (size_t i = 0; i < symbol_count; ++i) {
+		const auto ticks = read (&source, symbol_names[i], i, kFrom, kTill);
+		EXPECT(!ticks.empty());
+		expected.insert (expected.end(), ticks.begin(), ticks.end());
+	}
+	EXPECT(expected == batch.ticks);
+}
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	test_read();
+	test_read_batch();
+	return unittest::Result();
+}
+
+/* eof */
@@ -0,0 +1,65 @@
+/* Streaming ingestion of the current day's trades.
+ */
+
+#include "tick_stream.hh"
+
+#include <algorithm>
+
+/* Boost threading. */
+#include <boost/thread.hpp>
+
+#include "chromium/logging.hh"
+
+gomi::tick_stream_t::tick_stream_t (
+	std::shared_ptr<tick_source_t> source,
+	intraday_index_t* index,
+	const std::vector<std::string>& symbols,
+	const boost::local_time::time_zone_ptr& tz,
+	unsigned interval
+	) :
+	source_ (source),
+	index_ (index),
+	symbols_ (symbols),
+	tz_ (tz),
+	interval_ (interval),
+	poll_count_ (0)
+{
+	handles_.reserve (symbols_.size());
+	std::for_each (symbols_.begin(), symbols_.end(), [this](const std::string& symbol) {
+		handles_.push_back (TBPrimitives::GetSymbolHandle (symbol.c_str(), 1));
+	});
+}
+
+void
+gomi::tick_stream_t::Run()
+{
+	LOG(INFO) << "Tick stream started, " << symbols_.size() << " symbols every " << interval_ << " seconds.";
+	try {
+		while (true) {
+			boost::this_thread::sleep (boost::posix_time::seconds (interval_));
+			using namespace boost::local_time;
+			const auto now_in_tz = local_sec_clock::local_time (tz_);
+			Poll (now_in_tz.local_time().date());
+		}
+	} catch (boost::thread_interrupted&) {
+		LOG(INFO) << "Tick stream stopped after " << poll_count_ << " polls.";
+	}
+}
+
+bool
+gomi::tick_stream_t::Poll (
+	const boost::gregorian::date& date
+	)
+{
+	bool is_ok = true;
+	for (size_t i = 0; i < symbols_.size(); ++i) {
+		boost::this_thread::interruption_point();
+		if (!index_->Extend (handles_[i], symbols_[i].c_str(), date, tz_, source_.get()))
+			is_ok = false;
+	}
+	++poll_count_;
+	DVLOG(3) << "tick stream poll " << poll_count_ << (is_ok ? " complete." : " incomplete.");
+	return is_ok;
+}
+
+/* eof */
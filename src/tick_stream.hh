@@ -0,0 +1,59 @@
+/* Streaming ingestion of the current day's trades.
+ *
+ * Trades of every published symbol are folded into the intraday index as
+ * they arrive so that a bin close only reads the trades of the last minutes.
+ * Velocity Analytics offers no trade subscription to plugins, the realtime
+ * database is tailed through a private tick source each interval instead.
+ */
+
+#ifndef __TICK_STREAM_HH__
+#define __TICK_STREAM_HH__
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Boost Date Time */
+#include <boost/date_time/local_time/local_time.hpp>
+
+/* Velocity Analytics Plugin Framework */
+#include <vpf/vpf.h>
+#include <TBPrimitives.h>
+
+#include "intraday_index.hh"
+#include "tick_source.hh"
+
+namespace gomi
+{
+	class tick_stream_t : boost::noncopyable
+	{
+	public:
+		tick_stream_t (std::shared_ptr<tick_source_t> source, intraday_index_t* index, const std::vector<std::string>& symbols, const boost::local_time::time_zone_ptr& tz, unsigned interval);
+
+/* thread entry, returns on thread interruption */
+		void Run();
+/* index trades of every symbol on /date/ up to now, returns false on error */
+		bool Poll (const boost::gregorian::date& date);
+
+		uint64_t GetPollCount() const { return poll_count_; }
+
+	private:
+		std::shared_ptr<tick_source_t> source_;
+		intraday_index_t* index_;
+		const std::vector<std::string> symbols_;
+		std::vector<TBSymbolHandle> handles_;
+		const boost::local_time::time_zone_ptr tz_;
+		const unsigned interval_;
+		uint64_t poll_count_;
+	};
+
+} /* namespace gomi */
+
+#endif /* __TICK_STREAM_HH__ */
+
+/* eof */
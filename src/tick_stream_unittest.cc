@@ -0,0 +1,202 @@
+/* Tick stream unit test with the synthetic tick source, runs without the
+ * Analytics Engine database.
+ *
+ * Returns zero on success, non-zero with each failure logged to stderr.
+ */
+
+#include "tick_stream.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "calendar.hh"
+#include "gomi_scan.hh"
+#include "intraday_index.hh"
+#include "period_table.hh"
+#include "unittest.hh"
+
+static const char* kPath = "tick_stream_unittest.txt";
+
+static const __time32_t kFrom = 1331251200;	/* 2012/03/09 00:00 UTC */
+
+/* Mean seconds between synthetic trades. */
+static const unsigned kTickInterval = 20;
+
+namespace
+{
+	int
+	processTick (
+		void* closure,
+		__time32_t timestamp,
+		double last_price,
+		uint64_t tick_volume
+		)
+	{
+		static_cast<gomi::bar_t*> (closure)->Accumulate (last_price, tick_volume);
+		return 1;
+	}
+
+	int
+	processIndexTick (
+		void* closure,
+		__time32_t timestamp,
+		double last_price,
+		uint64_t tick_volume
+		)
+	{
+		static_cast<gomi::intraday_day_t*> (closure)->Absorb (timestamp, last_price, tick_volume);
+		return 1;
+	}
+}
+
+/* Bar of a full read of [from, till). */
+static
+gomi::bar_t
+scan (
+	gomi::tick_source_t* source,
+	const char* symbol_name,
+	__time32_t from,
+	__time32_t till
+	)
+{
+	gomi::bar_t bar;
+	EXPECT(source->Read (TBSymbolHandle(), symbol_name, from, till, processTick, &bar));
+	return bar;
+}
+
+static
+bool
+is_same_bar (
+	gomi::bar_t lhs,
+	gomi::bar_t rhs
+	)
+{
+	return lhs.GetNumberMoves() == rhs.GetNumberMoves() &&
+	       lhs.GetAccumulatedVolume() == rhs.GetAccumulatedVolume() &&
+	       lhs.GetOpenPrice() == rhs.GetOpenPrice() &&
+	       lhs.GetClosePrice() == rhs.GetClosePrice();
+}
+
+/* A day sealed in uneven steps as by successive polls answers every minute
+ * aligned window up to the sealed period as a full read of the trades does.
+ */
+static
+void
+test_incremental()
+{
+	gomi::synthetic_tick_source_t source (kTickInterval);
+	gomi::intraday_day_t day (kFrom, kFrom + 24 * 60 * 60);
+	const unsigned steps[] = { 1, 7, 8, 60, 61, 180, 181, 600, 1439, 1440 };
+	const unsigned minutes[] = { 0, 1, 5, 7, 30, 59, 60, 120, 179, 181, 500, 1000, 1438, 1440 };
+	for (size_t s = 0; s < sizeof (steps) / sizeof (steps[0]); ++s) {
+		const __time32_t till = kFrom + 60 * steps[s];
+		EXPECT(source.Read (TBSymbolHandle(), "A.N", day.GetSealed(), till, processIndexTick, &day));
+		day.Seal (till);
+		EXPECT(till == day.GetSealed());
+		for (size_t i = 0; i < sizeof (minutes) / sizeof (minutes[0]); ++i) {
+			for (size_t j = i + 1; j < sizeof (minutes) / sizeof (minutes[0]); ++j) {
+				const gomi::time_window_t window (kFrom + 60 * minutes[i], kFrom + 60 * minutes[j]);
+				gomi::bar_t bar;
+				__time32_t answered;
+				const bool is_indexed = day.Get (window, &bar, &answered);
+/* only windows starting within the sealed period */
+				EXPECT(is_indexed == (window.first < till));
+				if (!is_indexed)
+					continue;
+				EXPECT(answered == std::min (window.second, till));
+				EXPECT(is_same_bar (scan (&source, "A.N", window.first, answered), bar));
+			}
+		}
+	}
+
+/* not minute aligned */
+	gomi::bar_t bar;
+	__time32_t answered;
+	EXPECT(!day.Get (gomi::time_window_t (kFrom + 30, kFrom + 120), &bar, &answered));
+	EXPECT(!day.Get (gomi::time_window_t (kFrom, kFrom + 90), &bar, &answered));
+}
+
+/* Trades polled into the intraday index answer today's bars of a scan, the
+ * day bars are the same as a scan reading every trade.
+ */
+static
+void
+test_poll()
+{
+	using namespace boost::posix_time;
+	using boost::gregorian::date;
+	using boost::gregorian::days;
+	const ptime now (second_clock::universal_time());
+	const time_duration tod (now.time_of_day());
+/* a closed minute aligned time period of today */
+	if (tod < minutes (10)) {
+		fprintf (stderr, "poll test skipped at midnight.\n");
+		return;
+	}
+	const date today (now.date());
+	FILE* fp = fopen (kPath, "w");
+	EXPECT(nullptr != fp);
+	if (nullptr == fp)
+		return;
+	fprintf (fp, "%s\n%s\n", to_iso_extended_string (today - days (1)).c_str(), to_iso_extended_string (today).c_str());
+	fclose (fp);
+	gomi::calendar_t calendar;
+	EXPECT(calendar.LoadFile (kPath));
+	remove (kPath);
+
+	const boost::local_time::time_zone_ptr tz (new boost::local_time::posix_time_zone ("UTC0"));
+	gomi::bin_decl_t bin_decl;
+	bin_decl.bin_name = "closed";
+	bin_decl.bin_start = hours (tod.hours() > 2 ? tod.hours() - 2 : 0);
+	bin_decl.bin_end = hours (tod.hours()) + minutes (tod.minutes() - 5);
+	bin_decl.bin_tz = tz;
+	bin_decl.bin_day_count = 2;
+	bin_decl.bin_analytic_day_count = 2;
+	bin_decl.bin_windows.push_back (2);
+	const std::vector<gomi::bin_decl_t> bin_decls (1, bin_decl);
+
+	std::vector<std::string> symbols;
+	symbols.push_back ("A.N");
+	symbols.push_back ("B.N");
+	auto source = std::make_shared<gomi::synthetic_tick_source_t> (kTickInterval);
+	gomi::intraday_index_t index (symbols.size());
+	gomi::tick_stream_t stream (source, &index, symbols, tz, 60);
+	EXPECT(stream.Poll (today));
+	EXPECT(stream.Poll (today));
+	EXPECT(2 == stream.GetPollCount());
+	EXPECT(symbols.size() == index.GetSymbolCount());
+
+	gomi::period_table_t period_table;
+	const gomi::scan_t scan (calendar, &period_table, nullptr, today, bin_decls);
+	for (size_t j = 0; j < symbols.size(); ++j) {
+		gomi::bin_t indexed (bin_decl, symbols[j].c_str(), "LastPrice", "TickVolume");
+		gomi::bin_t full (bin_decl, symbols[j].c_str(), "LastPrice", "TickVolume");
+		std::vector<gomi::bin_t*> indexed_bins (1, &indexed), full_bins (1, &full);
+		gomi::scan_stats_t indexed_stats = { 0, 0, 0 }, full_stats = { 0, 0, 0 };
+		EXPECT(scan.Calculate (indexed_bins, source.get(), &index, &indexed_stats));
+		EXPECT(scan.Calculate (full_bins, source.get(), nullptr, &full_stats));
+/* only the previous business day is read */
+		EXPECT(1 == indexed_stats.reads);
+		EXPECT(2 == full_stats.reads);
+		EXPECT(indexed_stats.rows < full_stats.rows);
+		for (unsigned t = 0; t < bin_decl.bin_day_count; ++t) {
+			EXPECT(indexed.GetBar (t).IsFinal());
+			EXPECT(is_same_bar (indexed.GetBar (t), full.GetBar (t)));
+		}
+	}
+}
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	test_incremental();
+	test_poll();
+	return unittest::Result();
+}
+
+/* eof */
@@ -0,0 +1,71 @@
+/* Token bucket rate limiter.
+ *
+ * Tokens accrue at a fixed rate up to the bucket capacity, a burst of up to
+ * capacity tokens passes immediately and anything further is paced at the
+ * rate.  A request larger than the capacity passes once the bucket is full.
+ */
+
+#ifndef __TOKEN_BUCKET_HH__
+#define __TOKEN_BUCKET_HH__
+#pragma once
+
+#include <algorithm>
+
+/* Boost Posix Time */
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace gomi
+{
+	class token_bucket_t
+	{
+	public:
+		token_bucket_t() :
+			rate_ (0.0),
+			capacity_ (0.0),
+			tokens_ (0.0)
+		{
+		}
+
+/* /rate/ tokens per second, zero for unlimited */
+		void Reset (double rate, double capacity) {
+			rate_ = rate;
+			capacity_ = std::max (1.0, capacity);
+			tokens_ = capacity_;
+			last_refill_ = boost::posix_time::microsec_clock::universal_time();
+		}
+
+/* seconds until /tokens/ are available at /now/ */
+		double GetWait (double tokens, const boost::posix_time::ptime& now) {
+			if (rate_ <= 0.0)
+				return 0.0;
+			Refill (now);
+			const double deficit = std::min (tokens, capacity_) - tokens_;
+			return (deficit > 0.0) ? deficit / rate_ : 0.0;
+		}
+
+/* may run into debt for requests larger than the capacity */
+		void Consume (double tokens) {
+			if (rate_ > 0.0)
+				tokens_ -= tokens;
+		}
+
+	private:
+		void Refill (const boost::posix_time::ptime& now) {
+			const double elapsed = (now - last_refill_).total_microseconds() / 1000000.0;
+			if (elapsed <= 0.0)
+				return;
+			tokens_ = std::min (capacity_, tokens_ + elapsed * rate_);
+			last_refill_ = now;
+		}
+
+		double rate_;
+		double capacity_;
+		double tokens_;
+		boost::posix_time::ptime last_refill_;
+	};
+
+} /* namespace gomi */
+
+#endif /* __TOKEN_BUCKET_HH__ */
+
+/* eof */
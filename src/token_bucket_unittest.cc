@@ -0,0 +1,94 @@
+/* Token bucket unit test of burst, refill and debt.
+ *
+ * Returns zero on success, non-zero with each failure logged to stderr.
+ */
+
+#include "token_bucket.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "unittest.hh"
+
+/* within a millisecond, the bucket starts its clock at Reset() */
+static
+bool
+is_near (
+	double expected,
+	double actual
+	)
+{
+	return std::fabs (actual - expected) < 1e-3;
+}
+
+static
+void
+test_unlimited()
+{
+	gomi::token_bucket_t bucket;
+	const auto now = boost::posix_time::microsec_clock::universal_time();
+	EXPECT(0.0 == bucket.GetWait (1e9, now));
+	bucket.Reset (0.0, 10.0);
+	bucket.Consume (1e9);
+	EXPECT(0.0 == bucket.GetWait (1e9, now));
+}
+
+/* A full bucket passes a burst of capacity tokens, the next token waits one
+ * rate interval.
+ */
+static
+void
+test_burst()
+{
+	gomi::token_bucket_t bucket;
+	bucket.Reset (10.0, 5.0);
+	const auto now = boost::posix_time::microsec_clock::universal_time();
+	for (unsigned n = 0; n < 5; ++n) {
+		EXPECT(0.0 == bucket.GetWait (1.0, now));
+		bucket.Consume (1.0);
+	}
+	EXPECT(is_near (0.1, bucket.GetWait (1.0, now)));
+	EXPECT(is_near (0.3, bucket.GetWait (3.0, now)));
+}
+
+/* Tokens accrue at the rate up to the capacity, a request beyond the capacity
+ * passes on a full bucket and leaves a debt.
+ */
+static
+void
+test_refill()
+{
+	using boost::posix_time::milliseconds;
+	using boost::posix_time::seconds;
+	gomi::token_bucket_t bucket;
+	bucket.Reset (10.0, 5.0);
+	const auto now = boost::posix_time::microsec_clock::universal_time();
+	bucket.Consume (5.0);
+	EXPECT(is_near (0.0, bucket.GetWait (3.0, now + milliseconds (300))));
+	EXPECT(is_near (0.1, bucket.GetWait (4.0, now + milliseconds (300))));
+/* an earlier time adds no tokens */
+	EXPECT(is_near (0.1, bucket.GetWait (4.0, now)));
+
+/* capped at capacity */
+	EXPECT(0.0 == bucket.GetWait (5.0, now + seconds (100)));
+	EXPECT(0.0 == bucket.GetWait (8.0, now + seconds (100)));
+	bucket.Consume (8.0);
+	EXPECT(is_near (0.4, bucket.GetWait (1.0, now + seconds (100))));
+	EXPECT(is_near (0.8, bucket.GetWait (5.0, now + seconds (100))));
+	EXPECT(is_near (0.0, bucket.GetWait (1.0, now + seconds (100) + milliseconds (400))));
+}
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	test_unlimited();
+	test_burst();
+	test_refill();
+	return unittest::Result();
+}
+
+/* eof */
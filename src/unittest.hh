@@ -0,0 +1,49 @@
+/* Minimal unit test support shared by the *_unittest executables.
+ *
+ * Each test is a plain executable registered with CTest, failures are
+ * logged to stderr and counted, main returns unittest::Result().
+ */
+
+#ifndef __UNITTEST_HH__
+#define __UNITTEST_HH__
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace unittest
+{
+/* failed expectations of this executable */
+	inline
+	unsigned&
+	Failures()
+	{
+		static unsigned failures = 0;
+		return failures;
+	}
+
+/* process exit code */
+	inline
+	int
+	Result()
+	{
+		if (Failures() > 0) {
+			fprintf (stderr, "%u failures.\n", Failures());
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+
+} /* namespace unittest */
+
+#define EXPECT(condition) \
+	do { \
+		if (!(condition)) { \
+			fprintf (stderr, "%s(%d): expected %s\n", __FILE__, __LINE__, #condition); \
+			++unittest::Failures(); \
+		} \
+	} while (0)
+
+#endif /* __UNITTEST_HH__ */
+
+/* eof */
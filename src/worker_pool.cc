@@ -0,0 +1,141 @@
+/* Fixed pool of calculation threads, each owning a tick source.
+ */
+
+#include "worker_pool.hh"
+
+#include <algorithm>
+
+#include "chromium/logging.hh"
+
+/* chunks per worker per call, smaller chunks balance better at higher locking cost */
+static const size_t kChunksPerWorker = 8;
+
+gomi::worker_pool_t::worker_pool_t (
+	const std::vector<std::shared_ptr<tick_source_t>>& sources
+	) :
+	sources_ (sources),
+	task_ (nullptr),
+	count_ (0),
+	next_ (0),
+	chunk_ (1),
+	busy_ (0),
+	waiting_ (0),
+	generation_ (0),
+	is_shutdown_ (false)
+{
+	CHECK(!sources_.empty());
+	if (sources_.size() > 1) {
+/* workers start from the initial generation, not whichever they first observe */
+		const uint64_t generation = generation_;
+		std::for_each (sources_.begin(), sources_.end(), [this, generation](const std::shared_ptr<tick_source_t>& source) {
+			tick_source_t* p = source.get();
+			threads_.create_thread ([this, p, generation](){ Run (p, generation); });
+		});
+	}
+	LOG(INFO) << "Worker pool: { \"workers\": " << sources_.size() << " }";
+}
+
+gomi::worker_pool_t::~worker_pool_t()
+{
+	{
+		boost::lock_guard<boost::mutex> lock (lock_);
+		is_shutdown_ = true;
+	}
+	work_cond_.notify_all();
+	threads_.join_all();
+}
+
+void
+gomi::worker_pool_t::ParallelFor (
+	size_t count,
+	const task_t& task
+	)
+{
+	if (0 == count)
+		return;
+	{
+		boost::lock_guard<boost::mutex> lock (lock_);
+		++waiting_;
+	}
+	boost::lock_guard<boost::mutex> call_lock (call_lock_);
+	{
+		boost::lock_guard<boost::mutex> lock (lock_);
+		--waiting_;
+	}
+
+/* no workers */
+	if (1 == sources_.size()) {
+		tick_source_t* source = sources_.front().get();
+		for (size_t i = 0; i < count; ++i)
+			task (i, source);
+		return;
+	}
+
+	boost::unique_lock<boost::mutex> lock (lock_);
+	task_ = &task;
+	count_ = count;
+	next_ = 0;
+	chunk_ = std::max<size_t> (1, count / (sources_.size() * kChunksPerWorker));
+	++generation_;
+	work_cond_.notify_all();
+	while (next_ < count_ || busy_ > 0)
+		done_cond_.wait (lock);
+	task_ = nullptr;
+	if (exception_) {
+		std::exception_ptr e;
+		std::swap (e, exception_);
+		lock.unlock();
+		std::rethrow_exception (e);
+	}
+}
+
+bool
+gomi::worker_pool_t::HasWaiting()
+{
+	boost::lock_guard<boost::mutex> lock (lock_);
+	return waiting_ > 0;
+}
+
+void
+gomi::worker_pool_t::Run (
+	tick_source_t* source,
+	uint64_t generation
+	)
+{
+	boost::unique_lock<boost::mutex> lock (lock_);
+	while (true) {
+		while (!is_shutdown_ && generation == generation_)
+			work_cond_.wait (lock);
+		if (is_shutdown_)
+			break;
+		generation = generation_;
+		++busy_;
+		while (next_ < count_) {
+			const size_t begin = next_;
+			const size_t end = std::min (count_, begin + chunk_);
+			next_ = end;
+			const task_t& task = *task_;
+			lock.unlock();
+			std::exception_ptr e;
+			for (size_t i = begin; i < end; ++i) {
+				try {
+					task (i, source);
+				} catch (...) {
+					e = std::current_exception();
+					break;
+				}
+			}
+			lock.lock();
+/* first exception is raised to the caller, remaining indices are abandoned */
+			if (e) {
+				if (!exception_)
+					exception_ = e;
+				next_ = count_;
+			}
+		}
+		if (0 == --busy_)
+			done_cond_.notify_all();
+	}
+}
+
+/* eof */
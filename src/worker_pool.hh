@@ -0,0 +1,65 @@
+/* Fixed pool of calculation threads, each owning a tick source.
+ */
+
+#ifndef __WORKER_POOL_HH__
+#define __WORKER_POOL_HH__
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/* Boost noncopyable base class. */
+#include <boost/utility.hpp>
+
+/* Boost threading. */
+#include <boost/thread.hpp>
+
+#include "tick_source.hh"
+
+namespace gomi
+{
+	class worker_pool_t : boost::noncopyable
+	{
+	public:
+		typedef std::function<void (size_t index, tick_source_t* source)> task_t;
+
+/* one worker per source, a single source runs tasks on the calling thread */
+		explicit worker_pool_t (const std::vector<std::shared_ptr<tick_source_t>>& sources);
+		~worker_pool_t();
+
+/* run /task/ for every index in [0, count) and wait for completion, indices
+ * are handed out in chunks to balance uneven symbol activity.  The first
+ * exception raised by a task stops further indices and is rethrown.
+ */
+		void ParallelFor (size_t count, const task_t& task);
+
+		size_t GetWorkerCount() const { return sources_.size(); }
+/* callers blocked behind a running ParallelFor, background work should yield */
+		bool HasWaiting();
+
+	private:
+		void Run (tick_source_t* source, uint64_t generation);
+
+		const std::vector<std::shared_ptr<tick_source_t>> sources_;
+		boost::thread_group threads_;
+/* one ParallelFor at a time, e.g. Tcl and timer threads */
+		boost::mutex call_lock_;
+		boost::mutex lock_;
+		boost::condition_variable work_cond_, done_cond_;
+		const task_t* task_;
+		size_t count_, next_, chunk_;
+		unsigned busy_;
+		unsigned waiting_;
+		uint64_t generation_;
+		std::exception_ptr exception_;
+		bool is_shutdown_;
+	};
+
+} /* namespace gomi */
+
+#endif /* __WORKER_POOL_HH__ */
+
+/* eof */
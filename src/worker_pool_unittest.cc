@@ -0,0 +1,127 @@
+/* Worker pool unit test, runs without the Analytics Engine database.
+ *
+ * Returns zero on success, non-zero with each failure logged to stderr.
+ */
+
+#include "worker_pool.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+/* Boost threading. */
+#include <boost/thread.hpp>
+
+#include "unittest.hh"
+
+static
+std::vector<std::shared_ptr<gomi::tick_source_t>>
+create_sources (
+	unsigned count
+	)
+{
+	std::vector<std::shared_ptr<gomi::tick_source_t>> sources;
+	for (unsigned i = 0; i < count; ++i)
+		sources.push_back (std::make_shared<gomi::synthetic_tick_source_t> (60));
+	return sources;
+}
+
+/* Every index is run exactly once, including a call made before the workers
+ * have started.
+ */
+static
+void
+test_every_index (
+	unsigned worker_count
+	)
+{
+	const size_t count = 1000;
+	for (unsigned round = 0; round < 100; ++round) {
+		gomi::worker_pool_t pool (create_sources (worker_count));
+		for (unsigned call = 0; call < 3; ++call) {
+			std::vector<unsigned> hits (count, 0);
+			pool.ParallelFor (count, [&hits](size_t i, gomi::tick_source_t* source) {
+				++hits[i];
+			});
+			for (size_t i = 0; i < count; ++i)
+				EXPECT(1 == hits[i]);
+		}
+	}
+}
+
+/* Each task runs with the source of its thread, a single source runs tasks on
+ * the calling thread.
+ */
+static
+void
+test_sources (
+	unsigned worker_count
+	)
+{
+	const auto sources = create_sources (worker_count);
+	gomi::worker_pool_t pool (sources);
+	const size_t count = 256;
+	std::vector<gomi::tick_source_t*> used (count, nullptr);
+	std::vector<boost::thread::id> ids (count);
+	pool.ParallelFor (count, [&](size_t i, gomi::tick_source_t* source) {
+		used[i] = source;
+		ids[i] = boost::this_thread::get_id();
+	});
+	for (size_t i = 0; i < count; ++i) {
+		bool is_known = false;
+		for (size_t j = 0; j < sources.size(); ++j)
+			is_known |= (sources[j].get() == used[i]);
+		EXPECT(is_known);
+		if (1 == worker_count)
+			EXPECT(boost::this_thread::get_id() == ids[i]);
+		else
+			EXPECT(boost::this_thread::get_id() != ids[i]);
+	}
+}
+
+/* The first task exception reaches the caller and the pool remains usable.
+ */
+static
+void
+test_exception (
+	unsigned worker_count
+	)
+{
+	gomi::worker_pool_t pool (create_sources (worker_count));
+	const size_t count = 1000;
+	bool is_raised = false;
+	try {
+		pool.ParallelFor (count, [](size_t i, gomi::tick_source_t* source) {
+			if (7 == i)
+				throw std::runtime_error ("task failed");
+		});
+	} catch (std::runtime_error&) {
+		is_raised = true;
+	}
+	EXPECT(is_raised);
+
+	std::vector<unsigned> hits (count, 0);
+	pool.ParallelFor (count, [&hits](size_t i, gomi::tick_source_t* source) {
+		++hits[i];
+	});
+	for (size_t i = 0; i < count; ++i)
+		EXPECT(1 == hits[i]);
+}
+
+int
+main (
+	int		argc,
+	char*		argv[]
+	)
+{
+	const unsigned worker_counts[] = { 1, 2, 4, 16 };
+	for (size_t k = 0; k < sizeof (worker_counts) / sizeof (worker_counts[0]); ++k) {
+		test_every_index (worker_counts[k]);
+		test_sources (worker_counts[k]);
+		test_exception (worker_counts[k]);
+	}
+	return unittest::Result();
+}
+
+/* eof */